@@ -0,0 +1,324 @@
+// getopt, clock_gettime and pthreads are POSIX, not plain C99
+#define _POSIX_C_SOURCE 200809L
+
+// Buffer manager microbenchmark: runs one access pattern against a pool
+// and prints a CSV line with throughput, hit ratio, I/O counts and latency
+// percentiles. See usage() for the options.
+
+#include "storage_mgr.h"
+#include "buffer_mgr.h"
+#include "dberror.h"
+#include "bench_perf.h"
+
+#include <math.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SCAN_LEN 32       // pages per scan in the mixed pattern
+#define SCAN_PERCENT 10   // share of mixed page accesses that belong to scans
+#define HOT_PERCENT 10    // share of the file that is the hot set ...
+#define HOT_ACCESS 90     // ... and the share of accesses that go to it
+
+typedef enum Pattern { PAT_UNIFORM, PAT_ZIPF, PAT_HOTSET, PAT_SCAN, PAT_MIXED } Pattern;
+
+static const char *patternNames[] = { "uniform", "zipf", "hotset", "scan", "mixed" };
+static const char *strategyNames[] = { "fifo", "lru", "clock", "lfu", "lru_k" };
+
+// Benchmark settings
+typedef struct BenchConfig {
+    Pattern pattern;
+    ReplacementStrategy strat;
+    int poolPages;
+    int filePages;
+    int threads;
+    long opsPerThread;
+    int writePercent;
+    double theta;          // zipf skew
+    unsigned long long seed;
+    int ioWorkers;
+    const char *fileName;
+    int logFile;           // log-structured page file (createLogPageFile)
+} BenchConfig;
+
+// Per-thread state and results
+typedef struct Worker {
+    BM_BufferPool *bm;
+    const BenchConfig *cfg;
+    unsigned long long rng;
+    long long *latency;    // nanoseconds of every page access
+    long ops;
+    long errors;
+    pthread_t thread;
+    int id;
+} Worker;
+
+// Precomputed constants of the zipf generator (Gray et al., "Quickly
+// Generating Billion-Record Synthetic Databases")
+static double zipfZetaN, zipfAlpha, zipfEta, zipfHalfPow;
+
+static long long nowNanos(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long) ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// xorshift64*: fast and identical on every platform, unlike rand_r
+static unsigned long long nextRandom(unsigned long long *state) {
+    unsigned long long x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return x * 2685821657736338717ULL;
+}
+
+// Uniform double in [0, 1)
+static double nextUnit(unsigned long long *state) {
+    return (nextRandom(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static void initZipf(int n, double theta) {
+    double zeta2 = 1.0 + pow(0.5, theta);
+    zipfZetaN = 0;
+    for (int i = 1; i <= n; i++) zipfZetaN += 1.0 / pow(i, theta);
+    zipfAlpha = 1.0 / (1.0 - theta);
+    zipfEta = (1.0 - pow(2.0 / n, 1.0 - theta)) / (1.0 - zeta2 / zipfZetaN);
+    zipfHalfPow = 1.0 + pow(0.5, theta);
+}
+
+// Zipf-distributed page; page 0 is the hottest
+static int nextZipf(unsigned long long *state, int n) {
+    double u = nextUnit(state);
+    double uz = u * zipfZetaN;
+    if (uz < 1.0) return 0;
+    if (uz < zipfHalfPow) return 1;
+    int page = (int) (n * pow(zipfEta * u - zipfEta + 1.0, zipfAlpha));
+    return page < n ? page : n - 1;
+}
+
+// Pin one page, optionally dirty it, unpin it; records the latency.
+// A failed pin still counts as an operation so the run terminates.
+static void accessPage(Worker *w, int page, unsigned long long *rng) {
+    BM_PageHandle h;
+    long long start = nowNanos();
+    if (pinPage(w->bm, &h, page) == RC_OK) {
+        if ((int) (nextRandom(rng) % 100) < w->cfg->writePercent) {
+            h.data[0]++;
+            markDirty(w->bm, &h);
+        }
+        unpinPage(w->bm, &h);
+    } else {
+        w->errors++;
+    }
+    w->latency[w->ops++] = nowNanos() - start;
+}
+
+static void *workerMain(void *arg) {
+    Worker *w = arg;
+    const BenchConfig *cfg = w->cfg;
+    int n = cfg->filePages;
+    // scans start at different offsets so threads don't share one cursor
+    int cursor = (int) ((long) n * w->id / cfg->threads);
+    double s = SCAN_PERCENT / 100.0;
+    double scanStart = s / (SCAN_LEN - s * SCAN_LEN + s);
+    while (w->ops < cfg->opsPerThread) {
+        int page;
+        switch (cfg->pattern) {
+        case PAT_UNIFORM:
+            page = (int) (nextRandom(&w->rng) % n);
+            break;
+        case PAT_ZIPF:
+            page = nextZipf(&w->rng, n);
+            break;
+        case PAT_HOTSET: {
+            int hot = n * HOT_PERCENT / 100 > 0 ? n * HOT_PERCENT / 100 : 1;
+            if ((int) (nextRandom(&w->rng) % 100) < HOT_ACCESS)
+                page = (int) (nextRandom(&w->rng) % hot);
+            else
+                page = hot + (int) (nextRandom(&w->rng) % (n - hot > 0 ? n - hot : 1));
+            if (page >= n) page = n - 1;
+            break;
+        }
+        case PAT_SCAN:
+            page = cursor;
+            cursor = (cursor + 1) % n;
+            break;
+        default:
+            // mixed: short scans polluting the pool between zipf lookups;
+            // a scan starts with probability q so that q * SCAN_LEN /
+            // (q * SCAN_LEN + 1 - q) of the accesses are scan pages
+            if (nextUnit(&w->rng) < scanStart) {
+                int first = (int) (nextRandom(&w->rng) % n);
+                for (int i = 0; i < SCAN_LEN && w->ops < cfg->opsPerThread; i++)
+                    accessPage(w, (first + i) % n, &w->rng);
+                continue;
+            }
+            page = nextZipf(&w->rng, n);
+            break;
+        }
+        accessPage(w, page, &w->rng);
+    }
+    return NULL;
+}
+
+static int compareLL(const void *a, const void *b) {
+    long long x = *(const long long *) a, y = *(const long long *) b;
+    return (x > y) - (x < y);
+}
+
+// Create the page file with filePages pages
+static RC createBenchFile(const BenchConfig *cfg) {
+    SM_FileHandle fh;
+    RC rc = cfg->logFile ? createLogPageFile((char *) cfg->fileName, 0)
+                         : createPageFile((char *) cfg->fileName);
+    if (rc == RC_OK) rc = openPageFile((char *) cfg->fileName, &fh);
+    if (rc != RC_OK) return rc;
+    setPageFileFlush(&fh, 0);
+    rc = ensureCapacity(cfg->filePages, &fh);
+    closePageFile(&fh);
+    return rc;
+}
+
+static int lookupName(const char *name, const char **names, int count) {
+    for (int i = 0; i < count; i++)
+        if (strcmp(name, names[i]) == 0) return i;
+    return -1;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "usage: %s [-a uniform|zipf|hotset|scan|mixed] [-s fifo|lru|clock|lfu|lru_k]\n"
+            "          [-p poolPages] [-f filePages] [-t threads] [-n opsPerThread]\n"
+            "          [-w writePercent] [-z zipfTheta] [-r seed] [-i ioWorkers]\n"
+            "          [-F pageFile] [-L] [-M] [-P] [-H]\n"
+            "  -L runs on a log-structured page file (createLogPageFile)\n"
+            "  -M adds the estimated hit ratio at 0.5x, 1x, 2x and 4x poolPages\n"
+            "  -P adds hardware counters per operation (perf_event_open, Linux)\n"
+            "  -H prints the CSV header before the result line\n", prog);
+}
+
+int main(int argc, char **argv) {
+    BenchConfig cfg = { PAT_ZIPF, RS_LRU, 100, 1000, 1, 100000, 10, 0.99, 42, 0, "bench.bin" };
+    int header = 0, perf = 0, curveOn = 0;
+    int opt, v;
+    while ((opt = getopt(argc, argv, "a:s:p:f:t:n:w:z:r:i:F:LMPH")) != -1) {
+        switch (opt) {
+        case 'a':
+            if ((v = lookupName(optarg, patternNames, 5)) < 0) { usage(argv[0]); return 1; }
+            cfg.pattern = (Pattern) v;
+            break;
+        case 's':
+            if ((v = lookupName(optarg, strategyNames, 5)) < 0) { usage(argv[0]); return 1; }
+            cfg.strat = (ReplacementStrategy) v;
+            break;
+        case 'p': cfg.poolPages = atoi(optarg); break;
+        case 'f': cfg.filePages = atoi(optarg); break;
+        case 't': cfg.threads = atoi(optarg); break;
+        case 'n': cfg.opsPerThread = atol(optarg); break;
+        case 'w': cfg.writePercent = atoi(optarg); break;
+        case 'z': cfg.theta = atof(optarg); break;
+        case 'r': cfg.seed = strtoull(optarg, NULL, 10); break;
+        case 'i': cfg.ioWorkers = atoi(optarg); break;
+        case 'F': cfg.fileName = optarg; break;
+        case 'L': cfg.logFile = 1; break;
+        case 'M': curveOn = 1; break;
+        case 'P': perf = 1; break;
+        case 'H': header = 1; break;
+        default: usage(argv[0]); return 1;
+        }
+    }
+    if (cfg.poolPages < 1 || cfg.filePages < 1 || cfg.threads < 1 || cfg.opsPerThread < 1
+        || cfg.theta <= 0 || cfg.theta == 1.0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    initStorageManager();
+    if (createBenchFile(&cfg) != RC_OK) {
+        fprintf(stderr, "cannot create %s\n", cfg.fileName);
+        return 1;
+    }
+    if (cfg.pattern == PAT_ZIPF || cfg.pattern == PAT_MIXED) initZipf(cfg.filePages, cfg.theta);
+
+    BM_BufferPool bm;
+    BM_PoolConfig poolCfg;
+    initPoolConfig(&poolCfg);
+    poolCfg.ioWorkers = cfg.ioWorkers;
+    poolCfg.hitRatioCurve = curveOn;
+    if (initBufferPoolWithConfig(&bm, cfg.fileName, cfg.poolPages, cfg.strat, NULL, &poolCfg) != RC_OK) {
+        fprintf(stderr, "cannot open the buffer pool\n");
+        return 1;
+    }
+
+    Worker *workers = calloc(cfg.threads, sizeof(Worker));
+    for (int i = 0; i < cfg.threads; i++) {
+        workers[i].bm = &bm;
+        workers[i].cfg = &cfg;
+        workers[i].id = i;
+        // never seed xorshift with 0
+        workers[i].rng = (cfg.seed + 1) * 0x9E3779B97F4A7C15ULL + (unsigned long long) i * 7919;
+        if (workers[i].rng == 0) workers[i].rng = 1;
+        workers[i].latency = malloc(sizeof(long long) * cfg.opsPerThread);
+    }
+    PerfCounters counters;
+    if (perf) perfStart(&counters);
+    long long start = nowNanos();
+    for (int i = 0; i < cfg.threads; i++)
+        pthread_create(&workers[i].thread, NULL, workerMain, &workers[i]);
+    for (int i = 0; i < cfg.threads; i++)
+        pthread_join(workers[i].thread, NULL);
+    double seconds = (nowNanos() - start) / 1e9;
+    if (perf) perfStop(&counters);
+
+    // I/O counts before shutdown, which writes back the remaining dirty pages
+    int readIO = getNumReadIO(&bm);
+    int writeIO = getNumWriteIO(&bm);
+    BM_HitRatioCurve curve;
+    if (curveOn) getHitRatioCurve(&bm, &curve);
+    shutdownBufferPool(&bm);
+    destroyPageFile((char *) cfg.fileName);
+
+    long ops = 0, errors = 0;
+    for (int i = 0; i < cfg.threads; i++) {
+        ops += workers[i].ops;
+        errors += workers[i].errors;
+    }
+    long long *all = malloc(sizeof(long long) * (ops > 0 ? ops : 1));
+    long n = 0;
+    for (int i = 0; i < cfg.threads; i++) {
+        memcpy(all + n, workers[i].latency, sizeof(long long) * workers[i].ops);
+        n += workers[i].ops;
+        free(workers[i].latency);
+    }
+    qsort(all, n, sizeof(long long), compareLL);
+    double p50 = n ? all[n / 2] / 1e3 : 0;
+    double p95 = n ? all[(long) (n * 0.95)] / 1e3 : 0;
+    double p99 = n ? all[(long) (n * 0.99)] / 1e3 : 0;
+    double pmax = n ? all[n - 1] / 1e3 : 0;
+    // every miss reads exactly one page
+    double hitRatio = ops ? 1.0 - (double) readIO / ops : 0;
+
+    if (header) {
+        printf("pattern,strategy,poolPages,filePages,threads,writePercent,seed,ops,errors,"
+               "seconds,opsPerSec,hitRatio,readIO,writeIO,p50us,p95us,p99us,maxus");
+        if (curveOn) printf(",estHit0.5x,estHit1x,estHit2x,estHit4x");
+        if (perf) perfPrintHeader();
+        printf("\n");
+    }
+    printf("%s,%s,%d,%d,%d,%d,%llu,%ld,%ld,%.4f,%.0f,%.4f,%d,%d,%.2f,%.2f,%.2f,%.2f",
+           patternNames[cfg.pattern], strategyNames[cfg.strat], cfg.poolPages, cfg.filePages,
+           cfg.threads, cfg.writePercent, cfg.seed, ops, errors, seconds,
+           seconds > 0 ? ops / seconds : 0, hitRatio, readIO, writeIO, p50, p95, p99, pmax);
+    if (curveOn)
+        for (int i = 0; i < BM_CURVE_POINTS; i++) printf(",%.4f", curve.hitRatio[i]);
+    if (perf) perfPrintPerOp(&counters, ops);
+    printf("\n");
+    free(all);
+    free(workers);
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,105 @@
+// perf_event_open has no libc wrapper; syscall() needs _GNU_SOURCE
+#define _GNU_SOURCE
+
+// Hardware counters around a benchmark run. Counters are opened with
+// inherit set, so they follow the worker threads started after perfStart,
+// but not threads the buffer pool started earlier (I/O workers, evictor).
+// Where the PMU isn't reachable (containers, VMs, no permission) every
+// value reads NA and the run goes on.
+
+#include "bench_perf.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+static const char *perfNames[PERF_EVENTS] = {
+    "cyclesPerOp", "instructionsPerOp", "llcMissesPerOp", "dtlbMissesPerOp", "branchMissesPerOp"
+};
+
+#ifdef __linux__
+#define CACHE_READ_MISS(cache) \
+    ((cache) | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16))
+
+static const struct { unsigned type; unsigned long long config; } perfEvents[PERF_EVENTS] = {
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    { PERF_TYPE_HW_CACHE, CACHE_READ_MISS(PERF_COUNT_HW_CACHE_LL) },
+    { PERF_TYPE_HW_CACHE, CACHE_READ_MISS(PERF_COUNT_HW_CACHE_DTLB) },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+};
+
+static int openCounter(int e, int excludeKernel) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = perfEvents[e].type;
+    attr.config = perfEvents[e].config;
+    attr.disabled = 1;
+    attr.inherit = 1;
+    attr.exclude_kernel = excludeKernel;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return (int) syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+#endif
+
+void perfStart(PerfCounters *pc) {
+    int opened = 0;
+    pc->scope = "none";
+    for (int e = 0; e < PERF_EVENTS; e++) {
+        pc->fd[e] = -1;
+        pc->value[e] = -1;
+    }
+#ifdef __linux__
+    // count kernel work too (read/write system calls) where allowed
+    for (int excludeKernel = 0; excludeKernel < 2 && !opened; excludeKernel++) {
+        for (int e = 0; e < PERF_EVENTS; e++) {
+            pc->fd[e] = openCounter(e, excludeKernel);
+            if (pc->fd[e] >= 0) opened++;
+        }
+        if (opened) pc->scope = excludeKernel ? "user" : "all";
+    }
+    for (int e = 0; e < PERF_EVENTS; e++) {
+        if (pc->fd[e] < 0) continue;
+        ioctl(pc->fd[e], PERF_EVENT_IOC_RESET, 0);
+        ioctl(pc->fd[e], PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+}
+
+void perfStop(PerfCounters *pc) {
+#ifdef __linux__
+    for (int e = 0; e < PERF_EVENTS; e++) {
+        if (pc->fd[e] < 0) continue;
+        ioctl(pc->fd[e], PERF_EVENT_IOC_DISABLE, 0);
+    }
+    for (int e = 0; e < PERF_EVENTS; e++) {
+        unsigned long long v[3]; // value, time enabled, time running
+        if (pc->fd[e] < 0) continue;
+        if (read(pc->fd[e], v, sizeof(v)) == (ssize_t) sizeof(v) && v[2] > 0)
+            pc->value[e] = (double) v[0] * ((double) v[1] / v[2]);
+        close(pc->fd[e]);
+        pc->fd[e] = -1;
+    }
+#endif
+}
+
+void perfPrintHeader(void) {
+    for (int e = 0; e < PERF_EVENTS; e++) printf(",%s", perfNames[e]);
+    printf(",perfScope");
+}
+
+void perfPrintPerOp(const PerfCounters *pc, double ops) {
+    for (int e = 0; e < PERF_EVENTS; e++) {
+        if (pc->value[e] < 0 || ops <= 0) printf(",NA");
+        else printf(",%.2f", pc->value[e] / ops);
+    }
+    printf(",%s", pc->scope);
+}
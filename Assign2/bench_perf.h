@@ -0,0 +1,24 @@
+#ifndef BENCH_PERF_H
+#define BENCH_PERF_H
+
+// Hardware performance counters for the benchmarks (Linux perf_event_open)
+#define PERF_EVENTS 5
+
+// Counters of one measurement: cycles, instructions, LLC misses, dTLB
+// misses and branch misses, scaled up when the kernel multiplexed them
+typedef struct PerfCounters {
+	int fd[PERF_EVENTS];
+	double value[PERF_EVENTS];
+	const char *scope; // "all", "user" (kernel excluded by perf_event_paranoid) or "none"
+} PerfCounters;
+
+// Start counting the calling thread and the threads it creates from now on
+void perfStart (PerfCounters *pc);
+// Stop counting and read the values
+void perfStop (PerfCounters *pc);
+// CSV columns appended by perfPrintPerOp
+void perfPrintHeader (void);
+// Print ",<counter per op>..." for ops operations (NA where not available)
+void perfPrintPerOp (const PerfCounters *pc, double ops);
+
+#endif
@@ -0,0 +1,138 @@
+#!/bin/sh
+# Benchmark regression tracking.
+#
+#   bench_regress.sh save  [baseline.json]   run the suite, write the baseline
+#   bench_regress.sh check [baseline.json]   run the suite, compare, exit 1 on
+#                                            a regression
+#
+# Every workload runs REPS times (default 5) with a fixed seed. Buffer runs
+# are single-threaded, so their readIO/writeIO are exact: any increase is a
+# regression. Throughput is compared by its median; the allowed drop is
+# TOLERANCE (default 0.10) or the noise of the baseline and the new run
+# added up, whichever is larger, so a noisy machine widens its own threshold
+# instead of failing at random. Noise is the spread of the repetitions
+# without the fastest and slowest one, relative to the median. A baseline
+# workload the run no longer produces counts as a regression too, and a
+# benchmark that fails ends the script with exit 2.
+
+MODE=${1:-check}
+BASELINE=${2:-bench_baseline.json}
+REPS=${REPS:-5}
+TOLERANCE=${TOLERANCE:-0.10}
+SEED=42
+OPS=200000
+
+BENCH_DIR=$(dirname "$0")
+RAW=$(mktemp)
+CURRENT=$(mktemp)
+OUT=$(mktemp)
+trap 'rm -f "$RAW" "$CURRENT" "$OUT"' EXIT
+
+case "$MODE" in
+    save|check) ;;
+    *) echo "usage: $0 save|check [baseline.json]" >&2; exit 2 ;;
+esac
+for b in bench_buffer bench_storage; do
+    if [ ! -x "$BENCH_DIR/$b" ]; then
+        echo "$b not built; run make bench" >&2
+        exit 2
+    fi
+done
+
+# run a benchmark into $OUT; a failed run ends the script (a pipe would hide
+# its exit status behind awk's)
+run() {
+    if ! "$@" > "$OUT"; then
+        echo "$* failed" >&2
+        exit 2
+    fi
+}
+
+# raw lines: name,throughput,readIO,writeIO (-1 where not applicable)
+rep=1
+while [ "$rep" -le "$REPS" ]; do
+    for pattern in uniform zipf hotset scan mixed; do
+        for strat in fifo lru clock; do
+            run "$BENCH_DIR/bench_buffer" -a "$pattern" -s "$strat" -t 1 -n "$OPS" -r "$SEED" \
+                -F bench_regress.bin
+            awk -F, -v name="buffer/$pattern/$strat" '{ print name "," $11 "," $13 "," $14 }' \
+                "$OUT" >> "$RAW" || exit 2
+        done
+    done
+    run "$BENCH_DIR/bench_storage" -f 1024 -r "$SEED" -F bench_regress.bin
+    awk -F, '$4 == "warm" && ($1 == "readBlock" || $1 == "writeBlock" ||
+                              $1 == "readBlocks" || $1 == "writeBlocks") {
+        print "storage/" $1 "/" $2 "/" $3 "," $8 ",-1,-1" }' "$OUT" >> "$RAW" || exit 2
+    rep=$((rep + 1))
+done
+
+# one JSON object per line: median throughput, spread and I/O counts
+sort -t, -k1,1 -k2,2n "$RAW" | awk -F, '
+    function flush() {
+        if (name == "") return
+        med = (n % 2) ? v[(n + 1) / 2] : (v[n / 2] + v[n / 2 + 1]) / 2
+        lo = n >= 4 ? 2 : 1
+        hi = n >= 4 ? n - 1 : n
+        spread = med > 0 ? (v[hi] - v[lo]) / med : 0
+        printf "{\"name\": \"%s\", \"throughput\": %.1f, \"spread\": %.4f, \"readIO\": %d, \"writeIO\": %d}\n",
+               name, med, spread, rio, wio
+    }
+    $1 != name { flush(); name = $1; n = 0; rio = -1; wio = -1 }
+    {
+        v[++n] = $2
+        if ($3 > rio) rio = $3
+        if ($4 > wio) wio = $4
+    }
+    END { flush() }' > "$CURRENT"
+
+if [ "$MODE" = save ]; then
+    {
+        echo "{\"seed\": $SEED, \"reps\": $REPS, \"results\": ["
+        sed '$!s/$/,/' "$CURRENT"
+        echo "]}"
+    } > "$BASELINE"
+    echo "baseline written to $BASELINE ($(wc -l < "$CURRENT") workloads)"
+    exit 0
+fi
+
+if [ ! -f "$BASELINE" ]; then
+    echo "no baseline $BASELINE; run '$0 save' first" >&2
+    exit 2
+fi
+
+# compare: baseline lines first (tagged B), then the current run (tagged C)
+{ grep '"name"' "$BASELINE" | sed 's/^/B /'; sed 's/^/C /' "$CURRENT"; } | awk -v tol="$TOLERANCE" '
+    function field(key,    s) {
+        s = $0
+        sub(".*\"" key "\": *\"?", "", s)
+        sub("[\",}].*", "", s)
+        return s
+    }
+    {
+        name = field("name")
+        if ($1 == "B") {
+            bt[name] = field("throughput"); bs[name] = field("spread")
+            br[name] = field("readIO"); bw[name] = field("writeIO")
+            next
+        }
+        if (!(name in bt)) { printf "%-34s new workload, not compared\n", name; next }
+        t = field("throughput"); s = field("spread"); r = field("readIO"); w = field("writeIO")
+        allowed = bs[name] + s
+        if (allowed < tol) allowed = tol
+        change = bt[name] > 0 ? (t - bt[name]) / bt[name] : 0
+        verdict = "ok"
+        if (change < -allowed) verdict = "SLOWER"
+        if (r > br[name] || w > bw[name]) verdict = (verdict == "ok") ? "MORE I/O" : verdict "+MORE I/O"
+        if (verdict != "ok") failed++
+        printf "%-34s %+7.1f%% (allowed -%.1f%%)  readIO %s -> %s  writeIO %s -> %s  %s\n",
+               name, 100 * change, 100 * allowed, br[name], r, bw[name], w, verdict
+        seen[name] = 1
+    }
+    END {
+        for (name in bt) if (!(name in seen)) {
+            printf "%-34s MISSING from this run\n", name
+            failed++
+        }
+        if (failed) { printf "%d regression(s)\n", failed; exit 1 }
+        print "no regressions"
+    }'
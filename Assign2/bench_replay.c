@@ -0,0 +1,256 @@
+// getopt, clock_nanosleep and pthreads are POSIX, not plain C99
+#define _POSIX_C_SOURCE 200809L
+
+// Replays a buffer manager API trace (see bm_trace.h) against this build:
+// one thread per recorded thread issues its pins, markDirty, unpins and
+// flushes in the recorded order, either as fast as possible or on the
+// recorded schedule, and prints one CSV line (throughput, pin latency
+// percentiles, I/O, hit ratio, calls that failed). Pool size, strategy and
+// pool options can be overridden to compare configurations on one workload.
+//
+// Only each thread's own order is kept; at maximum speed calls of different
+// threads may interleave differently than they did when recorded. Pages are
+// read from a scratch page file (or -F, e.g. a copy of the recorded one),
+// extended to the highest page in the trace.
+
+#include "storage_mgr.h"
+#include "buffer_mgr.h"
+#include "bm_trace.h"
+#include "dberror.h"
+#include "bench_perf.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// One call of a recorded thread
+typedef struct ReplayOp {
+    long long nanos;
+    char op;
+    int page;
+} ReplayOp;
+
+typedef struct Replayer {
+    pthread_t thread;
+    ReplayOp *ops;
+    long numOps, maxOps;
+    long long *pinLatency;
+    long pins;
+    long errors;
+} Replayer;
+
+static BM_BufferPool pool;
+static double speed;        // 0 = as fast as possible, 1 = recorded speed
+static long long replayStart;
+
+static const char *strategyNames[] = { "fifo", "lru", "clock", "lfu", "lru_k" };
+
+static long long nowNanos(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long) ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void sleepUntil(long long nanos) {
+    struct timespec ts;
+    ts.tv_sec = nanos / 1000000000LL;
+    ts.tv_nsec = nanos % 1000000000LL;
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) != 0) ;
+}
+
+static void addOp(Replayer *r, const TraceRecord *rec) {
+    if (r->numOps == r->maxOps) {
+        r->maxOps = r->maxOps ? 2 * r->maxOps : 1024;
+        r->ops = realloc(r->ops, sizeof(ReplayOp) * r->maxOps);
+    }
+    r->ops[r->numOps].nanos = rec->nanos;
+    r->ops[r->numOps].op = rec->op;
+    r->ops[r->numOps].page = rec->page;
+    r->numOps++;
+    if (rec->op == TRACE_PIN) r->pins++;
+}
+
+static void *replayMain(void *arg) {
+    Replayer *r = arg;
+    BM_PageHandle h;
+    long pins = 0;
+    r->pinLatency = malloc(sizeof(long long) * (r->pins ? r->pins : 1));
+    for (long i = 0; i < r->numOps; i++) {
+        ReplayOp *op = &r->ops[i];
+        RC rc = RC_OK;
+        // a thread running late issues its calls without sleeping
+        if (speed > 0 && replayStart + (long long) (op->nanos / speed) > nowNanos())
+            sleepUntil(replayStart + (long long) (op->nanos / speed));
+        h.pageNum = op->page;
+        switch (op->op) {
+        case TRACE_PIN: {
+            long long t0 = nowNanos();
+            rc = pinPage(&pool, &h, op->page);
+            r->pinLatency[pins++] = nowNanos() - t0;
+            break;
+        }
+        case TRACE_DIRTY: rc = markDirty(&pool, &h); break;
+        case TRACE_UNPIN: rc = unpinPage(&pool, &h); break;
+        case TRACE_FORCE: rc = forcePage(&pool, &h); break;
+        case TRACE_FLUSH: rc = forceFlushPool(&pool); break;
+        }
+        if (rc != RC_OK) r->errors++;
+    }
+    return NULL;
+}
+
+static int compareLL(const void *a, const void *b) {
+    long long x = *(const long long *) a, y = *(const long long *) b;
+    return (x > y) - (x < y);
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "usage: %s [-p poolPages] [-s fifo|lru|clock|lfu|lru_k] [-x speed]\n"
+            "          [-i ioWorkers] [-C writeCoalesceWindow] [-F pageFile] [-P] [-H] trace\n"
+            "  -p/-s override the pool size and strategy recorded in the trace\n"
+            "  -x 0 replays as fast as possible (default), 1 at the recorded speed,\n"
+            "     2 twice as fast, ...\n"
+            "  -F reads the pages from pageFile instead of a scratch file\n"
+            "  -P adds hardware counters per call (perf_event_open, Linux)\n"
+            "  -H prints the CSV header before the result line\n", prog);
+}
+
+int main(int argc, char **argv) {
+    int poolPages = 0, strat = -1, ioWorkers = 0, coalesce = 0, header = 0, perf = 0;
+    const char *fileName = NULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "p:s:x:i:C:F:PH")) != -1) {
+        switch (opt) {
+        case 'p': poolPages = atoi(optarg); break;
+        case 's':
+            for (strat = 0; strat < 5 && strcmp(optarg, strategyNames[strat]) != 0; strat++) ;
+            if (strat == 5) { usage(argv[0]); return 1; }
+            break;
+        case 'x': speed = atof(optarg); break;
+        case 'i': ioWorkers = atoi(optarg); break;
+        case 'C': coalesce = atoi(optarg); break;
+        case 'F': fileName = optarg; break;
+        case 'P': perf = 1; break;
+        case 'H': header = 1; break;
+        default: usage(argv[0]); return 1;
+        }
+    }
+    if (optind != argc - 1 || speed < 0) {
+        usage(argv[0]);
+        return 1;
+    }
+    const char *traceName = argv[optind];
+    FILE *in = fopen(traceName, "r");
+    if (!in) {
+        fprintf(stderr, "cannot open %s\n", traceName);
+        return 1;
+    }
+
+    // split the trace by thread, up to the pool's shutdown
+    Replayer *replayers = NULL;
+    int numThreads = 0, maxPage = 0, recordedPages = 0, recordedStrat = RS_LRU;
+    long numOps = 0, pins = 0;
+    TraceRecord rec;
+    RC rc;
+    while ((rc = readTraceRecord(in, &rec)) == RC_OK && rec.op != TRACE_SHUTDOWN) {
+        if (rec.op == TRACE_INIT) {
+            recordedPages = rec.numPages;
+            recordedStrat = rec.strategy;
+            continue;
+        }
+        if (rec.thread < 0) continue;
+        if (rec.thread >= numThreads) {
+            replayers = realloc(replayers, sizeof(Replayer) * (rec.thread + 1));
+            memset(replayers + numThreads, 0, sizeof(Replayer) * (rec.thread + 1 - numThreads));
+            numThreads = rec.thread + 1;
+        }
+        if (rec.page > maxPage) maxPage = rec.page;
+        addOp(&replayers[rec.thread], &rec);
+        numOps++;
+        pins += rec.op == TRACE_PIN;
+    }
+    fclose(in);
+    if (rc == RC_READ_NON_EXISTING_PAGE) {
+        fprintf(stderr, "%s: malformed trace line\n", traceName);
+        return 1;
+    }
+    if (poolPages < 1) poolPages = recordedPages;
+    if (strat < 0) strat = recordedStrat;
+    if (poolPages < 1 || strat < 0 || strat >= 5 || numOps == 0) {
+        fprintf(stderr, "%s: no calls to replay (or no pool size; use -p)\n", traceName);
+        return 1;
+    }
+
+    initStorageManager();
+    SM_FileHandle fh;
+    int scratch = fileName == NULL;
+    if (scratch) {
+        fileName = "replay.bin";
+        createPageFile((char *) fileName);
+    }
+    rc = openPageFile((char *) fileName, &fh);
+    if (rc == RC_OK) {
+        rc = ensureCapacity(maxPage + 1, &fh);
+        closePageFile(&fh);
+    }
+    if (rc != RC_OK) {
+        fprintf(stderr, "cannot prepare %s\n", fileName);
+        return 1;
+    }
+    BM_PoolConfig poolCfg;
+    initPoolConfig(&poolCfg);
+    poolCfg.ioWorkers = ioWorkers;
+    poolCfg.writeCoalesceWindow = coalesce;
+    poolCfg.traceFile = NULL; // do not trace the replay itself
+    if (initBufferPoolWithConfig(&pool, fileName, poolPages, (ReplacementStrategy) strat,
+                                 NULL, &poolCfg) != RC_OK) {
+        fprintf(stderr, "cannot open the buffer pool\n");
+        return 1;
+    }
+
+    PerfCounters counters;
+    if (perf) perfStart(&counters);
+    replayStart = nowNanos();
+    for (int t = 0; t < numThreads; t++)
+        pthread_create(&replayers[t].thread, NULL, replayMain, &replayers[t]);
+    for (int t = 0; t < numThreads; t++)
+        pthread_join(replayers[t].thread, NULL);
+    double seconds = (nowNanos() - replayStart) / 1e9;
+    if (perf) perfStop(&counters);
+    int readIO = getNumReadIO(&pool);
+    int writeIO = getNumWriteIO(&pool);
+    shutdownBufferPool(&pool);
+    if (scratch) destroyPageFile((char *) fileName);
+
+    long long *all = malloc(sizeof(long long) * (pins ? pins : 1));
+    long n = 0, errors = 0;
+    for (int t = 0; t < numThreads; t++) {
+        memcpy(all + n, replayers[t].pinLatency, sizeof(long long) * replayers[t].pins);
+        n += replayers[t].pins;
+        errors += replayers[t].errors;
+        free(replayers[t].pinLatency);
+        free(replayers[t].ops);
+    }
+    qsort(all, n, sizeof(long long), compareLL);
+
+    if (header) {
+        printf("trace,strategy,poolPages,threads,speed,calls,pins,errors,seconds,callsPerSec,"
+               "p50us,p99us,maxus,readIO,writeIO,hitRatio");
+        if (perf) perfPrintHeader();
+        printf("\n");
+    }
+    printf("%s,%s,%d,%d,%g,%ld,%ld,%ld,%.4f,%.0f,%.1f,%.1f,%.1f,%d,%d,%.4f",
+           traceName, strategyNames[strat], poolPages, numThreads, speed, numOps, pins, errors,
+           seconds, seconds > 0 ? numOps / seconds : 0,
+           n ? all[n / 2] / 1e3 : 0, n ? all[(long) (n * 0.99)] / 1e3 : 0, n ? all[n - 1] / 1e3 : 0,
+           readIO, writeIO, pins ? 1.0 - (double) readIO / pins : 0);
+    if (perf) perfPrintPerOp(&counters, numOps);
+    printf("\n");
+    free(all);
+    free(replayers);
+    return 0;
+}
@@ -0,0 +1,323 @@
+// getopt, clock_gettime and posix_fadvise are POSIX, not plain C99
+#define _POSIX_C_SOURCE 200809L
+
+// Storage manager benchmark: times every page-file call at several file
+// sizes, sequential and random, with warm and (on Linux) cold page cache,
+// and prints one CSV line per call type. See usage() for the options.
+
+#include "storage_mgr.h"
+#include "dberror.h"
+#include "bench_perf.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <fcntl.h>
+#endif
+
+#define RUN_PAGES 8     // pages per readBlocks/writeBlocks call
+#define GROW_STEP 64    // pages added per ensureCapacity call
+#define CREATE_CALLS 32 // createPageFile calls per file size
+#define MAX_SIZES 16
+
+// Latencies of the calls of one measurement
+static long long *lat;
+static long numLat, maxLat;
+static long long lapStart;
+// hardware counters (-P), started by the first call of a measurement
+static int usePerf, perfRunning;
+static PerfCounters perf;
+// -L: log-structured page files (createLogPageFile)
+static int logFiles;
+// -S: shadow-paged page files (createShadowPageFile), committed on close
+static int shadowFiles;
+
+static long long nowNanos(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long) ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// xorshift64*: the same page sequence for a seed on every platform
+static unsigned long long rng;
+static unsigned long long nextRandom(void) {
+    rng ^= rng >> 12;
+    rng ^= rng << 25;
+    rng ^= rng >> 27;
+    return rng * 2685821657736338717ULL;
+}
+
+static void startCall(void) {
+    if (usePerf && !perfRunning) {
+        perfStart(&perf);
+        perfRunning = 1;
+    }
+    lapStart = nowNanos();
+}
+
+static void endCall(void) {
+    if (numLat == maxLat) {
+        maxLat = maxLat ? 2 * maxLat : 1024;
+        lat = realloc(lat, sizeof(long long) * maxLat);
+    }
+    lat[numLat++] = nowNanos() - lapStart;
+}
+
+static int compareLL(const void *a, const void *b) {
+    long long x = *(const long long *) a, y = *(const long long *) b;
+    return (x > y) - (x < y);
+}
+
+// Print the CSV line for the calls recorded since the last report
+static void report(const char *op, const char *pattern, int filePages,
+                   const char *cache, int flush, long pagesPerCall) {
+    long long total = 0;
+    if (perfRunning) {
+        perfStop(&perf);
+        perfRunning = 0;
+    }
+    for (long i = 0; i < numLat; i++) total += lat[i];
+    qsort(lat, numLat, sizeof(long long), compareLL);
+    double seconds = total / 1e9;
+    double bytes = (double) numLat * pagesPerCall * PAGE_SIZE;
+    printf("%s,%s,%d,%s,%d,%ld,%.6f,%.1f,%.0f,%.2f,%.2f,%.2f",
+           op, pattern, filePages, cache, flush, numLat, seconds,
+           seconds > 0 ? bytes / seconds / 1e6 : 0,
+           seconds > 0 ? numLat / seconds : 0,
+           numLat ? total / 1e3 / numLat : 0,
+           numLat ? lat[numLat / 2] / 1e3 : 0,
+           numLat ? lat[(long) (numLat * 0.99)] / 1e3 : 0);
+    printf(",%s", logFiles ? "log" : shadowFiles ? "shadow" : "plain");
+    if (usePerf) perfPrintPerOp(&perf, numLat);
+    printf("\n");
+    numLat = 0;
+}
+
+// Write dirty data back and drop the file from the page cache so the next
+// reads go to the device; returns "cold", or "warm" where that isn't possible
+static const char *dropCache(const char *fileName) {
+    // the pages of a log-structured file are in its segment files
+    if (logFiles) return "warm";
+#ifdef __linux__
+    int fd = open(fileName, O_RDONLY);
+    if (fd < 0) return "warm";
+    int ok = fdatasync(fd) == 0 && posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0;
+    close(fd);
+    return ok ? "cold" : "warm";
+#else
+    (void) fileName;
+    return "warm";
+#endif
+}
+
+// Open fileName with the chosen flush mode
+static void openBench(char *fileName, SM_FileHandle *fh, int flush) {
+    if (openPageFile(fileName, fh) != RC_OK) {
+        fprintf(stderr, "cannot open %s\n", fileName);
+        exit(1);
+    }
+    setPageFileFlush(fh, flush);
+}
+
+static void createBench(char *fileName) {
+    if (logFiles) createLogPageFile(fileName, 0);
+    else if (shadowFiles) createShadowPageFile(fileName);
+    else createPageFile(fileName);
+}
+
+// Reads of the existing file: single pages, runs and the cursor calls
+static void benchReads(char *fileName, int pages, long randomCalls, int flush,
+                       const char *cache, char *buf) {
+    SM_FileHandle fh;
+    int p;
+
+    if (strcmp(cache, "cold") == 0) cache = dropCache(fileName);
+    openBench(fileName, &fh, flush);
+    for (p = 0; p < pages; p++) {
+        startCall();
+        readBlock(p, &fh, buf);
+        endCall();
+    }
+    report("readBlock", "seq", pages, cache, flush, 1);
+    closePageFile(&fh);
+
+    if (strcmp(cache, "cold") == 0) cache = dropCache(fileName);
+    openBench(fileName, &fh, flush);
+    for (long i = 0; i < randomCalls; i++) {
+        p = (int) (nextRandom() % pages);
+        startCall();
+        readBlock(p, &fh, buf);
+        endCall();
+    }
+    report("readBlock", "random", pages, cache, flush, 1);
+    closePageFile(&fh);
+
+    if (strcmp(cache, "cold") == 0) cache = dropCache(fileName);
+    openBench(fileName, &fh, flush);
+    for (p = 0; p + RUN_PAGES <= pages; p += RUN_PAGES) {
+        startCall();
+        readBlocks(p, RUN_PAGES, &fh, buf);
+        endCall();
+    }
+    report("readBlocks", "seq", pages, cache, flush, RUN_PAGES);
+    closePageFile(&fh);
+
+    if (strcmp(cache, "cold") == 0) cache = dropCache(fileName);
+    openBench(fileName, &fh, flush);
+    startCall();
+    readFirstBlock(&fh, buf);
+    endCall();
+    for (p = 1; p < pages; p++) {
+        startCall();
+        readNextBlock(&fh, buf);
+        endCall();
+    }
+    report("readFirst+Next", "seq", pages, cache, flush, 1);
+    if (strcmp(cache, "cold") == 0) cache = dropCache(fileName);
+    startCall();
+    readLastBlock(&fh, buf);
+    endCall();
+    for (p = pages - 2; p >= 0; p--) {
+        startCall();
+        readPreviousBlock(&fh, buf);
+        endCall();
+    }
+    report("readLast+Previous", "backward", pages, cache, flush, 1);
+    for (long i = 0; i < randomCalls; i++) {
+        startCall();
+        readCurrentBlock(&fh, buf);
+        endCall();
+    }
+    report("readCurrentBlock", "same", pages, cache, flush, 1);
+    closePageFile(&fh);
+}
+
+// All calls for one file size
+static void benchSize(char *fileName, int pages, long randomCalls, int flush, char *buf) {
+    SM_FileHandle fh;
+    int p;
+
+    for (int i = 0; i < CREATE_CALLS; i++) {
+        startCall();
+        createBench(fileName);
+        endCall();
+        destroyPageFile(fileName);
+    }
+    report("createPageFile", "-", pages, "warm", flush, 1);
+
+    createBench(fileName);
+    openBench(fileName, &fh, flush);
+    for (p = 1; p < pages; p++) {
+        startCall();
+        appendEmptyBlock(&fh);
+        endCall();
+    }
+    report("appendEmptyBlock", "seq", pages, "warm", flush, 1);
+    closePageFile(&fh);
+    destroyPageFile(fileName);
+
+    createBench(fileName);
+    openBench(fileName, &fh, flush);
+    for (p = GROW_STEP; p < pages + GROW_STEP; p += GROW_STEP) {
+        startCall();
+        ensureCapacity(p < pages ? p : pages, &fh);
+        endCall();
+    }
+    report("ensureCapacity", "seq", pages, "warm", flush, GROW_STEP);
+
+    memset(buf, 'x', (size_t) RUN_PAGES * PAGE_SIZE);
+    for (p = 0; p < pages; p++) {
+        startCall();
+        writeBlock(p, &fh, buf);
+        endCall();
+    }
+    report("writeBlock", "seq", pages, "warm", flush, 1);
+    for (long i = 0; i < randomCalls; i++) {
+        p = (int) (nextRandom() % pages);
+        startCall();
+        writeBlock(p, &fh, buf);
+        endCall();
+    }
+    report("writeBlock", "random", pages, "warm", flush, 1);
+    {
+        SM_PageHandle run[RUN_PAGES];
+        for (int k = 0; k < RUN_PAGES; k++) run[k] = buf + (size_t) k * PAGE_SIZE;
+        for (p = 0; p + RUN_PAGES <= pages; p += RUN_PAGES) {
+            startCall();
+            writeBlocks(p, RUN_PAGES, &fh, run);
+            endCall();
+        }
+        report("writeBlocks", "seq", pages, "warm", flush, RUN_PAGES);
+    }
+    closePageFile(&fh);
+
+    benchReads(fileName, pages, randomCalls, flush, "warm", buf);
+    benchReads(fileName, pages, randomCalls, flush, "cold", buf);
+    destroyPageFile(fileName);
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "usage: %s [-f filePages[,filePages...]] [-n randomCalls] [-r seed]\n"
+            "          [-F pageFile] [-u] [-L] [-S] [-P] [-H]\n"
+            "  -n 0 issues as many random calls as the file has pages\n"
+            "  -u turns the per-write fflush off (setPageFileFlush)\n"
+            "  -L uses log-structured page files (createLogPageFile); reads stay warm\n"
+            "  -S uses shadow-paged page files (createShadowPageFile)\n"
+            "  -P adds hardware counters per call (perf_event_open, Linux)\n"
+            "  -H prints the CSV header first\n", prog);
+}
+
+int main(int argc, char **argv) {
+    int sizes[MAX_SIZES] = { 256, 4096, 32768 };
+    int numSizes = 3;
+    long randomCalls = 0;
+    char *fileName = "bench_storage.bin";
+    int flush = 1, header = 0;
+    unsigned long long seed = 42;
+    int opt;
+    while ((opt = getopt(argc, argv, "f:n:r:F:uLSPH")) != -1) {
+        switch (opt) {
+        case 'f': {
+            numSizes = 0;
+            for (char *tok = strtok(optarg, ","); tok && numSizes < MAX_SIZES; tok = strtok(NULL, ","))
+                sizes[numSizes++] = atoi(tok);
+            break;
+        }
+        case 'n': randomCalls = atol(optarg); break;
+        case 'r': seed = strtoull(optarg, NULL, 10); break;
+        case 'F': fileName = optarg; break;
+        case 'u': flush = 0; break;
+        case 'L': logFiles = 1; break;
+        case 'S': shadowFiles = 1; break;
+        case 'P': usePerf = 1; break;
+        case 'H': header = 1; break;
+        default: usage(argv[0]); return 1;
+        }
+    }
+    for (int i = 0; i < numSizes; i++) {
+        if (sizes[i] < RUN_PAGES) {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    initStorageManager();
+    rng = (seed + 1) * 0x9E3779B97F4A7C15ULL;
+    if (rng == 0) rng = 1;
+    char *buf = malloc((size_t) RUN_PAGES * PAGE_SIZE);
+    if (header) {
+        printf("op,pattern,filePages,cache,flush,calls,seconds,MBps,IOPS,avgUs,p50us,p99us,store");
+        if (usePerf) perfPrintHeader();
+        printf("\n");
+    }
+    for (int i = 0; i < numSizes; i++)
+        benchSize(fileName, sizes[i], randomCalls > 0 ? randomCalls : sizes[i], flush, buf);
+    free(buf);
+    free(lat);
+    return 0;
+}
@@ -0,0 +1,624 @@
+// getopt, clock_gettime and pthreads are POSIX, not plain C99
+#define _POSIX_C_SOURCE 200809L
+
+// TPC-C-like OLTP driver: loads a scaled-down warehouse / district /
+// customer / item / stock schema into one page file, then runs new-order
+// and payment transactions from many client threads through the buffer
+// pool and prints one CSV line (tps, latency percentiles, I/O, hit ratio).
+//
+// There is no record manager in this tree, so the driver lays out fixed-size
+// records itself and guards each page it modifies with a page latch, held
+// only while that page is changed (no transaction isolation is attempted).
+
+#include "storage_mgr.h"
+#include "buffer_mgr.h"
+#include "dberror.h"
+#include "bench_perf.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define DIST_PER_WH 10
+#define ORDER_RING 100      // recent orders kept per district
+#define MAX_LINES 15        // order lines per order
+#define HISTORY_RING 1000   // payment history records kept per warehouse
+#define LATCHES 4096        // striped page latches
+
+// Fixed-size records; each table packs PAGE_SIZE / size of them per page
+typedef struct Warehouse {
+    int id;
+    double tax;
+    double ytd;
+    char name[44];
+} Warehouse;
+
+typedef struct District {
+    int id;
+    int nextOrderId;
+    double tax;
+    double ytd;
+    char name[40];
+} District;
+
+typedef struct Customer {
+    int id;
+    int paymentCount;
+    int deliveryCount;
+    double discount;
+    double balance;
+    double ytdPayment;
+    char last[16];
+    char data[456];
+} Customer;
+
+typedef struct Item {
+    int id;
+    double price;
+    char name[24];
+    char data[88];
+} Item;
+
+typedef struct Stock {
+    int itemId;
+    int quantity;
+    int orderCount;
+    int remoteCount;
+    double ytd;
+    char dist[DIST_PER_WH][20];
+    char data[32];
+} Stock;
+
+typedef struct Order {
+    int id;
+    int customerId;
+    int lineCount;
+    int allLocal;
+    long long entryNanos;
+    char pad[40];
+} Order;
+
+typedef struct OrderLine {
+    int itemId;
+    int supplyWarehouse;
+    int quantity;
+    double amount;
+    char distInfo[40];
+} OrderLine;
+
+typedef struct History {
+    int customerId;
+    int district;
+    double amount;
+    long long dateNanos;
+    char data[32];
+} History;
+
+// A table: count records of size bytes starting at page first
+typedef struct Table {
+    int first;
+    int size;
+    int perPage;
+    long count;
+} Table;
+
+// Scale and run settings
+typedef struct TpccConfig {
+    int warehouses;
+    int customers;         // per district
+    int items;
+    int threads;
+    long txnsPerThread;
+    int newOrderPercent;
+    int poolPages;
+    ReplacementStrategy strat;
+    int checkpointMs;      // forceFlushPool interval, 0 = only at shutdown
+    int ioWorkers;
+    int coalesce;          // writeCoalesceWindow
+    unsigned long long seed;
+    const char *fileName;
+} TpccConfig;
+
+// Per-client state and results
+typedef struct Client {
+    int id;
+    int homeWarehouse;
+    unsigned long long rng;
+    long long *latency;
+    long txns, newOrders, payments;
+    long pageAccesses;
+    long errors;
+    pthread_t thread;
+} Client;
+
+static TpccConfig cfg;
+static BM_BufferPool pool;
+static Table warehouses, districts, customers, items, stock, orders, orderLines, history;
+static int totalPages;
+static pthread_mutex_t latches[LATCHES];
+static volatile int stopCheckpoint;
+static pthread_mutex_t checkpointLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t checkpointCond = PTHREAD_COND_INITIALIZER;
+
+static const char *strategyNames[] = { "fifo", "lru", "clock", "lfu", "lru_k" };
+
+static long long nowNanos(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long) ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// xorshift64*: the same transaction stream for a seed on every platform
+static unsigned long long nextRandom(unsigned long long *state) {
+    unsigned long long x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return x * 2685821657736338717ULL;
+}
+
+// Uniform integer in [lo, hi]
+static int randomRange(unsigned long long *state, int lo, int hi) {
+    return lo + (int) (nextRandom(state) % (unsigned long long) (hi - lo + 1));
+}
+
+// TPC-C non-uniform random NURand(A, x, y), with C fixed at A / 3
+static int nuRand(unsigned long long *state, int a, int lo, int hi) {
+    int c = a / 3;
+    return (((randomRange(state, 0, a) | randomRange(state, lo, hi)) + c) % (hi - lo + 1)) + lo;
+}
+
+// Lay out a table after the previous one
+static void defineTable(Table *t, int size, long count) {
+    t->first = totalPages;
+    t->size = size;
+    t->perPage = PAGE_SIZE / size;
+    t->count = count;
+    totalPages += (int) ((count + t->perPage - 1) / t->perPage);
+}
+
+static int recordPage(const Table *t, long idx) {
+    return t->first + (int) (idx / t->perPage);
+}
+
+// Pin the page of record idx; a writer also takes the page latch
+static void *pinRecord(Client *c, const Table *t, long idx, BM_PageHandle *h, int write) {
+    int page = recordPage(t, idx);
+    if (pinPage(&pool, h, page) != RC_OK) {
+        c->errors++;
+        return NULL;
+    }
+    c->pageAccesses++;
+    if (write) pthread_mutex_lock(&latches[page % LATCHES]);
+    return h->data + (idx % t->perPage) * t->size;
+}
+
+static void unpinRecord(const BM_PageHandle *h, int write) {
+    BM_PageHandle page = *h;
+    if (write) {
+        markDirty(&pool, &page);
+        pthread_mutex_unlock(&latches[page.pageNum % LATCHES]);
+    }
+    unpinPage(&pool, &page);
+}
+
+// Record indexes of the composite keys (all ids start at 1)
+static long districtIdx(int w, int d) { return (long) (w - 1) * DIST_PER_WH + (d - 1); }
+static long customerIdx(int w, int d, int c) { return districtIdx(w, d) * cfg.customers + (c - 1); }
+static long stockIdx(int w, int i) { return (long) (w - 1) * cfg.items + (i - 1); }
+static long orderIdx(int w, int d, int o) { return districtIdx(w, d) * ORDER_RING + (o % ORDER_RING); }
+
+// New-order: bump the district's order id, price the lines, update stock
+// and append the order and its lines to the district's ring
+static void newOrder(Client *c) {
+    unsigned long long *r = &c->rng;
+    int w = c->homeWarehouse;
+    int d = randomRange(r, 1, DIST_PER_WH);
+    int cust = nuRand(r, 1023, 1, cfg.customers);
+    int lineCount = randomRange(r, 5, MAX_LINES);
+    int itemIds[MAX_LINES], supply[MAX_LINES], qty[MAX_LINES];
+    int allLocal = 1;
+    BM_PageHandle h;
+
+    for (int l = 0; l < lineCount; l++) {
+        itemIds[l] = nuRand(r, 8191, 1, cfg.items);
+        supply[l] = w;
+        // 1% of the lines come from a remote warehouse
+        if (cfg.warehouses > 1 && randomRange(r, 1, 100) == 1) {
+            while ((supply[l] = randomRange(r, 1, cfg.warehouses)) == w) ;
+            allLocal = 0;
+        }
+        qty[l] = randomRange(r, 1, 10);
+    }
+
+    Warehouse *wh = pinRecord(c, &warehouses, w - 1, &h, 0);
+    if (!wh) return;
+    double wTax = wh->tax;
+    unpinRecord(&h, 0);
+
+    District *dist = pinRecord(c, &districts, districtIdx(w, d), &h, 1);
+    if (!dist) return;
+    int orderId = dist->nextOrderId++;
+    double dTax = dist->tax;
+    unpinRecord(&h, 1);
+
+    Customer *cu = pinRecord(c, &customers, customerIdx(w, d, cust), &h, 0);
+    if (!cu) return;
+    double discount = cu->discount;
+    unpinRecord(&h, 0);
+
+    OrderLine lines[MAX_LINES];
+    double total = 0;
+    for (int l = 0; l < lineCount; l++) {
+        Item *it = pinRecord(c, &items, itemIds[l] - 1, &h, 0);
+        if (!it) return;
+        double price = it->price;
+        unpinRecord(&h, 0);
+
+        Stock *st = pinRecord(c, &stock, stockIdx(supply[l], itemIds[l]), &h, 1);
+        if (!st) return;
+        st->quantity = st->quantity - qty[l] >= 10 ? st->quantity - qty[l] : st->quantity - qty[l] + 91;
+        st->ytd += qty[l];
+        st->orderCount++;
+        if (supply[l] != w) st->remoteCount++;
+        memcpy(lines[l].distInfo, st->dist[d - 1], sizeof(lines[l].distInfo) / 2);
+        unpinRecord(&h, 1);
+
+        lines[l].itemId = itemIds[l];
+        lines[l].supplyWarehouse = supply[l];
+        lines[l].quantity = qty[l];
+        lines[l].amount = qty[l] * price;
+        total += lines[l].amount;
+    }
+    total *= (1 - discount) * (1 + wTax + dTax);
+    (void) total;
+
+    Order *o = pinRecord(c, &orders, orderIdx(w, d, orderId), &h, 1);
+    if (!o) return;
+    o->id = orderId;
+    o->customerId = cust;
+    o->lineCount = lineCount;
+    o->allLocal = allLocal;
+    o->entryNanos = nowNanos();
+    unpinRecord(&h, 1);
+    for (int l = 0; l < lineCount; l++) {
+        OrderLine *ol = pinRecord(c, &orderLines, orderIdx(w, d, orderId) * MAX_LINES + l, &h, 1);
+        if (!ol) return;
+        *ol = lines[l];
+        unpinRecord(&h, 1);
+    }
+    c->newOrders++;
+}
+
+// Payment: add the amount to warehouse and district year-to-date totals,
+// charge the customer (15% of them at a remote warehouse), log history
+static void payment(Client *c) {
+    unsigned long long *r = &c->rng;
+    int w = c->homeWarehouse;
+    int d = randomRange(r, 1, DIST_PER_WH);
+    int cw = w, cd = d;
+    if (cfg.warehouses > 1 && randomRange(r, 1, 100) <= 15) {
+        while ((cw = randomRange(r, 1, cfg.warehouses)) == w) ;
+        cd = randomRange(r, 1, DIST_PER_WH);
+    }
+    int cust = nuRand(r, 1023, 1, cfg.customers);
+    double amount = randomRange(r, 100, 500000) / 100.0;
+    BM_PageHandle h;
+
+    Warehouse *wh = pinRecord(c, &warehouses, w - 1, &h, 1);
+    if (!wh) return;
+    wh->ytd += amount;
+    unpinRecord(&h, 1);
+
+    District *dist = pinRecord(c, &districts, districtIdx(w, d), &h, 1);
+    if (!dist) return;
+    dist->ytd += amount;
+    unpinRecord(&h, 1);
+
+    Customer *cu = pinRecord(c, &customers, customerIdx(cw, cd, cust), &h, 1);
+    if (!cu) return;
+    cu->balance -= amount;
+    cu->ytdPayment += amount;
+    cu->paymentCount++;
+    unpinRecord(&h, 1);
+
+    long slot = (long) (w - 1) * HISTORY_RING + (long) (nextRandom(r) % HISTORY_RING);
+    History *hi = pinRecord(c, &history, slot, &h, 1);
+    if (!hi) return;
+    hi->customerId = cust;
+    hi->district = d;
+    hi->amount = amount;
+    hi->dateNanos = nowNanos();
+    unpinRecord(&h, 1);
+    c->payments++;
+}
+
+static void *clientMain(void *arg) {
+    Client *c = arg;
+    while (c->txns < cfg.txnsPerThread) {
+        long long start = nowNanos();
+        if (randomRange(&c->rng, 1, 100) <= cfg.newOrderPercent) newOrder(c);
+        else payment(c);
+        c->latency[c->txns++] = nowNanos() - start;
+    }
+    return NULL;
+}
+
+// Flush policy: write back all dirty pages every checkpointMs
+static void *checkpointMain(void *arg) {
+    (void) arg;
+    pthread_mutex_lock(&checkpointLock);
+    while (!stopCheckpoint) {
+        struct timespec until;
+        clock_gettime(CLOCK_REALTIME, &until);
+        until.tv_sec += cfg.checkpointMs / 1000;
+        until.tv_nsec += (long) (cfg.checkpointMs % 1000) * 1000000L;
+        if (until.tv_nsec >= 1000000000L) {
+            until.tv_sec++;
+            until.tv_nsec -= 1000000000L;
+        }
+        pthread_cond_timedwait(&checkpointCond, &checkpointLock, &until);
+        if (stopCheckpoint) break;
+        pthread_mutex_unlock(&checkpointLock);
+        forceFlushPool(&pool);
+        pthread_mutex_lock(&checkpointLock);
+    }
+    pthread_mutex_unlock(&checkpointLock);
+    return NULL;
+}
+
+// Fill a table page by page with init(record, idx) and write it out
+static RC loadTable(SM_FileHandle *fh, const Table *t, char *page,
+                    void (*init)(void *rec, long idx, unsigned long long *rng),
+                    unsigned long long *rng) {
+    long idx = 0;
+    for (int p = t->first; idx < t->count; p++) {
+        memset(page, 0, PAGE_SIZE);
+        for (int k = 0; k < t->perPage && idx < t->count; k++, idx++)
+            init(page + k * t->size, idx, rng);
+        RC rc = writeBlock(p, fh, page);
+        if (rc != RC_OK) return rc;
+    }
+    return RC_OK;
+}
+
+static void initWarehouse(void *rec, long idx, unsigned long long *rng) {
+    Warehouse *w = rec;
+    w->id = (int) idx + 1;
+    w->tax = randomRange(rng, 0, 2000) / 10000.0;
+    w->ytd = 300000.0;
+    snprintf(w->name, sizeof(w->name), "warehouse-%d", w->id);
+}
+
+static void initDistrict(void *rec, long idx, unsigned long long *rng) {
+    District *d = rec;
+    d->id = (int) (idx % DIST_PER_WH) + 1;
+    d->nextOrderId = 1;
+    d->tax = randomRange(rng, 0, 2000) / 10000.0;
+    d->ytd = 30000.0;
+    snprintf(d->name, sizeof(d->name), "district-%ld", idx + 1);
+}
+
+static void initCustomer(void *rec, long idx, unsigned long long *rng) {
+    Customer *c = rec;
+    c->id = (int) (idx % cfg.customers) + 1;
+    c->discount = randomRange(rng, 0, 5000) / 10000.0;
+    c->balance = -10.0;
+    c->ytdPayment = 10.0;
+    c->paymentCount = 1;
+    snprintf(c->last, sizeof(c->last), "CUST%d", c->id % 1000);
+    memset(c->data, 'c', sizeof(c->data) - 1);
+}
+
+static void initItem(void *rec, long idx, unsigned long long *rng) {
+    Item *it = rec;
+    it->id = (int) idx + 1;
+    it->price = randomRange(rng, 100, 10000) / 100.0;
+    snprintf(it->name, sizeof(it->name), "item-%d", it->id);
+    memset(it->data, 'i', sizeof(it->data) - 1);
+}
+
+static void initStock(void *rec, long idx, unsigned long long *rng) {
+    Stock *s = rec;
+    s->itemId = (int) (idx % cfg.items) + 1;
+    s->quantity = randomRange(rng, 10, 100);
+    for (int d = 0; d < DIST_PER_WH; d++) memset(s->dist[d], 'a' + d, sizeof(s->dist[d]) - 1);
+}
+
+// Create the page file and load the initial database
+static RC loadDatabase(void) {
+    totalPages = 0;
+    defineTable(&warehouses, sizeof(Warehouse), cfg.warehouses);
+    defineTable(&districts, sizeof(District), (long) cfg.warehouses * DIST_PER_WH);
+    defineTable(&customers, sizeof(Customer), (long) cfg.warehouses * DIST_PER_WH * cfg.customers);
+    defineTable(&items, sizeof(Item), cfg.items);
+    defineTable(&stock, sizeof(Stock), (long) cfg.warehouses * cfg.items);
+    defineTable(&orders, sizeof(Order), (long) cfg.warehouses * DIST_PER_WH * ORDER_RING);
+    defineTable(&orderLines, sizeof(OrderLine),
+                (long) cfg.warehouses * DIST_PER_WH * ORDER_RING * MAX_LINES);
+    defineTable(&history, sizeof(History), (long) cfg.warehouses * HISTORY_RING);
+
+    SM_FileHandle fh;
+    RC rc = createPageFile((char *) cfg.fileName);
+    if (rc == RC_OK) rc = openPageFile((char *) cfg.fileName, &fh);
+    if (rc != RC_OK) return rc;
+    setPageFileFlush(&fh, 0);
+    rc = ensureCapacity(totalPages, &fh);
+    char *page = malloc(PAGE_SIZE);
+    unsigned long long rng = cfg.seed * 0x9E3779B97F4A7C15ULL + 1;
+    if (rc == RC_OK) rc = loadTable(&fh, &warehouses, page, initWarehouse, &rng);
+    if (rc == RC_OK) rc = loadTable(&fh, &districts, page, initDistrict, &rng);
+    if (rc == RC_OK) rc = loadTable(&fh, &customers, page, initCustomer, &rng);
+    if (rc == RC_OK) rc = loadTable(&fh, &items, page, initItem, &rng);
+    if (rc == RC_OK) rc = loadTable(&fh, &stock, page, initStock, &rng);
+    free(page);
+    closePageFile(&fh);
+    return rc;
+}
+
+// TPC-C consistency condition 1: each warehouse's ytd equals the sum of its
+// districts' ytd
+static int checkConsistency(void) {
+    Client checker;
+    memset(&checker, 0, sizeof(checker));
+    BM_PageHandle h;
+    for (int w = 1; w <= cfg.warehouses; w++) {
+        Warehouse *wh = pinRecord(&checker, &warehouses, w - 1, &h, 0);
+        if (!wh) return 0;
+        double wYtd = wh->ytd;
+        unpinRecord(&h, 0);
+        double dYtd = 0;
+        for (int d = 1; d <= DIST_PER_WH; d++) {
+            District *dist = pinRecord(&checker, &districts, districtIdx(w, d), &h, 0);
+            if (!dist) return 0;
+            dYtd += dist->ytd;
+            unpinRecord(&h, 0);
+        }
+        if (wYtd - dYtd > 0.005 || dYtd - wYtd > 0.005) return 0;
+    }
+    return 1;
+}
+
+static int compareLL(const void *a, const void *b) {
+    long long x = *(const long long *) a, y = *(const long long *) b;
+    return (x > y) - (x < y);
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "usage: %s [-w warehouses] [-c customersPerDistrict] [-I items]\n"
+            "          [-t threads] [-n txnsPerThread] [-m newOrderPercent]\n"
+            "          [-p poolPages] [-s fifo|lru|clock|lfu|lru_k] [-k checkpointMs]\n"
+            "          [-i ioWorkers] [-C writeCoalesceWindow] [-r seed] [-F pageFile] [-P] [-H]\n"
+            "  -P adds hardware counters per transaction (perf_event_open, Linux)\n"
+            "  -H prints the CSV header before the result line\n", prog);
+}
+
+int main(int argc, char **argv) {
+    TpccConfig defaults = { 4, 300, 10000, 8, 5000, 50, 1000, RS_LRU, 0, 0, 0, 42, "tpcc.bin" };
+    int header = 0, perf = 0;
+    int opt;
+    cfg = defaults;
+    while ((opt = getopt(argc, argv, "w:c:I:t:n:m:p:s:k:i:C:r:F:PH")) != -1) {
+        switch (opt) {
+        case 'w': cfg.warehouses = atoi(optarg); break;
+        case 'c': cfg.customers = atoi(optarg); break;
+        case 'I': cfg.items = atoi(optarg); break;
+        case 't': cfg.threads = atoi(optarg); break;
+        case 'n': cfg.txnsPerThread = atol(optarg); break;
+        case 'm': cfg.newOrderPercent = atoi(optarg); break;
+        case 'p': cfg.poolPages = atoi(optarg); break;
+        case 's': {
+            int s;
+            for (s = 0; s < 5 && strcmp(optarg, strategyNames[s]) != 0; s++) ;
+            if (s == 5) { usage(argv[0]); return 1; }
+            cfg.strat = (ReplacementStrategy) s;
+            break;
+        }
+        case 'k': cfg.checkpointMs = atoi(optarg); break;
+        case 'i': cfg.ioWorkers = atoi(optarg); break;
+        case 'C': cfg.coalesce = atoi(optarg); break;
+        case 'r': cfg.seed = strtoull(optarg, NULL, 10); break;
+        case 'F': cfg.fileName = optarg; break;
+        case 'P': perf = 1; break;
+        case 'H': header = 1; break;
+        default: usage(argv[0]); return 1;
+        }
+    }
+    if (cfg.warehouses < 1 || cfg.customers < 1 || cfg.items < 1 || cfg.threads < 1
+        || cfg.txnsPerThread < 1 || cfg.poolPages < 1) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    initStorageManager();
+    if (loadDatabase() != RC_OK) {
+        fprintf(stderr, "cannot load %s\n", cfg.fileName);
+        return 1;
+    }
+    for (int i = 0; i < LATCHES; i++) pthread_mutex_init(&latches[i], NULL);
+
+    BM_PoolConfig poolCfg;
+    initPoolConfig(&poolCfg);
+    poolCfg.ioWorkers = cfg.ioWorkers;
+    poolCfg.writeCoalesceWindow = cfg.coalesce;
+    if (initBufferPoolWithConfig(&pool, cfg.fileName, cfg.poolPages, cfg.strat, NULL, &poolCfg) != RC_OK) {
+        fprintf(stderr, "cannot open the buffer pool\n");
+        return 1;
+    }
+
+    Client *clients = calloc(cfg.threads, sizeof(Client));
+    for (int i = 0; i < cfg.threads; i++) {
+        clients[i].id = i;
+        clients[i].homeWarehouse = i % cfg.warehouses + 1;
+        clients[i].rng = (cfg.seed + 1) * 0x9E3779B97F4A7C15ULL + (unsigned long long) (i + 1) * 7919;
+        clients[i].latency = malloc(sizeof(long long) * cfg.txnsPerThread);
+    }
+    pthread_t checkpointer;
+    stopCheckpoint = 0;
+    if (cfg.checkpointMs > 0) pthread_create(&checkpointer, NULL, checkpointMain, NULL);
+
+    PerfCounters counters;
+    if (perf) perfStart(&counters);
+    long long start = nowNanos();
+    for (int i = 0; i < cfg.threads; i++)
+        pthread_create(&clients[i].thread, NULL, clientMain, &clients[i]);
+    for (int i = 0; i < cfg.threads; i++)
+        pthread_join(clients[i].thread, NULL);
+    double seconds = (nowNanos() - start) / 1e9;
+    if (perf) perfStop(&counters);
+
+    if (cfg.checkpointMs > 0) {
+        pthread_mutex_lock(&checkpointLock);
+        stopCheckpoint = 1;
+        pthread_cond_signal(&checkpointCond);
+        pthread_mutex_unlock(&checkpointLock);
+        pthread_join(checkpointer, NULL);
+    }
+    int readIO = getNumReadIO(&pool);
+    int writeIO = getNumWriteIO(&pool);
+    int consistent = checkConsistency();
+    shutdownBufferPool(&pool);
+    destroyPageFile((char *) cfg.fileName);
+
+    long txns = 0, newOrders = 0, payments = 0, accesses = 0, errors = 0;
+    for (int i = 0; i < cfg.threads; i++) {
+        txns += clients[i].txns;
+        newOrders += clients[i].newOrders;
+        payments += clients[i].payments;
+        accesses += clients[i].pageAccesses;
+        errors += clients[i].errors;
+    }
+    long long *all = malloc(sizeof(long long) * txns);
+    long n = 0;
+    for (int i = 0; i < cfg.threads; i++) {
+        memcpy(all + n, clients[i].latency, sizeof(long long) * clients[i].txns);
+        n += clients[i].txns;
+        free(clients[i].latency);
+    }
+    qsort(all, n, sizeof(long long), compareLL);
+
+    if (header) {
+        printf("strategy,poolPages,dbPages,warehouses,threads,newOrderPercent,checkpointMs,"
+               "seconds,txns,tps,newOrders,payments,errors,p50us,p95us,p99us,maxus,"
+               "readIO,writeIO,hitRatio,consistent");
+        if (perf) perfPrintHeader();
+        printf("\n");
+    }
+    printf("%s,%d,%d,%d,%d,%d,%d,%.4f,%ld,%.0f,%ld,%ld,%ld,%.1f,%.1f,%.1f,%.1f,%d,%d,%.4f,%d",
+           strategyNames[cfg.strat], cfg.poolPages, totalPages, cfg.warehouses, cfg.threads,
+           cfg.newOrderPercent, cfg.checkpointMs, seconds, txns, seconds > 0 ? txns / seconds : 0,
+           newOrders, payments, errors,
+           all[n / 2] / 1e3, all[(long) (n * 0.95)] / 1e3, all[(long) (n * 0.99)] / 1e3,
+           all[n - 1] / 1e3, readIO, writeIO,
+           accesses ? 1.0 - (double) readIO / accesses : 0, consistent);
+    if (perf) perfPrintPerOp(&counters, txns);
+    printf("\n");
+    free(all);
+    free(clients);
+    return errors || !consistent ? 1 : 0;
+}
@@ -0,0 +1,104 @@
+// pthreads and clock_gettime are POSIX, not plain C99
+#define _POSIX_C_SOURCE 200809L
+
+#include "bm_trace.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+
+#define TRACE_HEADER "# bm trace 1"
+#define TRACE_BUFFER (1 << 16)
+
+struct TraceLog {
+    FILE *out;
+    pthread_mutex_t lock;  // one line at a time, in timestamp order
+    long long start;
+};
+
+// Logs opened and threads seen by this process
+static int logsOpened;
+static int threadsSeen;
+static __thread int threadId = -1;
+
+static long long nowNanos(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long) ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static int currentThread(void) {
+    if (threadId < 0) threadId = __atomic_fetch_add(&threadsSeen, 1, __ATOMIC_RELAXED);
+    return threadId;
+}
+
+TraceLog *openTraceLog(const char *path) {
+    int n = __atomic_fetch_add(&logsOpened, 1, __ATOMIC_RELAXED);
+    size_t len = strlen(path);
+    char *name = malloc(len + 16);
+    if (n == 0) strcpy(name, path);
+    else sprintf(name, "%s.%d", path, n);
+    FILE *out = fopen(name, "w");
+    free(name);
+    if (!out) return NULL;
+    TraceLog *log = malloc(sizeof(TraceLog));
+    log->out = out;
+    // calls are logged from the hot path; let stdio batch the writes
+    setvbuf(out, NULL, _IOFBF, TRACE_BUFFER);
+    pthread_mutex_init(&log->lock, NULL);
+    fprintf(out, "%s\n", TRACE_HEADER);
+    log->start = nowNanos();
+    return log;
+}
+
+void traceInit(TraceLog *log, int numPages, int strategy, const char *pageFile) {
+    int thread = currentThread();
+    pthread_mutex_lock(&log->lock);
+    fprintf(log->out, "%lld %d %c %d %d %s\n", nowNanos() - log->start, thread,
+            TRACE_INIT, numPages, strategy, pageFile);
+    pthread_mutex_unlock(&log->lock);
+}
+
+void traceCall(TraceLog *log, char op, int page) {
+    int thread = currentThread();
+    // the clock is read under the lock so the file stays in time order
+    pthread_mutex_lock(&log->lock);
+    fprintf(log->out, "%lld %d %c %d\n", nowNanos() - log->start, thread, op, page);
+    pthread_mutex_unlock(&log->lock);
+}
+
+void closeTraceLog(TraceLog *log) {
+    fclose(log->out);
+    pthread_mutex_destroy(&log->lock);
+    free(log);
+}
+
+RC readTraceRecord(FILE *in, TraceRecord *rec) {
+    // room for an INIT line with the longest name
+    char line[TRACE_NAME_MAX + 128];
+    do {
+        if (!fgets(line, sizeof(line), in)) return RC_RM_NO_MORE_TUPLES;
+    } while (line[0] == '#' || line[0] == '\n');
+    size_t len = strlen(line);
+    if (line[len - 1] == '\n') line[--len] = '\0';
+    else if (!feof(in)) return RC_READ_NON_EXISTING_PAGE; // too long
+    int used = 0;
+    if (sscanf(line, "%lld %d %c %n", &rec->nanos, &rec->thread, &rec->op, &used) < 3)
+        return RC_READ_NON_EXISTING_PAGE;
+    rec->numPages = rec->strategy = 0;
+    rec->pageFile[0] = '\0';
+    if (rec->op == TRACE_INIT) {
+        int name = 0;
+        if (sscanf(line + used, "%d %d%n", &rec->numPages, &rec->strategy, &name) < 2)
+            return RC_READ_NON_EXISTING_PAGE;
+        // the name is the rest of the line after one space, so it may hold
+        // spaces, leading ones too
+        if (line[used + name] == ' ') name++;
+        if (strlen(line + used + name) >= TRACE_NAME_MAX) return RC_READ_NON_EXISTING_PAGE;
+        strcpy(rec->pageFile, line + used + name);
+        rec->page = -1;
+        return RC_OK;
+    }
+    return sscanf(line + used, "%d", &rec->page) == 1 ? RC_OK : RC_READ_NON_EXISTING_PAGE;
+}
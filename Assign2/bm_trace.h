@@ -0,0 +1,58 @@
+#ifndef BM_TRACE_H
+#define BM_TRACE_H
+
+#include <stdio.h>
+
+#include "dberror.h"
+
+// Record of the buffer manager API calls of one pool, written when the pool
+// is opened with BM_PoolConfig.traceFile set (initPoolConfig takes it from
+// the BM_TRACE environment variable) and re-driven by bench_replay. After a
+// "# bm trace 1" header there is one text line per call:
+//
+//   <nanos> <thread> I <numPages> <strategy> <pageFile>   initBufferPool
+//   <nanos> <thread> <op> <page>                          everything else
+//
+// with op P pinPage, D markDirty, U unpinPage, F forcePage, L forceFlushPool
+// and S shutdownBufferPool (page -1 for the last two). pageFile is the rest
+// of its line, spaces included, up to TRACE_NAME_MAX - 1 bytes. nanos count
+// from the pool's init, threads are numbered 0, 1, ... in the order they
+// first call into a traced pool. Calls are recorded on entry, whatever they
+// return; pinExtent and pinSwip record a P per page, the extent and swip
+// unpins a U.
+#define TRACE_NAME_MAX 4096 // PATH_MAX on Linux, with the '\0'
+
+#define TRACE_INIT     'I'
+#define TRACE_PIN      'P'
+#define TRACE_DIRTY    'D'
+#define TRACE_UNPIN    'U'
+#define TRACE_FORCE    'F'
+#define TRACE_FLUSH    'L'
+#define TRACE_SHUTDOWN 'S'
+
+typedef struct TraceLog TraceLog;
+
+// One parsed line; numPages, strategy and pageFile are only set for 'I'
+typedef struct TraceRecord {
+	long long nanos;
+	int thread;
+	char op;
+	int page;
+	int numPages;
+	int strategy;
+	char pageFile[TRACE_NAME_MAX];
+} TraceRecord;
+
+// Create the trace file. Every log after the first one of a process gets
+// ".<n>" appended to path, so pools opened under one BM_TRACE do not
+// overwrite each other. NULL when the file cannot be created.
+TraceLog *openTraceLog (const char *path);
+void traceInit (TraceLog *log, int numPages, int strategy, const char *pageFile);
+void traceCall (TraceLog *log, char op, int page);
+void closeTraceLog (TraceLog *log);
+
+// Read the next record of a trace; RC_OK, RC_RM_NO_MORE_TUPLES at the end,
+// RC_READ_NON_EXISTING_PAGE for a line that does not parse
+RC readTraceRecord (FILE *in, TraceRecord *rec);
+
+#endif
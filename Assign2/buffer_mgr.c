@@ -3,28 +3,129 @@
 #define true 1
 #define false 0
 
+// strdup and pthreads are POSIX, not plain C99
+#define _POSIX_C_SOURCE 200809L
+
 #include "buffer_mgr.h"
 #include "storage_mgr.h"
 #include "dberror.h"
 #include "buffer_mgr_stat.h"
 #include "dt.h"
+#include "frame_arena.h"
+#include "cgroup_mem.h"
+#include "probes.h"
+#include "bm_trace.h"
+#include "mrc.h"
 #include <stdlib.h>
 #include <string.h>
+#include <pthread.h>
+#include <time.h>
+
+// pinCount value while a frame is claimed for replacement or write-back
+#define PIN_EVICTING -1
+
+// Pin calls are counted per thread, in stripes of one cache line each that
+// are summed on read, so a lock-free hit writes no line other threads use
+#define PIN_STRIPES 64
+#define CACHE_LINE 64
+typedef struct PinStripe {
+    unsigned long count;
+    char pad[CACHE_LINE - sizeof(unsigned long)];
+} PinStripe;
+
+// GCC/Clang atomic builtins (C99 has no <stdatomic.h>)
+#define LOAD_ACQ(p)      __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define STORE_REL(p, v)  __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define LOAD_RLX(p)      __atomic_load_n((p), __ATOMIC_RELAXED)
+#define STORE_RLX(p, v)  __atomic_store_n((p), (v), __ATOMIC_RELAXED)
+#define CAS(p, exp, v)   __atomic_compare_exchange_n((p), (exp), (v), false, \
+                                                     __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+
+// Frame I/O states; the latch guards changes, waiters sleep on ioCond
+#define IO_NONE 0
+#define IO_LOADING 1 // write-back of evictedPage (if any), then read of pageId
+#define IO_WRITING 2 // background evictor writing the page back
+
+// Unswizzled swips carry the page number tagged with the low bit
+#define SWIP_UNSWIZZLED(w) ((w) & 1)
+#define SWIP_PAGE(w)       ((PageNumber) ((w) >> 1))
+#define SWIP_WORD(pid)     (((uintptr_t) (pid) << 1) | 1)
+
+// Feed a pin to the hit ratio curve estimate if the page is sampled
+#define SAMPLE_PIN(md, pid) do { \
+        if ((md)->curveOn && mrcSampled(&(md)->curve, (pid))) mrcAccess(&(md)->curve, (pid)); \
+    } while (0)
+
+// Record an API call of a traced pool; a single branch when tracing is off
+#define TRACE(md, op, page) do { if ((md)->trace) traceCall((md)->trace, (op), (page)); } while (0)
 
 // Frame structure for buffer pool slots
 typedef struct Frame {
     PageNumber pageId;
     char *data;
     bool isDirty;
-    int pinCount;
+    int pinCount;          // atomic; PIN_EVICTING while being replaced
+    unsigned char refBit;  // CLOCK reference bit (a small counter for GCLOCK)
+    int hashNext;          // next frame index in the page table chain
+    BM_Swip *swips;        // swizzled references to this frame
+    int ioState;
+    PageNumber evictedPage;// dirty page the load writes back first, or NO_PAGE
+    bool ioSyncOwner;      // a blocking pinPage is waiting for this load
+    RC ioRc;               // result of the last load
+    long long wbNanos;     // time the last load spent writing back evictedPage
+    RC wbRc;               // result of that write-back
+    // write-back run around evictedPage: wbRun[0..wbCount) hold the pages
+    // wbFirst.. in order, this frame included, the others claimed IO_WRITING
+    struct Frame **wbRun;
+    PageNumber wbFirst;
+    int wbCount;
+    struct AsyncPin *ioWaiters; // async pins completed by the load
+    struct Frame *ioNext;  // I/O worker queue link
+    int node;              // partition whose arena holds data
+    unsigned char prio;    // BM_PagePriority of the page held (latch)
+    int owner;             // client that loaded the page, -1 if none (latch)
     struct Frame *prev, *next; // for LRU list
 } Frame;
 
+// Async pin waiting for a frame load or a write-back
+typedef struct AsyncPin {
+    PageNumber pid;
+    RC rc;                 // result, once it is handed to the completion thread
+    BM_PageHandle *ph;
+    BM_PinCallback callback;
+    void *ctx;
+    struct AsyncPin *next;
+} AsyncPin;
+
+// Frames [first, end) of one NUMA node, backed by memory placed on it
+typedef struct NodePart {
+    int first, end;
+    int nextUnused;        // frames [first, nextUnused) have been loaded at least once
+    int clockHand;
+    FrameArena arena;
+} NodePart;
+
+// Retention hint for the pages [first, last]
+typedef struct PrioRange {
+    PageNumber first, last;
+    BM_PagePriority prio;
+} PrioRange;
+
+// Quota state of an open client
+typedef struct ClientState {
+    bool open;
+    int quota;
+    int frames;            // frames holding pages this client loaded
+} ClientState;
+
 // Metadata for buffer pool
 typedef struct PoolMetadata {
+    BM_BufferPool *bm;     // owning pool, passed to async callbacks
     SM_FileHandle fh;
     Frame *frames;
     int capacity;
+    int resident;          // frames holding or loading a page
+    int poolSize;          // frames allowed to be resident, at most capacity
     ReplacementStrategy strat;
     unsigned readIO;
     unsigned writeIO;
@@ -33,8 +134,232 @@ typedef struct PoolMetadata {
     int fifoCount;
     Frame *lruHead;
     Frame *lruTail;
+    int clockMax;          // 1 = plain CLOCK, > 1 = GCLOCK
+    int *pageTable;        // hash buckets holding frame indexes, chained by hashNext
+    int tableMask;
+    pthread_mutex_t latch; // page table changes, replacement, frame I/O state
+    pthread_cond_t ioCond; // broadcast with the latch when a load finishes
+    pthread_mutex_t fileLock; // SM_FileHandle is not thread-safe
+    int writebacks;        // loads still writing back an evicted page
+    unsigned long failedWrites; // write-backs that failed; the page stayed dirty
+    // dirty unpinned neighbours written along with a dirty victim, up to
+    // coalesceWindow pages on each side
+    int coalesceWindow;
+    Frame **wbRuns;        // wbRun storage, 2 * coalesceWindow + 1 per frame
+    unsigned long coalescedPages;
+    // I/O workers serving misses
+    pthread_mutex_t queueLock;
+    pthread_cond_t queueCond;
+    Frame *queueHead, *queueTail;
+    struct AsyncPin *busyPins;  // async pins waiting for a write-back of their page (latch)
+    struct AsyncPin *retryPins; // busy pins handed back to the workers (queueLock)
+    // finished async pins whose callbacks the completion thread runs, so a
+    // callback may block on a miss without holding up a worker (queueLock)
+    struct AsyncPin *donePins, *doneTail;
+    pthread_cond_t doneCond;
+    pthread_t completer;
+    bool stopCompleter;
+    pthread_t *workers;
+    int numWorkers;
+    bool stopWorkers;
+    // free frames refilled by the background evictor (claimed, clean, unmapped)
+    int *freeList;
+    int freeCount;
+    int freeLow, freeHigh;
+    pthread_t evictor;
+    pthread_cond_t evictCond;
+    bool evictorRunning;
+    bool stopEvictor;
+    unsigned long fgEvictions, bgEvictions;
+    long long fgEvictNanos, bgEvictNanos;
+    // NUMA partitions (a single one covering all frames when disabled)
+    NodePart *parts;
+    int numParts;
+    unsigned long remoteAccesses, remoteAllocs;
+    // pin calls (see countPins) and storage-call latency histograms
+    // (atomic, see noteLatency)
+    PinStripe *pinStripes;
+    unsigned long readLatency[BM_LATENCY_BUCKETS], writeLatency[BM_LATENCY_BUCKETS];
+    long long readNanos, writeNanos;
+    // adaptive sizing from cgroup memory state
+    int minSize;
+    char *cgroupDir;
+    int resizeMs;
+    pthread_t sizer;
+    pthread_cond_t sizerCond;
+    bool sizerRunning;
+    bool stopSizer;
+    // page priority hints (latch); later ranges override earlier ones
+    PrioRange *prioRanges;
+    int numPrioRanges, maxPrioRanges;
+    int highFrames;        // resident frames above BM_PRIO_NORMAL
+    int keepFrames, keepMax; // the bounded keep-resident set
+    int keepConfig;        // BM_PoolConfig.keepResidentMax; 0 = a quarter of the pool
+    // clients with frame quotas (latch), indexed by BM_Client.id
+    ClientState *clients;
+    int numClients;
+    TraceLog *trace;       // API call record, NULL when not traced
+    // hit ratio curve estimate, up to 4x the frames set up
+    bool curveOn;
+    MrcEstimator curve;
 } PoolMetadata;
 
+// Monotonic clock for eviction timing
+static long long nowNanos(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long) ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// Partition local to the calling thread
+static int currentPart(PoolMetadata *md) {
+    if (md->numParts == 1) return 0;
+    return currentNumaNode() % md->numParts;
+}
+
+// Threads seen by countPins; each takes the next stripe
+static int pinThreads;
+static __thread int pinStripe = -1;
+
+// Count n pin calls in the calling thread's stripe
+static void countPins(PoolMetadata *md, unsigned long n) {
+    if (pinStripe < 0) pinStripe = __atomic_fetch_add(&pinThreads, 1, __ATOMIC_RELAXED) % PIN_STRIPES;
+    __atomic_fetch_add(&md->pinStripes[pinStripe].count, n, __ATOMIC_RELAXED);
+}
+
+static unsigned long totalPins(PoolMetadata *md) {
+    unsigned long pins = 0;
+    for (int i = 0; i < PIN_STRIPES; i++) pins += LOAD_RLX(&md->pinStripes[i].count);
+    return pins;
+}
+
+// Count a pin of a frame whose memory lives on another node
+static void noteAccess(PoolMetadata *md, Frame *f) {
+    if (md->numParts > 1 && f->node != currentPart(md))
+        __atomic_fetch_add(&md->remoteAccesses, 1, __ATOMIC_RELAXED);
+}
+
+// Count a read or write call that took nanos in its latency histogram
+static void noteLatency(PoolMetadata *md, bool write, long long nanos) {
+    long long us = nanos / 1000;
+    int b = 0;
+    while (b < BM_LATENCY_BUCKETS - 1 && us >= (1LL << b)) b++;
+    __atomic_fetch_add(write ? &md->writeLatency[b] : &md->readLatency[b], 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(write ? &md->writeNanos : &md->readNanos, nanos, __ATOMIC_RELAXED);
+}
+
+// Write one page back under fileLock, timed for the latency histogram
+static RC writeFramePage(PoolMetadata *md, PageNumber pid, char *data) {
+    pthread_mutex_lock(&md->fileLock);
+    long long start = nowNanos();
+    RC rc = writeBlock(pid, &md->fh, data);
+    noteLatency(md, true, nowNanos() - start);
+    pthread_mutex_unlock(&md->fileLock);
+    return rc;
+}
+
+// Absolute CLOCK_REALTIME time ms from now, for pthread_cond_timedwait
+static void deadlineAfter(struct timespec *until, long ms) {
+    clock_gettime(CLOCK_REALTIME, until);
+    until->tv_sec += ms / 1000;
+    until->tv_nsec += (ms % 1000) * 1000000;
+    if (until->tv_nsec >= 1000000000) {
+        until->tv_sec++;
+        until->tv_nsec -= 1000000000;
+    }
+}
+
+// Bucket for a page number in the page table
+static int hashPage(PoolMetadata *md, PageNumber pid) {
+    return (int)(((unsigned) pid * 2654435761u) & (unsigned) md->tableMask);
+}
+
+// Probe the page table without the latch. Chains may be relinked
+// under us, so callers must validate the frame by pinning it.
+static Frame *lookupFrame(PoolMetadata *md, PageNumber pid) {
+    int idx = LOAD_ACQ(&md->pageTable[hashPage(md, pid)]);
+    for (int steps = 0; idx >= 0 && steps < md->capacity; steps++) {
+        Frame *f = &md->frames[idx];
+        if (LOAD_ACQ(&f->pageId) == pid) return f;
+        idx = LOAD_ACQ(&f->hashNext);
+    }
+    return NULL;
+}
+
+// Link a frame into its bucket (latch held)
+static void tableInsert(PoolMetadata *md, Frame *f) {
+    int b = hashPage(md, f->pageId);
+    STORE_REL(&f->hashNext, md->pageTable[b]);
+    STORE_REL(&md->pageTable[b], (int)(f - md->frames));
+}
+
+// Unlink a frame from its bucket (latch held)
+static void tableRemove(PoolMetadata *md, Frame *f) {
+    int idx = (int)(f - md->frames);
+    int *link = &md->pageTable[hashPage(md, f->pageId)];
+    while (*link >= 0) {
+        if (*link == idx) {
+            STORE_REL(link, f->hashNext);
+            return;
+        }
+        link = &md->frames[*link].hashNext;
+    }
+}
+
+// Pin a frame unless it is being replaced
+static bool pinFrame(Frame *f) {
+    int cnt = LOAD_ACQ(&f->pinCount);
+    do {
+        if (cnt < 0) return false;
+    } while (!CAS(&f->pinCount, &cnt, cnt + 1));
+    return true;
+}
+
+// Pin a frame, then make sure it still holds pid
+static bool tryPin(Frame *f, PageNumber pid) {
+    if (!pinFrame(f)) return false;
+    if (LOAD_ACQ(&f->pageId) != pid) {
+        __atomic_fetch_sub(&f->pinCount, 1, __ATOMIC_RELEASE);
+        return false;
+    }
+    return true;
+}
+
+// Claim an unpinned frame so that lock-free pins back off
+static bool claimFrame(Frame *f) {
+    int zero = 0;
+    return CAS(&f->pinCount, &zero, PIN_EVICTING);
+}
+
+// Find the frame holding pid; falls back to the latch if the lock-free probe
+// raced with a relink. Only safe for frames the caller keeps pinned.
+static Frame *findFrame(PoolMetadata *md, PageNumber pid) {
+    Frame *f = lookupFrame(md, pid);
+    if (f) return f;
+    pthread_mutex_lock(&md->latch);
+    f = lookupFrame(md, pid);
+    pthread_mutex_unlock(&md->latch);
+    return f;
+}
+
+// Record a CLOCK reference: one relaxed store, skipped if already set
+static void touchFrame(PoolMetadata *md, Frame *f) {
+    unsigned char ref = LOAD_RLX(&f->refBit);
+    if (ref < md->clockMax) STORE_RLX(&f->refBit, ref + 1);
+}
+
+// Point every swip of a claimed frame back at its page number (latch held)
+static void unswizzleFrame(Frame *f) {
+    BM_Swip *s = f->swips;
+    while (s) {
+        BM_Swip *next = s->nextRef;
+        s->nextRef = NULL;
+        STORE_REL(&s->word, SWIP_WORD(f->pageId));
+        s = next;
+    }
+    f->swips = NULL;
+}
+
 // Move frame to head of LRU list
 static void moveToLRUHead(PoolMetadata *md, Frame *f) {
     if (!f || md->lruHead == f) return;
@@ -48,36 +373,602 @@ static void moveToLRUHead(PoolMetadata *md, Frame *f) {
     if (!md->lruTail) md->lruTail = f;
 }
 
-// Select a victim frame using FIFO or LRU
-static Frame *selectVictim(PoolMetadata *md) {
+// Unlink a frame from the LRU list
+static void removeFromLRU(PoolMetadata *md, Frame *f) {
+    if (f->prev) f->prev->next = f->next;
+    else if (md->lruHead == f) md->lruHead = f->next;
+    if (f->next) f->next->prev = f->prev;
+    else if (md->lruTail == f) md->lruTail = f->prev;
+    f->prev = f->next = NULL;
+}
+
+// Enqueue a frame index for FIFO replacement
+static void enqueueFIFO(PoolMetadata *md, int idx) {
+    int tail = (md->fifoHead + md->fifoCount) % md->capacity;
+    md->fifoQ[tail] = idx;
+    md->fifoCount++;
+}
+
+// Take a frame out of the FIFO queue, keeping the others' order
+static void removeFromFIFO(PoolMetadata *md, int idx) {
+    int count = md->fifoCount;
+    for (int i = 0; i < count; i++) {
+        int cur = md->fifoQ[md->fifoHead];
+        md->fifoHead = (md->fifoHead + 1) % md->capacity;
+        md->fifoCount--;
+        if (cur != idx) enqueueFIFO(md, cur);
+    }
+}
+
+// Can f be a victim at this priority level? owner < 0 allows any client.
+static bool victimOk(Frame *f, int maxPrio, int owner) {
+    return f->prio <= maxPrio && (owner < 0 || f->owner == owner);
+}
+
+// CLOCK sweep over the used frames of one partition; each unpinned frame
+// can be passed at most clockMax times. Never-used frames are left alone,
+// since misses still hand them out directly.
+static Frame *clockSweep(PoolMetadata *md, NodePart *part, int maxPrio, int owner) {
+    int limit = (part->nextUnused - part->first) * (md->clockMax + 1);
+    for (int i = 0; i < limit; i++) {
+        if (part->clockHand >= part->nextUnused) part->clockHand = part->first;
+        Frame *f = &md->frames[part->clockHand++];
+        if (LOAD_RLX(&f->pinCount) != 0 || !victimOk(f, maxPrio, owner)) continue;
+        unsigned char ref = LOAD_RLX(&f->refBit);
+        if (ref > 0) {
+            STORE_RLX(&f->refBit, ref - 1);
+            continue;
+        }
+        if (claimFrame(f)) return f;
+    }
+    return NULL;
+}
+
+// Claim a victim with priority at most maxPrio (loaded by owner, if >= 0)
+// using FIFO, CLOCK or LRU, preferring frames of the given node's partition
+static Frame *pickVictim(PoolMetadata *md, int node, int maxPrio, int owner) {
     if (md->strat == RS_FIFO) {
         int count = md->fifoCount;
         for (int i = 0; i < count; i++) {
             int idx = md->fifoQ[md->fifoHead];
             md->fifoHead = (md->fifoHead + 1) % md->capacity;
             md->fifoCount--;
-            if (md->frames[idx].pinCount == 0)
+            if (victimOk(&md->frames[idx], maxPrio, owner) && claimFrame(&md->frames[idx]))
                 return &md->frames[idx];
+            // pinned, still loading or kept: keep its place at the back
+            enqueueFIFO(md, idx);
+        }
+        return NULL;
+    } else if (md->strat == RS_CLOCK) {
+        // local partition first, then the other nodes' hands
+        for (int p = 0; p < md->numParts; p++) {
+            Frame *f = clockSweep(md, &md->parts[(node + p) % md->numParts], maxPrio, owner);
+            if (f) return f;
         }
         return NULL;
     } else {
-        Frame *f = md->lruTail;
-        while (f && f->pinCount > 0) f = f->prev;
-        return f;
+        Frame *f;
+        if (md->numParts > 1) {
+            for (f = md->lruTail; f; f = f->prev)
+                if (f->node == node && victimOk(f, maxPrio, owner) && claimFrame(f)) return f;
+        }
+        for (f = md->lruTail; f; f = f->prev)
+            if (victimOk(f, maxPrio, owner) && claimFrame(f)) return f;
+        return NULL;
     }
 }
 
-// Enqueue a frame index for FIFO replacement
-static void enqueueFIFO(PoolMetadata *md, int idx) {
-    int tail = (md->fifoHead + md->fifoCount) % md->capacity;
-    md->fifoQ[tail] = idx;
-    md->fifoCount++;
+// Select and claim a victim: normal pages first, high-priority pages only
+// when nothing else can go, and never the keep-resident set. owner >= 0
+// restricts the choice to the pages that client loaded.
+static Frame *selectVictim(PoolMetadata *md, int node, int owner) {
+    Frame *f = pickVictim(md, node, BM_PRIO_NORMAL, owner);
+    if (!f && md->highFrames > md->keepFrames)
+        f = pickVictim(md, node, BM_PRIO_HIGH, owner);
+    return f;
+}
+
+// Charge a frame to a client, or to nobody with -1 (latch held)
+static void setFrameOwner(PoolMetadata *md, Frame *f, int owner) {
+    if (f->owner >= 0) md->clients[f->owner].frames--;
+    if (owner >= 0) md->clients[owner].frames++;
+    f->owner = owner;
+}
+
+// Priority hint for a page (latch held)
+static BM_PagePriority pagePriority(PoolMetadata *md, PageNumber pid) {
+    for (int i = md->numPrioRanges - 1; i >= 0; i--)
+        if (pid >= md->prioRanges[i].first && pid <= md->prioRanges[i].last)
+            return md->prioRanges[i].prio;
+    return BM_PRIO_NORMAL;
+}
+
+static void promoteKeepers(PoolMetadata *md);
+
+// Change a frame's priority, demoting keep requests to BM_PRIO_HIGH once
+// the keep-resident set is full (latch held)
+static void setFramePrio(PoolMetadata *md, Frame *f, BM_PagePriority prio) {
+    if (f->prio == prio) return;
+    bool leftKeep = f->prio == BM_PRIO_KEEP;
+    if (f->prio == BM_PRIO_KEEP) md->keepFrames--;
+    if (f->prio != BM_PRIO_NORMAL) md->highFrames--;
+    if (prio == BM_PRIO_KEEP && md->keepFrames >= md->keepMax) prio = BM_PRIO_HIGH;
+    if (prio == BM_PRIO_KEEP) md->keepFrames++;
+    if (prio != BM_PRIO_NORMAL) md->highFrames++;
+    f->prio = prio;
+    // a freed keep slot goes to a page that was demoted for lack of room
+    if (leftKeep) promoteKeepers(md);
+}
+
+// Give keep requests that were demoted to BM_PRIO_HIGH their place in the
+// keep-resident set again, as far as it has room (latch held)
+static void promoteKeepers(PoolMetadata *md) {
+    for (int i = 0; i < md->capacity && md->keepFrames < md->keepMax
+                    && md->highFrames > md->keepFrames; i++) {
+        Frame *f = &md->frames[i];
+        if (f->prio == BM_PRIO_HIGH && f->pageId != NO_PAGE
+            && pagePriority(md, f->pageId) == BM_PRIO_KEEP)
+            setFramePrio(md, f, BM_PRIO_KEEP);
+    }
+}
+
+// Bound the keep-resident set for the current pool size, leaving at least
+// one frame for everything else, then demote the pages over the bound or
+// promote demoted ones into new room (latch held)
+static void setKeepMax(PoolMetadata *md) {
+    md->keepMax = md->keepConfig > 0 ? md->keepConfig : md->poolSize / 4;
+    if (md->keepMax < 1) md->keepMax = 1;
+    if (md->keepMax >= md->poolSize) md->keepMax = md->poolSize - 1;
+    for (int i = md->capacity - 1; i >= 0 && md->keepFrames > md->keepMax; i--)
+        if (md->frames[i].prio == BM_PRIO_KEEP) setFramePrio(md, &md->frames[i], BM_PRIO_HIGH);
+    promoteKeepers(md);
+}
+
+// Claim page pid for the write-back run if it is resident, dirty and
+// unpinned; pins wait for IO_WRITING to clear (latch held)
+static Frame *claimNeighbour(PoolMetadata *md, PageNumber pid) {
+    if (pid < 0) return NULL;
+    Frame *f = lookupFrame(md, pid);
+    if (!f || f->ioState != IO_NONE || !LOAD_ACQ(&f->isDirty) || !claimFrame(f))
+        return NULL;
+    f->ioState = IO_WRITING;
+    return f;
+}
+
+// Extend the write-back of victim f's evictedPage to the adjacent dirty,
+// unpinned pages on both sides, stopping at the first gap (latch held)
+static void gatherWriteRun(PoolMetadata *md, Frame *f) {
+    int w = md->coalesceWindow;
+    Frame **run = f->wbRun;
+    int below = 0, above = 0;
+    while (below < w && (run[w - below - 1] = claimNeighbour(md, f->evictedPage - below - 1)))
+        below++;
+    run[w] = f;
+    while (above < w && (run[w + above + 1] = claimNeighbour(md, f->evictedPage + above + 1)))
+        above++;
+    if (below < w) memmove(run, run + w - below, sizeof(Frame *) * (below + above + 1));
+    f->wbFirst = f->evictedPage - below;
+    f->wbCount = below + above + 1;
+}
+
+// Write back the evicted page (if any) and read the new one; runs without
+// the latch so other pins proceed during the I/O
+static RC loadFrameData(PoolMetadata *md, Frame *f) {
+    RC rc = RC_OK;
+    pthread_mutex_lock(&md->fileLock);
+    f->wbNanos = 0;
+    f->wbRc = RC_OK;
+    if (f->evictedPage != NO_PAGE) {
+        long long start = nowNanos();
+        if (f->wbCount > 1) {
+            SM_PageHandle pages[f->wbCount];
+            for (int i = 0; i < f->wbCount; i++) pages[i] = f->wbRun[i]->data;
+            rc = writeBlocks(f->wbFirst, f->wbCount, &md->fh, pages);
+        } else {
+            rc = writeBlock(f->evictedPage, &md->fh, f->data);
+        }
+        f->wbNanos = nowNanos() - start;
+        f->wbRc = rc;
+        noteLatency(md, true, f->wbNanos);
+    }
+    if (rc == RC_OK && f->pageId >= md->fh.totalNumPages)
+        rc = ensureCapacity(f->pageId + 1, &md->fh);
+    if (rc == RC_OK) {
+        long long start = nowNanos();
+        rc = readBlock(f->pageId, &md->fh, f->data);
+        noteLatency(md, false, nowNanos() - start);
+    }
+    pthread_mutex_unlock(&md->fileLock);
+    return rc;
+}
+
+// Wake the pins waiting for I/O after a load or write-back ended: blocked
+// ones re-check, parked async ones go back to the I/O workers (latch held)
+static void wakeIoWaiters(PoolMetadata *md) {
+    pthread_cond_broadcast(&md->ioCond);
+    if (!md->busyPins) return;
+    AsyncPin *last = md->busyPins;
+    while (last->next) last = last->next;
+    pthread_mutex_lock(&md->queueLock);
+    last->next = md->retryPins;
+    md->retryPins = md->busyPins;
+    pthread_cond_signal(&md->queueCond);
+    pthread_mutex_unlock(&md->queueLock);
+    md->busyPins = NULL;
+}
+
+// Hand a finished async pin to the completion thread
+static void completePin(PoolMetadata *md, AsyncPin *pin, RC rc) {
+    pin->rc = rc;
+    pin->next = NULL;
+    pthread_mutex_lock(&md->queueLock);
+    if (md->doneTail) md->doneTail->next = pin;
+    else md->donePins = pin;
+    md->doneTail = pin;
+    pthread_cond_signal(&md->doneCond);
+    pthread_mutex_unlock(&md->queueLock);
+}
+
+// Completion thread: runs the callbacks of finished async pins in order
+static void *completerMain(void *arg) {
+    PoolMetadata *md = arg;
+    pthread_mutex_lock(&md->queueLock);
+    for (;;) {
+        while (!md->donePins && !md->stopCompleter)
+            pthread_cond_wait(&md->doneCond, &md->queueLock);
+        AsyncPin *pins = md->donePins;
+        if (!pins) break; // stopping and drained
+        md->donePins = md->doneTail = NULL;
+        pthread_mutex_unlock(&md->queueLock);
+        while (pins) {
+            AsyncPin *next = pins->next;
+            pins->callback(md->bm, pins->ph, pins->rc, pins->ctx);
+            free(pins);
+            pins = next;
+        }
+        pthread_mutex_lock(&md->queueLock);
+    }
+    pthread_mutex_unlock(&md->queueLock);
+    return NULL;
+}
+
+// Publish a finished load: hand out the pins, wake waiters and complete
+// async pins. A failed read leaves the frame empty; a failed write-back
+// puts the victim back, still dirty, and fails only the pins of the new page.
+static void finishLoad(PoolMetadata *md, Frame *f, RC rc) {
+    PROBE2(buffer, load_done, f->pageId, rc);
+    pthread_mutex_lock(&md->latch);
+    PageNumber victim = NO_PAGE;
+    if (f->evictedPage != NO_PAGE) {
+        if (f->wbRc == RC_OK) md->writeIO++;
+        else md->failedWrites++;
+        md->fgEvictNanos += f->wbNanos;
+        md->writebacks--;
+        if (f->wbRc != RC_OK) victim = f->evictedPage;
+        f->evictedPage = NO_PAGE;
+        // release the neighbours, clean unless the write failed
+        for (int i = 0; i < f->wbCount; i++) {
+            Frame *g = f->wbRun[i];
+            if (g == f) continue;
+            if (f->wbRc == RC_OK) {
+                STORE_RLX(&g->isDirty, false);
+                md->writeIO++;
+                md->coalescedPages++;
+            } else {
+                md->failedWrites++;
+            }
+            g->ioState = IO_NONE;
+            STORE_REL(&g->pinCount, 0);
+        }
+        f->wbCount = 0;
+    }
+    // the read is skipped when the write-back failed
+    if (victim == NO_PAGE) md->readIO++;
+    AsyncPin *waiters = f->ioWaiters;
+    int pins = f->ioSyncOwner ? 1 : 0;
+    f->ioWaiters = NULL;
+    f->ioRc = rc;
+    if (rc == RC_OK) {
+        for (AsyncPin *w = waiters; w; w = w->next) pins++;
+    } else {
+        tableRemove(md, f);
+        // the frame still holds the victim's data, which is not on disk
+        STORE_REL(&f->pageId, victim);
+        STORE_RLX(&f->isDirty, victim != NO_PAGE);
+        setFramePrio(md, f, victim != NO_PAGE && md->numPrioRanges
+                     ? pagePriority(md, victim) : BM_PRIO_NORMAL);
+        setFrameOwner(md, f, -1);
+        if (victim != NO_PAGE) tableInsert(md, f);
+    }
+    // the blocking owner keeps its pin even on failure and drops it itself
+    STORE_REL(&f->pinCount, pins);
+    f->ioState = IO_NONE;
+    wakeIoWaiters(md);
+    pthread_mutex_unlock(&md->latch);
+
+    while (waiters) {
+        AsyncPin *next = waiters->next;
+        if (rc == RC_OK) {
+            waiters->ph->pageNum = f->pageId;
+            waiters->ph->data = f->data;
+        }
+        completePin(md, waiters, rc);
+        waiters = next;
+    }
+}
+
+static RC pinPageLatched(PoolMetadata *md, BM_PageHandle *ph, PageNumber pid,
+                         AsyncPin *req, int owner);
+
+// Try parked async pins again; each one completes, joins a load or is
+// parked again behind a write-back that is still running
+static void retryPins(PoolMetadata *md, AsyncPin *pins) {
+    while (pins) {
+        AsyncPin *next = pins->next;
+        pthread_mutex_lock(&md->latch);
+        RC rc = pinPageLatched(md, pins->ph, pins->pid, pins, -1);
+        pthread_mutex_unlock(&md->latch);
+        if (rc != RC_BM_PIN_PENDING) completePin(md, pins, rc);
+        pins = next;
+    }
+}
+
+// I/O worker: loads queued frames and retries parked async pins
+static void *ioWorker(void *arg) {
+    PoolMetadata *md = arg;
+    pthread_mutex_lock(&md->queueLock);
+    for (;;) {
+        while (!md->queueHead && !md->retryPins && !md->stopWorkers)
+            pthread_cond_wait(&md->queueCond, &md->queueLock);
+        if (md->retryPins) {
+            AsyncPin *pins = md->retryPins;
+            md->retryPins = NULL;
+            pthread_mutex_unlock(&md->queueLock);
+            retryPins(md, pins);
+            pthread_mutex_lock(&md->queueLock);
+            continue;
+        }
+        Frame *f = md->queueHead;
+        if (!f) break; // stopping and drained
+        md->queueHead = f->ioNext;
+        if (!md->queueHead) md->queueTail = NULL;
+        pthread_mutex_unlock(&md->queueLock);
+        finishLoad(md, f, loadFrameData(md, f));
+        pthread_mutex_lock(&md->queueLock);
+    }
+    pthread_mutex_unlock(&md->queueLock);
+    return NULL;
+}
+
+// Hand a frame load to the I/O workers
+static void enqueueLoad(PoolMetadata *md, Frame *f) {
+    f->ioNext = NULL;
+    pthread_mutex_lock(&md->queueLock);
+    if (md->queueTail) md->queueTail->ioNext = f;
+    else md->queueHead = f;
+    md->queueTail = f;
+    pthread_cond_signal(&md->queueCond);
+    pthread_mutex_unlock(&md->queueLock);
+}
+
+// Start n I/O workers and the completion thread (latch held or pool not
+// shared yet)
+static void startWorkers(PoolMetadata *md, int n) {
+    md->workers = malloc(sizeof(pthread_t) * n);
+    for (int i = 0; i < n; i++)
+        pthread_create(&md->workers[i], NULL, ioWorker, md);
+    pthread_create(&md->completer, NULL, completerMain, md);
+    md->numWorkers = n;
+}
+
+// Is pid still being written back by some frame load? (latch held)
+static bool writebackPending(PoolMetadata *md, PageNumber pid) {
+    for (int i = 0; i < md->capacity; i++)
+        if (md->frames[i].ioState != IO_NONE && md->frames[i].evictedPage == pid)
+            return true;
+    return false;
+}
+
+// Frames a miss can take without running the replacement policy (latch held)
+static int freeFrames(PoolMetadata *md) {
+    int spare = md->poolSize - md->resident;
+    return spare > 0 ? spare : 0;
+}
+
+// Take a frame that needs no replacement: a never-used one or one the
+// evictor freed. localOnly restricts it to the node's partition. (latch held)
+static Frame *takeFreeFrame(PoolMetadata *md, int node, bool localOnly) {
+    for (int p = 0; p < md->numParts; p++) {
+        NodePart *part = &md->parts[(node + p) % md->numParts];
+        if (part->nextUnused < part->end) {
+            Frame *f = &md->frames[part->nextUnused++];
+            f->pinCount = PIN_EVICTING;
+            return f;
+        }
+        if (localOnly) break;
+    }
+    for (int i = md->freeCount - 1; i >= 0; i--) {
+        Frame *f = &md->frames[md->freeList[i]];
+        if (!localOnly || f->node == node) {
+            md->freeList[i] = md->freeList[--md->freeCount];
+            return f;
+        }
+    }
+    return NULL;
+}
+
+// Drop the page of a claimed frame from the page table and the LRU list
+// (latch held). FIFO victims already left the queue when they were picked.
+static void unmapFrame(PoolMetadata *md, Frame *f) {
+    unswizzleFrame(f);
+    tableRemove(md, f);
+    STORE_REL(&f->pageId, NO_PAGE);
+    setFramePrio(md, f, BM_PRIO_NORMAL);
+    setFrameOwner(md, f, -1);
+    if (md->strat != RS_FIFO && md->strat != RS_CLOCK) removeFromLRU(md, f);
+}
+
+// Move a claimed victim to the free list, writing it back first if dirty.
+// The page stays mapped (IO_WRITING) during the write so pinners wait for
+// it rather than reading a stale copy. Latch held, dropped for the write.
+// A failed write leaves the page mapped, dirty and unclaimed: false.
+static bool evictToFreeList(PoolMetadata *md, Frame *f) {
+    if (f->isDirty) {
+        f->ioState = IO_WRITING;
+        pthread_mutex_unlock(&md->latch);
+        RC rc = writeFramePage(md, f->pageId, f->data);
+        pthread_mutex_lock(&md->latch);
+        f->ioState = IO_NONE;
+        wakeIoWaiters(md);
+        if (rc != RC_OK) {
+            // the frame holds the only copy; FIFO victims left the queue
+            md->failedWrites++;
+            if (md->strat == RS_FIFO) enqueueFIFO(md, (int)(f - md->frames));
+            STORE_REL(&f->pinCount, 0);
+            return false;
+        }
+        md->writeIO++;
+        STORE_RLX(&f->isDirty, false);
+    }
+    unmapFrame(md, f);
+    md->freeList[md->freeCount++] = (int)(f - md->frames);
+    md->resident--;
+    return true;
+}
+
+// Evict through the replacement policy until at most poolSize frames are
+// resident and hand their memory back to the OS (latch held)
+static void shrinkPool(PoolMetadata *md) {
+    int node = 0;
+    while (md->resident > md->poolSize) {
+        Frame *victim = selectVictim(md, node, -1);
+        node = (node + 1) % md->numParts;
+        if (!victim) break; // the rest is pinned; later misses try again
+        if (!evictToFreeList(md, victim)) break; // write failed; try again later
+        releaseArenaRange(&md->parts[victim->node].arena, victim->data, PAGE_SIZE);
+    }
+}
+
+// Set the pool size within [minSize, capacity] (latch held)
+static void setPoolSize(PoolMetadata *md, int size) {
+    if (size < md->minSize) size = md->minSize;
+    if (size > md->capacity) size = md->capacity;
+    md->poolSize = size;
+    // pages over a smaller keep bound become evictable before the shrink
+    setKeepMax(md);
+    shrinkPool(md);
+    if (md->evictorRunning && freeFrames(md) < md->freeLow)
+        pthread_cond_signal(&md->evictCond);
+}
+
+// Background evictor: when free frames drop below the low watermark, run
+// the replacement policy until they are back at the high watermark
+static void *evictorMain(void *arg) {
+    PoolMetadata *md = arg;
+    int node = 0; // refill the partitions in turn
+    pthread_mutex_lock(&md->latch);
+    while (!md->stopEvictor) {
+        if (freeFrames(md) >= md->freeLow) {
+            pthread_cond_wait(&md->evictCond, &md->latch);
+            continue;
+        }
+        long long start = nowNanos();
+        bool progress = false;
+        while (freeFrames(md) < md->freeHigh && !md->stopEvictor) {
+            Frame *victim = selectVictim(md, node, -1);
+            node = (node + 1) % md->numParts;
+            if (!victim) break;
+            PROBE3(buffer, evict, victim->pageId, victim->isDirty, 1);
+            if (!evictToFreeList(md, victim)) break; // write failed; retry later
+            md->bgEvictions++;
+            progress = true;
+        }
+        md->bgEvictNanos += nowNanos() - start;
+        if (!progress) {
+            // everything is pinned; look again a little later
+            struct timespec until;
+            deadlineAfter(&until, 10);
+            pthread_cond_timedwait(&md->evictCond, &md->latch, &until);
+        }
+    }
+    pthread_mutex_unlock(&md->latch);
+    return NULL;
+}
+
+// PSI "some avg10" (percent of time stalled on memory) above which the
+// sizer shrinks the pool, and below which it may grow it
+#define PSI_SHRINK 10.0
+#define PSI_GROW 1.0
+
+// Next pool size for the cgroup's memory state: shrink by an eighth when
+// under pressure or within 10% of memory.max, grow by up to an eighth while
+// more than a quarter of the limit is free and nothing stalls
+static int adaptPoolSize(PoolMetadata *md, const CgroupMemory *mem) {
+    int step = md->poolSize / 8 > 0 ? md->poolSize / 8 : 1;
+    long long headroom = mem->max - mem->current;
+    if (mem->someAvg10 >= PSI_SHRINK || (mem->max >= 0 && headroom < mem->max / 10))
+        return md->poolSize - step;
+    if (mem->someAvg10 < PSI_GROW && mem->max < 0)
+        return md->poolSize + step;
+    if (mem->someAvg10 < PSI_GROW && headroom > mem->max / 4) {
+        long long spare = (headroom - mem->max / 4) / PAGE_SIZE;
+        return md->poolSize + (spare < step ? (int) spare : step);
+    }
+    return md->poolSize;
+}
+
+// Sizer thread: re-reads the cgroup every resizeMs and resizes the pool
+static void *sizerMain(void *arg) {
+    PoolMetadata *md = arg;
+    pthread_mutex_lock(&md->latch);
+    while (!md->stopSizer) {
+        CgroupMemory mem;
+        pthread_mutex_unlock(&md->latch);
+        RC rc = readCgroupMemory(md->cgroupDir, &mem);
+        pthread_mutex_lock(&md->latch);
+        if (rc == RC_OK && !md->stopSizer) setPoolSize(md, adaptPoolSize(md, &mem));
+        if (md->stopSizer) break;
+        struct timespec until;
+        deadlineAfter(&until, md->resizeMs);
+        pthread_cond_timedwait(&md->sizerCond, &md->latch, &until);
+    }
+    pthread_mutex_unlock(&md->latch);
+    return NULL;
+}
+
+// Default pool configuration
+void initPoolConfig(BM_PoolConfig *cfg) {
+    cfg->ioWorkers = 0;
+    cfg->freeLowWatermark = 0;
+    cfg->freeHighWatermark = 0;
+    cfg->numaNodes = 0;
+    cfg->minPages = 0;
+    cfg->maxPages = 0;
+    cfg->cgroupPath = NULL;
+    cfg->resizeIntervalMs = 1000;
+    cfg->keepResidentMax = 0;
+    cfg->writeCoalesceWindow = 0;
+    // lets an unmodified program be traced
+    cfg->traceFile = getenv("BM_TRACE");
+    cfg->hitRatioCurve = 0;
 }
 
 // Initialize the buffer pool
 RC initBufferPool(BM_BufferPool *bm, const char *pageFileName,
                   int numPages, ReplacementStrategy strat,
                   void *stratData) {
+    return initBufferPoolWithConfig(bm, pageFileName, numPages, strat, stratData, NULL);
+}
+
+// Initialize the buffer pool with explicit options (NULL = defaults)
+RC initBufferPoolWithConfig(BM_BufferPool *bm, const char *pageFileName,
+                            int numPages, ReplacementStrategy strat,
+                            void *stratData, const BM_PoolConfig *cfg) {
+    BM_PoolConfig defaults;
+    if (!cfg) {
+        initPoolConfig(&defaults);
+        cfg = &defaults;
+    }
     SM_FileHandle fh;
     RC rc = openPageFile((char *)pageFileName, &fh);
     if (rc == RC_FILE_NOT_FOUND) {
@@ -85,25 +976,152 @@ RC initBufferPool(BM_BufferPool *bm, const char *pageFileName,
     }
     CHECK(rc);
 
+    // an adaptive pool sets up frames for its maximum size; arena memory
+    // is only faulted in once a frame is used
+    int capacity = numPages;
+    if (cfg->maxPages > capacity) capacity = cfg->maxPages;
+
     PoolMetadata *md = malloc(sizeof(PoolMetadata));
     md->fh = fh;
-    md->capacity = numPages;
+    md->capacity = capacity;
+    md->resident = 0;
+    md->minSize = cfg->minPages < 1 ? 1 : cfg->minPages;
+    if (md->minSize > numPages) md->minSize = numPages;
+    md->poolSize = numPages;
     md->strat = strat;
     md->readIO = md->writeIO = 0;
-    md->frames = calloc(numPages, sizeof(Frame));
-    for (int i = 0; i < numPages; i++) {
+    md->frames = calloc(capacity, sizeof(Frame));
+    if (posix_memalign((void **) &md->pinStripes, CACHE_LINE, sizeof(PinStripe) * PIN_STRIPES) != 0) {
+        free(md->frames);
+        free(md);
+        closePageFile(&fh);
+        return RC_BM_OUT_OF_MEMORY;
+    }
+    memset(md->pinStripes, 0, sizeof(PinStripe) * PIN_STRIPES);
+
+    // one arena per partition; with a single partition nothing is placed
+    int numParts = cfg->numaNodes < 0 ? numaNodeCount() : cfg->numaNodes;
+    if (numParts < 1) numParts = 1;
+    if (numParts > capacity) numParts = capacity;
+    md->numParts = numParts;
+    md->parts = calloc(numParts, sizeof(NodePart));
+    for (int p = 0; p < numParts; p++) {
+        NodePart *part = &md->parts[p];
+        part->first = (int) ((long) capacity * p / numParts);
+        part->end = (int) ((long) capacity * (p + 1) / numParts);
+        part->nextUnused = part->clockHand = part->first;
+        rc = allocFrameArena(&part->arena, (size_t) (part->end - part->first) * PAGE_SIZE,
+                             numParts > 1 ? p : -1);
+        if (rc != RC_OK) {
+            while (p-- > 0) freeFrameArena(&md->parts[p].arena);
+            free(md->parts);
+            free(md->frames);
+            free(md->pinStripes);
+            free(md);
+            closePageFile(&fh);
+            return rc;
+        }
+        for (int i = part->first; i < part->end; i++) {
+            md->frames[i].node = p;
+            md->frames[i].data = part->arena.base + (size_t) (i - part->first) * PAGE_SIZE;
+        }
+    }
+    md->remoteAccesses = md->remoteAllocs = 0;
+    memset(md->readLatency, 0, sizeof(md->readLatency));
+    memset(md->writeLatency, 0, sizeof(md->writeLatency));
+    md->readNanos = md->writeNanos = 0;
+    md->prioRanges = NULL;
+    md->numPrioRanges = md->maxPrioRanges = 0;
+    md->highFrames = md->keepFrames = 0;
+    md->clients = NULL;
+    md->numClients = 0;
+    // keep at most a quarter of the pool resident unless told otherwise
+    md->keepConfig = cfg->keepResidentMax > 0 ? cfg->keepResidentMax : 0;
+    setKeepMax(md);
+
+    md->coalesceWindow = cfg->writeCoalesceWindow > 0 ? cfg->writeCoalesceWindow : 0;
+    if (md->coalesceWindow > capacity) md->coalesceWindow = capacity;
+    md->wbRuns = md->coalesceWindow
+        ? malloc(sizeof(Frame *) * capacity * (2 * md->coalesceWindow + 1)) : NULL;
+    md->coalescedPages = 0;
+    md->failedWrites = 0;
+    for (int i = 0; i < capacity; i++) {
         md->frames[i].pageId = NO_PAGE;
-        md->frames[i].data = malloc(PAGE_SIZE);
+        md->frames[i].owner = -1;
         md->frames[i].isDirty = false;
         md->frames[i].pinCount = 0;
+        md->frames[i].refBit = 0;
+        md->frames[i].hashNext = -1;
+        md->frames[i].swips = NULL;
+        md->frames[i].ioState = IO_NONE;
+        md->frames[i].evictedPage = NO_PAGE;
+        md->frames[i].wbCount = 0;
+        md->frames[i].wbRun = md->wbRuns ? md->wbRuns + (size_t) i * (2 * md->coalesceWindow + 1) : NULL;
+        md->frames[i].ioWaiters = NULL;
         md->frames[i].prev = md->frames[i].next = NULL;
     }
-    md->fifoQ = malloc(sizeof(int) * numPages);
+    md->fifoQ = malloc(sizeof(int) * capacity);
     md->fifoHead = md->fifoCount = 0;
     md->lruHead = md->lruTail = NULL;
+    // stratData for RS_CLOCK optionally points to the GCLOCK counter limit
+    md->clockMax = 1;
+    if (strat == RS_CLOCK && stratData && *(int *)stratData > 1)
+        md->clockMax = *(int *)stratData > 255 ? 255 : *(int *)stratData;
+
+    int buckets = 1;
+    while (buckets < 2 * capacity) buckets <<= 1;
+    md->pageTable = malloc(sizeof(int) * buckets);
+    for (int i = 0; i < buckets; i++) md->pageTable[i] = -1;
+    md->tableMask = buckets - 1;
+    pthread_mutex_init(&md->latch, NULL);
+    pthread_cond_init(&md->ioCond, NULL);
+    pthread_mutex_init(&md->fileLock, NULL);
+    md->writebacks = 0;
+    pthread_mutex_init(&md->queueLock, NULL);
+    pthread_cond_init(&md->queueCond, NULL);
+    md->queueHead = md->queueTail = NULL;
+    md->busyPins = md->retryPins = NULL;
+    md->donePins = md->doneTail = NULL;
+    pthread_cond_init(&md->doneCond, NULL);
+    md->stopCompleter = false;
+    md->workers = NULL;
+    md->numWorkers = 0;
+    md->stopWorkers = false;
+    if (cfg->ioWorkers > 0) startWorkers(md, cfg->ioWorkers);
+    md->freeList = malloc(sizeof(int) * capacity);
+    md->freeCount = 0;
+    md->freeLow = cfg->freeLowWatermark;
+    md->freeHigh = cfg->freeHighWatermark;
+    if (md->freeHigh > numPages) md->freeHigh = numPages;
+    if (md->freeHigh <= md->freeLow) md->freeHigh = md->freeLow + 1;
+    md->fgEvictions = md->bgEvictions = 0;
+    md->fgEvictNanos = md->bgEvictNanos = 0;
+    pthread_cond_init(&md->evictCond, NULL);
+    md->stopEvictor = false;
+    md->evictorRunning = md->freeLow > 0 && md->freeLow < numPages;
+    if (md->evictorRunning) pthread_create(&md->evictor, NULL, evictorMain, md);
+    md->bm = bm;
+
+    // the sizer only runs when the cgroup's memory files can be read;
+    // resizeBufferPool works either way
+    CgroupMemory mem;
+    md->cgroupDir = NULL;
+    md->resizeMs = cfg->resizeIntervalMs > 0 ? cfg->resizeIntervalMs : 1000;
+    pthread_cond_init(&md->sizerCond, NULL);
+    md->stopSizer = false;
+    md->sizerRunning = false;
+    if (cfg->maxPages > 0) {
+        md->cgroupDir = cfg->cgroupPath ? strdup(cfg->cgroupPath) : findCgroupDir();
+        md->sizerRunning = md->cgroupDir && readCgroupMemory(md->cgroupDir, &mem) == RC_OK;
+    }
+    if (md->sizerRunning) pthread_create(&md->sizer, NULL, sizerMain, md);
+    md->curveOn = cfg->hitRatioCurve && initMrcEstimator(&md->curve, 4 * capacity) == RC_OK;
+    // tracing is best effort; a trace file that cannot be created is skipped
+    md->trace = cfg->traceFile && *cfg->traceFile ? openTraceLog(cfg->traceFile) : NULL;
+    if (md->trace) traceInit(md->trace, numPages, strat, pageFileName);
 
     bm->pageFile = strdup(pageFileName);
-    bm->numPages = numPages;
+    bm->numPages = capacity;
     bm->strategy = strat;
     bm->mgmtData = md;
     return RC_OK;
@@ -113,6 +1131,36 @@ RC initBufferPool(BM_BufferPool *bm, const char *pageFileName,
 RC shutdownBufferPool(BM_BufferPool *bm) {
     if (!bm || !bm->mgmtData) return RC_FILE_HANDLE_NOT_INIT;
     PoolMetadata *md = bm->mgmtData;
+    TRACE(md, TRACE_SHUTDOWN, NO_PAGE);
+    if (md->sizerRunning) {
+        pthread_mutex_lock(&md->latch);
+        md->stopSizer = true;
+        pthread_cond_signal(&md->sizerCond);
+        pthread_mutex_unlock(&md->latch);
+        pthread_join(md->sizer, NULL);
+    }
+    if (md->evictorRunning) {
+        pthread_mutex_lock(&md->latch);
+        md->stopEvictor = true;
+        pthread_cond_signal(&md->evictCond);
+        pthread_mutex_unlock(&md->latch);
+        pthread_join(md->evictor, NULL);
+    }
+    // let the I/O workers finish queued loads first
+    pthread_mutex_lock(&md->queueLock);
+    md->stopWorkers = true;
+    pthread_cond_broadcast(&md->queueCond);
+    pthread_mutex_unlock(&md->queueLock);
+    for (int i = 0; i < md->numWorkers; i++) pthread_join(md->workers[i], NULL);
+    // then run the callbacks of what they finished
+    if (md->numWorkers > 0) {
+        pthread_mutex_lock(&md->queueLock);
+        md->stopCompleter = true;
+        pthread_cond_signal(&md->doneCond);
+        pthread_mutex_unlock(&md->queueLock);
+        pthread_join(md->completer, NULL);
+    }
+    free(md->workers);
     // flush dirty unpinned
     for (int i = 0; i < md->capacity; i++) {
         Frame *f = &md->frames[i];
@@ -120,11 +1168,30 @@ RC shutdownBufferPool(BM_BufferPool *bm) {
             writeBlock(f->pageId, &md->fh, f->data);
             md->writeIO++;
         }
+        unswizzleFrame(f);
     }
     closePageFile(&md->fh);
-    for (int i = 0; i < md->capacity; i++) free(md->frames[i].data);
+    for (int p = 0; p < md->numParts; p++) freeFrameArena(&md->parts[p].arena);
+    free(md->parts);
     free(md->frames);
+    free(md->pinStripes);
     free(md->fifoQ);
+    free(md->pageTable);
+    pthread_mutex_destroy(&md->latch);
+    pthread_cond_destroy(&md->ioCond);
+    pthread_mutex_destroy(&md->fileLock);
+    pthread_mutex_destroy(&md->queueLock);
+    pthread_cond_destroy(&md->queueCond);
+    pthread_cond_destroy(&md->doneCond);
+    pthread_cond_destroy(&md->evictCond);
+    pthread_cond_destroy(&md->sizerCond);
+    free(md->cgroupDir);
+    free(md->prioRanges);
+    free(md->clients);
+    free(md->wbRuns);
+    free(md->freeList);
+    if (md->trace) closeTraceLog(md->trace);
+    if (md->curveOn) freeMrcEstimator(&md->curve);
     free(bm->pageFile);
     free(md);
     bm->mgmtData = NULL;
@@ -132,132 +1199,982 @@ RC shutdownBufferPool(BM_BufferPool *bm) {
     return RC_OK;
 }
 
-// Force write all dirty pages
-RC forceFlushPool(BM_BufferPool *bm) {
+// Resize the pool within the frames set up at init
+RC resizeBufferPool(BM_BufferPool *bm, int numPages) {
     if (!bm || !bm->mgmtData) return RC_FILE_HANDLE_NOT_INIT;
     PoolMetadata *md = bm->mgmtData;
-    for (int i = 0; i < md->capacity; i++) {
+    pthread_mutex_lock(&md->latch);
+    setPoolSize(md, numPages);
+    pthread_mutex_unlock(&md->latch);
+    return RC_OK;
+}
+
+// Attach a retention priority to the pages [first, last]; resident pages
+// take it right away, others when they are read in
+RC setPagePriority(BM_BufferPool *bm, PageNumber first, PageNumber last,
+                   BM_PagePriority prio) {
+    if (!bm || !bm->mgmtData) return RC_FILE_HANDLE_NOT_INIT;
+    if (first < 0 || last < first) return RC_READ_NON_EXISTING_PAGE;
+    PoolMetadata *md = bm->mgmtData;
+    pthread_mutex_lock(&md->latch);
+    int i;
+    for (i = 0; i < md->numPrioRanges; i++)
+        if (md->prioRanges[i].first == first && md->prioRanges[i].last == last) break;
+    if (i < md->numPrioRanges) {
+        // same range again: move it to the end so it takes precedence
+        for (; i + 1 < md->numPrioRanges; i++) md->prioRanges[i] = md->prioRanges[i + 1];
+        md->numPrioRanges--;
+    }
+    if (md->numPrioRanges == md->maxPrioRanges) {
+        md->maxPrioRanges = md->maxPrioRanges ? 2 * md->maxPrioRanges : 8;
+        md->prioRanges = realloc(md->prioRanges, sizeof(PrioRange) * md->maxPrioRanges);
+    }
+    PrioRange *r = &md->prioRanges[md->numPrioRanges++];
+    r->first = first;
+    r->last = last;
+    r->prio = prio;
+    for (i = 0; i < md->capacity; i++) {
         Frame *f = &md->frames[i];
-        if (f->pageId != NO_PAGE && f->isDirty && f->pinCount == 0) {
-            writeBlock(f->pageId, &md->fh, f->data);
-            md->writeIO++;
-            f->isDirty = false;
-        }
+        if (f->pageId >= first && f->pageId <= last) setFramePrio(md, f, prio);
     }
+    pthread_mutex_unlock(&md->latch);
     return RC_OK;
 }
 
-// Pin a page into the buffer pool
-RC pinPage(BM_BufferPool *bm, BM_PageHandle *ph, PageNumber pid) {
+// Force write all dirty pages
+RC forceFlushPool(BM_BufferPool *bm) {
     if (!bm || !bm->mgmtData) return RC_FILE_HANDLE_NOT_INIT;
-    if (pid < 0) return RC_READ_NON_EXISTING_PAGE;
     PoolMetadata *md = bm->mgmtData;
-    Frame *slot = NULL;
-    int freeIdx = -1;
-    // hit check + find free
+    unsigned written = 0;
+    RC result = RC_OK;
+    TRACE(md, TRACE_FLUSH, NO_PAGE);
+    PROBE1(buffer, flush_start, md->capacity);
+    pthread_mutex_lock(&md->latch);
     for (int i = 0; i < md->capacity; i++) {
-        if (md->frames[i].pageId == pid) {
-            slot = &md->frames[i];
-            slot->pinCount++;
+        Frame *f = &md->frames[i];
+        // claiming keeps a concurrent pin + markDirty from being lost;
+        // IO_WRITING makes pins wait while the latch is dropped for the write
+        if (f->pageId != NO_PAGE && f->ioState == IO_NONE && LOAD_ACQ(&f->isDirty)
+            && claimFrame(f)) {
+            f->ioState = IO_WRITING;
+            pthread_mutex_unlock(&md->latch);
+            RC rc = writeFramePage(md, f->pageId, f->data);
+            pthread_mutex_lock(&md->latch);
+            if (rc == RC_OK) {
+                md->writeIO++;
+                written++;
+                STORE_RLX(&f->isDirty, false);
+            } else {
+                md->failedWrites++;
+                if (result == RC_OK) result = rc;
+            }
+            f->ioState = IO_NONE;
+            wakeIoWaiters(md);
+            STORE_REL(&f->pinCount, 0);
+        }
+    }
+    // pages already on their way out (evictor write-backs, misses writing
+    // back a victim) were skipped above; wait for them, so everything dirty
+    // when the flush began is in the file once it returns
+    for (int i = 0; i < md->capacity; i++) {
+        Frame *f = &md->frames[i];
+        while (f->ioState == IO_WRITING || (f->ioState == IO_LOADING && f->evictedPage != NO_PAGE))
+            pthread_cond_wait(&md->ioCond, &md->latch);
+    }
+    pthread_mutex_unlock(&md->latch);
+    PROBE1(buffer, flush_done, written);
+    return result;
+}
+
+// Park an async pin whose page is being written back until the write ends
+// (latch held)
+static RC parkPin(PoolMetadata *md, AsyncPin *req) {
+    if (md->numWorkers == 0) startWorkers(md, 1);
+    req->next = md->busyPins;
+    md->busyPins = req;
+    return RC_BM_PIN_PENDING;
+}
+
+// Pin a page with the latch held; the latch is dropped while waiting for
+// I/O. An async request never waits: a miss is queued, a page being loaded
+// or written back gets it as a waiter, and RC_BM_PIN_PENDING is returned.
+// A miss on behalf of a client (owner >= 0) is charged to its quota.
+static RC pinPageLatched(PoolMetadata *md, BM_PageHandle *ph, PageNumber pid,
+                         AsyncPin *req, int owner) {
+    Frame *slot;
+    // finish a shrink that stopped at pinned frames
+    if (md->resident > md->poolSize) shrinkPool(md);
+    for (;;) {
+        slot = lookupFrame(md, pid);
+        if (slot && slot->ioState != IO_NONE) {
+            // already being loaded: join that read instead of issuing another
+            if (req && slot->ioState == IO_LOADING) {
+                if (md->numWorkers == 0) startWorkers(md, 1);
+                req->next = slot->ioWaiters;
+                slot->ioWaiters = req;
+                return RC_BM_PIN_PENDING;
+            }
+            if (req) return parkPin(md, req);
+            pthread_cond_wait(&md->ioCond, &md->latch);
+            continue;
+        }
+        if (slot && tryPin(slot, pid)) {
+            PROBE1(buffer, pin_hit, pid);
+            noteAccess(md, slot);
             if (md->strat == RS_LRU || md->strat == RS_LRU_K)
                 moveToLRUHead(md, slot);
+            else if (md->strat == RS_CLOCK)
+                touchFrame(md, slot);
             ph->pageNum = pid;
             ph->data = slot->data;
             return RC_OK;
         }
-        if (md->frames[i].pageId == NO_PAGE && freeIdx < 0)
-            freeIdx = i;
+        // don't read a page from disk while its write-back is still running
+        if (md->writebacks > 0 && writebackPending(md, pid)) {
+            if (req) return parkPin(md, req);
+            pthread_cond_wait(&md->ioCond, &md->latch);
+            continue;
+        }
+        break;
     }
-    // miss: free slot or victim
-    if (freeIdx >= 0) {
-        slot = &md->frames[freeIdx];
+
+    // miss: never-used frame, free frame from the evictor, or inline victim,
+    // each tried on the local node's partition first
+    PROBE1(buffer, pin_miss, pid);
+    int node = currentPart(md);
+    slot = NULL;
+    // a client at its quota replaces one of its own pages instead of growing
+    Frame *own = NULL;
+    if (owner >= 0 && md->clients[owner].frames >= md->clients[owner].quota)
+        own = selectVictim(md, node, owner);
+    if (!own && md->resident < md->poolSize) {
+        slot = takeFreeFrame(md, node, true);
+        if (!slot && md->numParts > 1) slot = takeFreeFrame(md, node, false);
+    }
+    if (slot) {
+        slot->evictedPage = NO_PAGE;
+        md->resident++;
     } else {
-        slot = selectVictim(md);
+        long long start = nowNanos();
+        slot = own ? own : selectVictim(md, node, -1);
+        md->fgEvictNanos += nowNanos() - start;
         if (!slot) return RC_READ_NON_EXISTING_PAGE;
-        if (slot->isDirty) {
-            writeBlock(slot->pageId, &md->fh, slot->data);
-            md->writeIO++;
+        PROBE3(buffer, evict, slot->pageId, slot->isDirty, 0);
+        md->fgEvictions++;
+        // swips must stop pointing here before the frame changes pages
+        unswizzleFrame(slot);
+        tableRemove(md, slot);
+        slot->evictedPage = slot->isDirty ? slot->pageId : NO_PAGE;
+        if (slot->evictedPage != NO_PAGE) {
+            md->writebacks++;
+            if (md->coalesceWindow > 0) gatherWriteRun(md, slot);
         }
     }
-    if (pid >= md->fh.totalNumPages) ensureCapacity(pid + 1, &md->fh);
-    readBlock(pid, &md->fh, slot->data);
-    md->readIO++;
-    slot->pageId = pid;
-    slot->isDirty = false;
-    slot->pinCount = 1;
+    if (slot->node != node) md->remoteAllocs++;
+    STORE_REL(&slot->pageId, pid);
+    STORE_RLX(&slot->isDirty, false);
+    slot->refBit = 1;
+    setFramePrio(md, slot, md->numPrioRanges ? pagePriority(md, pid) : BM_PRIO_NORMAL);
+    setFrameOwner(md, slot, owner);
+    slot->ioState = IO_LOADING;
+    slot->ioSyncOwner = (req == NULL);
+    slot->ioWaiters = req;
+    if (req) req->next = NULL;
+    // lock-free pins see PIN_EVICTING and fall back to waiting on the latch
+    tableInsert(md, slot);
     int idx = slot - md->frames;
     if (md->strat == RS_FIFO) enqueueFIFO(md, idx);
-    else moveToLRUHead(md, slot);
+    else if (md->strat != RS_CLOCK) moveToLRUHead(md, slot);
+    if (md->evictorRunning && freeFrames(md) < md->freeLow)
+        pthread_cond_signal(&md->evictCond);
+
+    if (req || md->numWorkers > 0) {
+        if (md->numWorkers == 0) startWorkers(md, 1);
+        enqueueLoad(md, slot);
+        if (req) return RC_BM_PIN_PENDING;
+    } else {
+        // no workers: do our own I/O, still without the latch
+        pthread_mutex_unlock(&md->latch);
+        finishLoad(md, slot, loadFrameData(md, slot));
+        pthread_mutex_lock(&md->latch);
+    }
+    while (slot->ioState != IO_NONE)
+        pthread_cond_wait(&md->ioCond, &md->latch);
+    if (slot->ioRc != RC_OK) {
+        __atomic_fetch_sub(&slot->pinCount, 1, __ATOMIC_RELEASE);
+        return slot->ioRc;
+    }
     ph->pageNum = pid;
     ph->data = slot->data;
     return RC_OK;
 }
 
-// Unpin a page
-RC unpinPage(BM_BufferPool *bm, BM_PageHandle *ph) {
+// Lock-free hit: pin the resident frame and record the reference.
+// Only LRU takes the latch, to reorder its list.
+static bool pinHit(PoolMetadata *md, BM_PageHandle *ph, PageNumber pid) {
+    countPins(md, 1);
+    SAMPLE_PIN(md, pid);
+    Frame *slot = lookupFrame(md, pid);
+    if (!slot || !tryPin(slot, pid)) return false;
+    PROBE1(buffer, pin_hit, pid);
+    noteAccess(md, slot);
+    if (md->strat == RS_LRU || md->strat == RS_LRU_K) {
+        pthread_mutex_lock(&md->latch);
+        moveToLRUHead(md, slot);
+        pthread_mutex_unlock(&md->latch);
+    } else if (md->strat == RS_CLOCK) {
+        touchFrame(md, slot);
+    }
+    ph->pageNum = pid;
+    ph->data = slot->data;
+    return true;
+}
+
+// Pin a page into the buffer pool
+RC pinPage(BM_BufferPool *bm, BM_PageHandle *ph, PageNumber pid) {
     if (!bm || !bm->mgmtData) return RC_FILE_HANDLE_NOT_INIT;
+    if (pid < 0) return RC_READ_NON_EXISTING_PAGE;
     PoolMetadata *md = bm->mgmtData;
-    for (int i = 0; i < md->capacity; i++) {
-        if (md->frames[i].pageId == ph->pageNum) {
-            if (md->frames[i].pinCount > 0) {
-                md->frames[i].pinCount--;
+    TRACE(md, TRACE_PIN, pid);
+    if (pinHit(md, ph, pid)) return RC_OK;
+    pthread_mutex_lock(&md->latch);
+    RC rc = pinPageLatched(md, ph, pid, NULL, -1);
+    pthread_mutex_unlock(&md->latch);
+    return rc;
+}
+
+// Open a client whose misses may hold at most quota frames
+RC openClient(BM_BufferPool *bm, BM_Client *client, int quota) {
+    if (!bm || !bm->mgmtData) return RC_FILE_HANDLE_NOT_INIT;
+    PoolMetadata *md = bm->mgmtData;
+    pthread_mutex_lock(&md->latch);
+    int id = 0;
+    while (id < md->numClients && md->clients[id].open) id++;
+    if (id == md->numClients) {
+        md->clients = realloc(md->clients, sizeof(ClientState) * (md->numClients + 1));
+        md->clients[md->numClients++].frames = 0;
+    }
+    md->clients[id].open = true;
+    md->clients[id].quota = quota < 1 ? 1 : quota;
+    pthread_mutex_unlock(&md->latch);
+    client->pool = bm;
+    client->id = id;
+    return RC_OK;
+}
+
+// Close a client; the pages it loaded stay cached without an owner
+RC closeClient(BM_Client *client) {
+    if (!client->pool || !client->pool->mgmtData) return RC_FILE_HANDLE_NOT_INIT;
+    PoolMetadata *md = client->pool->mgmtData;
+    pthread_mutex_lock(&md->latch);
+    for (int i = 0; i < md->capacity; i++)
+        if (md->frames[i].owner == client->id) setFrameOwner(md, &md->frames[i], -1);
+    md->clients[client->id].open = false;
+    pthread_mutex_unlock(&md->latch);
+    client->pool = NULL;
+    return RC_OK;
+}
+
+// Pin a page on behalf of a client; misses count against its quota
+RC pinPageForClient(BM_Client *client, BM_PageHandle *ph, PageNumber pid) {
+    if (!client->pool || !client->pool->mgmtData) return RC_FILE_HANDLE_NOT_INIT;
+    if (pid < 0) return RC_READ_NON_EXISTING_PAGE;
+    PoolMetadata *md = client->pool->mgmtData;
+    TRACE(md, TRACE_PIN, pid);
+    if (pinHit(md, ph, pid)) return RC_OK;
+    pthread_mutex_lock(&md->latch);
+    RC rc = pinPageLatched(md, ph, pid, NULL, client->id);
+    pthread_mutex_unlock(&md->latch);
+    return rc;
+}
+
+// Frames currently charged to a client
+int getClientFrames(BM_Client *client) {
+    PoolMetadata *md = client->pool->mgmtData;
+    pthread_mutex_lock(&md->latch);
+    int frames = md->clients[client->id].frames;
+    pthread_mutex_unlock(&md->latch);
+    return frames;
+}
+
+// Pin without blocking: RC_OK on a hit, RC_BM_PIN_PENDING when the miss was
+// handed to the I/O workers. ph must stay valid until the callback runs.
+RC pinPageAsync(BM_BufferPool *bm, BM_PageHandle *ph, PageNumber pid,
+                BM_PinCallback callback, void *ctx) {
+    if (!bm || !bm->mgmtData) return RC_FILE_HANDLE_NOT_INIT;
+    if (pid < 0) return RC_READ_NON_EXISTING_PAGE;
+    PoolMetadata *md = bm->mgmtData;
+    TRACE(md, TRACE_PIN, pid);
+    if (pinHit(md, ph, pid)) return RC_OK;
+
+    AsyncPin *req = malloc(sizeof(AsyncPin));
+    req->pid = pid;
+    req->ph = ph;
+    req->callback = callback;
+    req->ctx = ctx;
+    req->next = NULL;
+    pthread_mutex_lock(&md->latch);
+    RC rc = pinPageLatched(md, ph, pid, req, -1);
+    pthread_mutex_unlock(&md->latch);
+    if (rc != RC_BM_PIN_PENDING) free(req);
+    return rc;
+}
+
+// Can frame idx of part hold a page of the extent [start, start+count)?
+// Never-used, free and unpinned frames qualify, except keep-resident pages
+// outside the extent. (latch held)
+static bool extentFrameOk(PoolMetadata *md, NodePart *part, int idx,
+                          PageNumber start, int count) {
+    if (idx >= part->nextUnused) return true;
+    Frame *f = &md->frames[idx];
+    if (f->ioState != IO_NONE) return false;
+    int pins = LOAD_RLX(&f->pinCount);
+    if (pins == PIN_EVICTING) return f->pageId == NO_PAGE; // on the free list
+    if (pins != 0) return false;
+    return f->prio < BM_PRIO_KEEP || (f->pageId >= start && f->pageId < start + count);
+}
+
+// First frame of count adjacent frames in one partition that can hold the
+// extent, trying the local node first; -1 if there is none (latch held)
+static int findExtentRun(PoolMetadata *md, int node, PageNumber start, int count,
+                         NodePart **found) {
+    for (int p = 0; p < md->numParts; p++) {
+        NodePart *part = &md->parts[(node + p) % md->numParts];
+        int run = 0;
+        for (int i = part->first; i < part->end; i++) {
+            run = extentFrameOk(md, part, i, start, count) ? run + 1 : 0;
+            if (run == count) {
+                *found = part;
+                return i - count + 1;
+            }
+        }
+    }
+    return -1;
+}
+
+// Claim the cached frames an extent replaces: those in the run and those
+// holding its pages elsewhere. Returns how many were claimed into claimed,
+// or -1 (nothing claimed) if a lock-free pin got in first. (latch held)
+static int claimExtentFrames(PoolMetadata *md, NodePart *part, int first,
+                             PageNumber start, int count, Frame **claimed) {
+    int n = 0;
+    for (int i = first; i < first + count && i < part->nextUnused; i++) {
+        Frame *f = &md->frames[i];
+        if (LOAD_RLX(&f->pinCount) == PIN_EVICTING) continue; // free frame
+        if (!claimFrame(f)) goto busy;
+        claimed[n++] = f;
+    }
+    for (PageNumber pid = start; pid < start + count; pid++) {
+        Frame *f = lookupFrame(md, pid);
+        int idx = f ? (int) (f - md->frames) : -1;
+        if (!f || (idx >= first && idx < first + count)) continue;
+        if (!claimFrame(f)) goto busy;
+        claimed[n++] = f;
+    }
+    return n;
+busy:
+    while (n > 0) STORE_REL(&claimed[--n]->pinCount, 0);
+    return -1;
+}
+
+// Take the never-used and free frames of the run (latch held)
+static void takeExtentFreeFrames(PoolMetadata *md, NodePart *part, int first, int count) {
+    for (int i = first; i < first + count; i++) {
+        if (i >= part->nextUnused) {
+            // never-used frames skipped over stay free
+            while (part->nextUnused < i) {
+                md->frames[part->nextUnused].pinCount = PIN_EVICTING;
+                md->freeList[md->freeCount++] = part->nextUnused++;
+            }
+            part->nextUnused++;
+            md->frames[i].pinCount = PIN_EVICTING;
+        } else if (md->frames[i].pageId == NO_PAGE) {
+            for (int k = 0; k < md->freeCount; k++) {
+                if (md->freeList[k] == i) {
+                    md->freeList[k] = md->freeList[--md->freeCount];
+                    break;
+                }
+            }
+        }
+    }
+}
+
+// Write back the dirty pages an extent's run replaces. Like evictToFreeList
+// the frames are IO_WRITING and the latch is dropped during the writes; a
+// page whose write fails stays dirty. The frames come back unclaimed.
+// (latch held)
+static RC writeExtentVictims(PoolMetadata *md, Frame **victims, int n) {
+    for (int i = 0; i < n; i++) victims[i]->ioState = IO_WRITING;
+    pthread_mutex_unlock(&md->latch);
+    RC rcs[n];
+    for (int i = 0; i < n; i++)
+        rcs[i] = writeFramePage(md, victims[i]->pageId, victims[i]->data);
+    pthread_mutex_lock(&md->latch);
+    RC rc = RC_OK;
+    for (int i = 0; i < n; i++) {
+        Frame *f = victims[i];
+        f->ioState = IO_NONE;
+        if (rcs[i] == RC_OK) {
+            STORE_RLX(&f->isDirty, false);
+            md->writeIO++;
+        } else {
+            md->failedWrites++;
+            rc = rcs[i];
+        }
+        STORE_REL(&f->pinCount, 0);
+    }
+    wakeIoWaiters(md);
+    return rc;
+}
+
+// A page of an extent that is cached already: copied into the run from
+// 'from', or in place already if that is NULL
+typedef struct ExtentPage {
+    bool cached;
+    bool dirty;
+    char *from;
+} ExtentPage;
+
+// Pin count consecutive pages in adjacent frames, so eh->data is one
+// contiguous buffer. Cached pages are copied into place, dirty or not, and
+// the others come in with one read per gap between them.
+RC pinExtent(BM_BufferPool *bm, PageNumber start, int count, BM_ExtentHandle *eh) {
+    if (!bm || !bm->mgmtData) return RC_FILE_HANDLE_NOT_INIT;
+    if (start < 0 || count < 1) return RC_READ_NON_EXISTING_PAGE;
+    PoolMetadata *md = bm->mgmtData;
+    countPins(md, (unsigned long) count);
+    for (int k = 0; k < count; k++) {
+        TRACE(md, TRACE_PIN, start + k);
+        SAMPLE_PIN(md, start + k);
+    }
+    Frame **claimed = malloc(sizeof(Frame *) * 2 * count);
+    ExtentPage *pages = calloc(count, sizeof(ExtentPage));
+    if (!claimed || !pages) {
+        free(claimed);
+        free(pages);
+        return RC_BM_OUT_OF_MEMORY;
+    }
+    NodePart *part = NULL;
+    int first, numClaimed;
+    pthread_mutex_lock(&md->latch);
+    for (;;) {
+        // let loads and write-backs of the extent's pages finish first
+        bool busy = false;
+        for (PageNumber pid = start; pid < start + count && !busy; pid++) {
+            Frame *f = lookupFrame(md, pid);
+            busy = (f && f->ioState != IO_NONE)
+                || (md->writebacks > 0 && writebackPending(md, pid));
+        }
+        if (busy) {
+            pthread_cond_wait(&md->ioCond, &md->latch);
+            continue;
+        }
+        // the extent's pages must not be pinned where they are now
+        for (PageNumber pid = start; pid < start + count && !busy; pid++) {
+            Frame *f = lookupFrame(md, pid);
+            busy = f && LOAD_RLX(&f->pinCount) != 0;
+        }
+        first = busy ? -1 : findExtentRun(md, currentPart(md), start, count, &part);
+        if (first < 0) {
+            pthread_mutex_unlock(&md->latch);
+            free(claimed);
+            free(pages);
+            return RC_BM_EXTENT_UNAVAILABLE;
+        }
+        // other dirty pages in the run are written back first, without the
+        // latch; then the run is looked for again
+        int numDirty = 0;
+        for (int i = first; i < first + count && i < part->nextUnused; i++) {
+            Frame *f = &md->frames[i];
+            if (f->pageId != NO_PAGE && (f->pageId < start || f->pageId >= start + count)
+                && LOAD_ACQ(&f->isDirty) && claimFrame(f))
+                claimed[numDirty++] = f;
+        }
+        if (numDirty > 0) {
+            RC rc = writeExtentVictims(md, claimed, numDirty);
+            if (rc != RC_OK) {
+                pthread_mutex_unlock(&md->latch);
+                free(claimed);
+                free(pages);
+                return rc;
+            }
+            continue;
+        }
+        numClaimed = claimExtentFrames(md, part, first, start, count, claimed);
+        if (numClaimed < 0) continue;
+        // a page of the run dirtied since the scan goes through the writes too
+        for (int i = 0; i < numClaimed && !busy; i++) {
+            PageNumber pid = claimed[i]->pageId;
+            busy = (pid < start || pid >= start + count) && LOAD_ACQ(&claimed[i]->isDirty);
+        }
+        if (!busy) break;
+        while (numClaimed > 0) STORE_REL(&claimed[--numClaimed]->pinCount, 0);
+    }
+
+    // note the cached pages of the extent; those in the run at another
+    // offset are staged, since the copies into the run may overwrite them
+    int numStaged = 0;
+    for (int i = 0; i < numClaimed; i++) {
+        int k = claimed[i]->pageId - start;
+        int idx = (int) (claimed[i] - md->frames);
+        if (claimed[i]->pageId != NO_PAGE && k >= 0 && k < count
+            && idx >= first && idx < first + count && idx != first + k)
+            numStaged++;
+    }
+    char *staged = numStaged > 0 ? malloc((size_t) PAGE_SIZE * numStaged) : NULL;
+    if (numStaged > 0 && !staged) {
+        while (numClaimed > 0) STORE_REL(&claimed[--numClaimed]->pinCount, 0);
+        pthread_mutex_unlock(&md->latch);
+        free(claimed);
+        free(pages);
+        return RC_BM_OUT_OF_MEMORY;
+    }
+    numStaged = 0;
+    for (int i = 0; i < numClaimed; i++) {
+        Frame *f = claimed[i];
+        int k = f->pageId - start;
+        int idx = (int) (f - md->frames);
+        if (f->pageId == NO_PAGE || k < 0 || k >= count) continue;
+        pages[k].cached = true;
+        pages[k].dirty = LOAD_RLX(&f->isDirty);
+        if (idx == first + k) {
+            pages[k].from = NULL;
+        } else if (idx >= first && idx < first + count) {
+            pages[k].from = staged + (size_t) PAGE_SIZE * numStaged++;
+            memcpy(pages[k].from, f->data, PAGE_SIZE);
+        } else {
+            pages[k].from = f->data;
+        }
+    }
+
+    // free the claimed frames outside the run (still claimed, so their data
+    // stays put for the copies); the run's frames stay claimed for the extent
+    for (int i = 0; i < numClaimed; i++) {
+        Frame *f = claimed[i];
+        int idx = (int) (f - md->frames);
+        unmapFrame(md, f);
+        if (md->strat == RS_FIFO) removeFromFIFO(md, idx);
+        md->resident--;
+        if (idx < first || idx >= first + count)
+            md->freeList[md->freeCount++] = idx;
+    }
+    free(claimed);
+    takeExtentFreeFrames(md, part, first, count);
+
+    // map the pages; cached ones are pinned right away, the others as one
+    // load per gap, and pins of them wait for IO_LOADING to clear
+    int node = currentPart(md);
+    for (int k = 0; k < count; k++) {
+        Frame *f = &md->frames[first + k];
+        if (pages[k].from) memcpy(f->data, pages[k].from, PAGE_SIZE);
+        STORE_REL(&f->pageId, start + k);
+        STORE_RLX(&f->isDirty, pages[k].dirty);
+        f->refBit = 1;
+        setFramePrio(md, f, md->numPrioRanges ? pagePriority(md, start + k) : BM_PRIO_NORMAL);
+        f->evictedPage = NO_PAGE;
+        f->wbCount = 0;
+        f->ioState = pages[k].cached ? IO_NONE : IO_LOADING;
+        f->ioSyncOwner = true;
+        f->ioWaiters = NULL;
+        tableInsert(md, f);
+        if (md->strat == RS_FIFO) enqueueFIFO(md, first + k);
+        else if (md->strat != RS_CLOCK) moveToLRUHead(md, f);
+        if (f->node != node) md->remoteAllocs++;
+        if (pages[k].cached) STORE_REL(&f->pinCount, 1);
+    }
+    free(staged);
+    md->resident += count;
+    if (md->evictorRunning && freeFrames(md) < md->freeLow)
+        pthread_cond_signal(&md->evictCond);
+    pthread_mutex_unlock(&md->latch);
+
+    RC rc = RC_OK;
+    char *data = md->frames[first].data;
+    for (int k = 0; k < count; ) {
+        if (pages[k].cached) {
+            k++;
+            continue;
+        }
+        int gap = 1;
+        while (k + gap < count && !pages[k + gap].cached) gap++;
+        RC readRc = RC_OK;
+        pthread_mutex_lock(&md->fileLock);
+        if (start + k + gap > md->fh.totalNumPages)
+            readRc = ensureCapacity(start + k + gap, &md->fh);
+        if (readRc == RC_OK) {
+            long long readStart = nowNanos();
+            readRc = readBlocks(start + k, gap, &md->fh, data + (size_t) PAGE_SIZE * k);
+            noteLatency(md, false, nowNanos() - readStart);
+        }
+        pthread_mutex_unlock(&md->fileLock);
+        for (int j = k; j < k + gap; j++) finishLoad(md, &md->frames[first + j], readRc);
+        if (readRc != RC_OK) rc = readRc;
+        k += gap;
+    }
+    free(pages);
+    // a failed read fails the whole extent; the pages read stay cached
+    if (rc != RC_OK) {
+        for (int k = 0; k < count; k++)
+            __atomic_fetch_sub(&md->frames[first + k].pinCount, 1, __ATOMIC_RELEASE);
+    }
+    if (rc != RC_OK) return rc;
+    eh->firstPage = start;
+    eh->count = count;
+    eh->data = data;
+    return RC_OK;
+}
+
+// Unpin all pages of an extent
+RC unpinExtent(BM_BufferPool *bm, BM_ExtentHandle *eh) {
+    BM_PageHandle ph;
+    for (int k = 0; k < eh->count; k++) {
+        ph.pageNum = eh->firstPage + k;
+        RC rc = unpinPage(bm, &ph);
+        if (rc != RC_OK) return rc;
+    }
+    return RC_OK;
+}
+
+// Mark all pages of an extent dirty
+RC markExtentDirty(BM_BufferPool *bm, BM_ExtentHandle *eh) {
+    BM_PageHandle ph;
+    for (int k = 0; k < eh->count; k++) {
+        ph.pageNum = eh->firstPage + k;
+        RC rc = markDirty(bm, &ph);
+        if (rc != RC_OK) return rc;
+    }
+    return RC_OK;
+}
+
+// Swizzled references
+void initSwip(BM_Swip *swip, PageNumber pageNum) {
+    swip->word = SWIP_WORD(pageNum);
+    swip->nextRef = NULL;
+}
+
+// Page number behind a swip; the latch keeps a swizzled frame from moving
+PageNumber getSwipPage(BM_BufferPool *bm, BM_Swip *swip) {
+    uintptr_t w = LOAD_ACQ(&swip->word);
+    if (SWIP_UNSWIZZLED(w)) return SWIP_PAGE(w);
+    PoolMetadata *md = bm->mgmtData;
+    pthread_mutex_lock(&md->latch);
+    w = swip->word;
+    PageNumber pid = SWIP_UNSWIZZLED(w) ? SWIP_PAGE(w) : ((Frame *) w)->pageId;
+    pthread_mutex_unlock(&md->latch);
+    return pid;
+}
+
+// Pin the page behind a swip, swizzling it on a miss
+RC pinSwip(BM_BufferPool *bm, BM_Swip *swip, BM_PageHandle *ph) {
+    if (!bm || !bm->mgmtData) return RC_FILE_HANDLE_NOT_INIT;
+    PoolMetadata *md = bm->mgmtData;
+    countPins(md, 1);
+    uintptr_t w = LOAD_ACQ(&swip->word);
+    if (!SWIP_UNSWIZZLED(w)) {
+        Frame *f = (Frame *) w;
+        // eviction unswizzles before it changes pages, so a pin taken while
+        // the swip still points here is on the right page
+        if (pinFrame(f)) {
+            if (LOAD_ACQ(&swip->word) == w) {
+                TRACE(md, TRACE_PIN, f->pageId);
+                SAMPLE_PIN(md, f->pageId);
+                PROBE1(buffer, pin_hit, f->pageId);
+                noteAccess(md, f);
+                if (md->strat == RS_LRU || md->strat == RS_LRU_K) {
+                    pthread_mutex_lock(&md->latch);
+                    moveToLRUHead(md, f);
+                    pthread_mutex_unlock(&md->latch);
+                } else if (md->strat == RS_CLOCK) {
+                    touchFrame(md, f);
+                }
+                ph->pageNum = f->pageId;
+                ph->data = f->data;
                 return RC_OK;
-            } else {
-                return RC_READ_NON_EXISTING_PAGE;
             }
+            __atomic_fetch_sub(&f->pinCount, 1, __ATOMIC_RELEASE);
         }
     }
-    return RC_READ_NON_EXISTING_PAGE;
+    pthread_mutex_lock(&md->latch);
+    w = swip->word;
+    PageNumber pid = SWIP_UNSWIZZLED(w) ? SWIP_PAGE(w) : ((Frame *) w)->pageId;
+    TRACE(md, TRACE_PIN, pid);
+    SAMPLE_PIN(md, pid);
+    RC rc = pinPageLatched(md, ph, pid, NULL, -1);
+    // the latch may have been dropped for I/O; another pin may have swizzled it
+    if (rc == RC_OK && SWIP_UNSWIZZLED(swip->word)) {
+        Frame *f = lookupFrame(md, pid);
+        swip->nextRef = f->swips;
+        f->swips = swip;
+        STORE_REL(&swip->word, (uintptr_t) f);
+    }
+    pthread_mutex_unlock(&md->latch);
+    return rc;
+}
+
+// Unpin a page pinned through a swip; the pin keeps it swizzled
+RC unpinSwip(BM_BufferPool *bm, BM_Swip *swip) {
+    if (!bm || !bm->mgmtData) return RC_FILE_HANDLE_NOT_INIT;
+    uintptr_t w = LOAD_ACQ(&swip->word);
+    if (SWIP_UNSWIZZLED(w)) {
+        BM_PageHandle ph;
+        ph.pageNum = SWIP_PAGE(w);
+        return unpinPage(bm, &ph);
+    }
+    Frame *f = (Frame *) w;
+    TRACE((PoolMetadata *) bm->mgmtData, TRACE_UNPIN, f->pageId);
+    int cnt = LOAD_ACQ(&f->pinCount);
+    do {
+        if (cnt <= 0) return RC_READ_NON_EXISTING_PAGE;
+    } while (!CAS(&f->pinCount, &cnt, cnt - 1));
+    return RC_OK;
+}
+
+// Detach a swip from its frame before the memory holding it goes away
+RC releaseSwip(BM_BufferPool *bm, BM_Swip *swip) {
+    if (!bm || !bm->mgmtData) return RC_FILE_HANDLE_NOT_INIT;
+    PoolMetadata *md = bm->mgmtData;
+    pthread_mutex_lock(&md->latch);
+    if (!SWIP_UNSWIZZLED(swip->word)) {
+        Frame *f = (Frame *) swip->word;
+        BM_Swip **link = &f->swips;
+        while (*link && *link != swip) link = &(*link)->nextRef;
+        if (*link) *link = swip->nextRef;
+        swip->nextRef = NULL;
+        STORE_REL(&swip->word, SWIP_WORD(f->pageId));
+    }
+    pthread_mutex_unlock(&md->latch);
+    return RC_OK;
+}
+
+// Unpin a page
+RC unpinPage(BM_BufferPool *bm, BM_PageHandle *ph) {
+    if (!bm || !bm->mgmtData) return RC_FILE_HANDLE_NOT_INIT;
+    PoolMetadata *md = bm->mgmtData;
+    TRACE(md, TRACE_UNPIN, ph->pageNum);
+    Frame *f = findFrame(md, ph->pageNum);
+    if (!f) return RC_READ_NON_EXISTING_PAGE;
+    int cnt = LOAD_ACQ(&f->pinCount);
+    do {
+        if (cnt <= 0) return RC_READ_NON_EXISTING_PAGE;
+    } while (!CAS(&f->pinCount, &cnt, cnt - 1));
+    return RC_OK;
 }
 
 // Mark a page dirty
 RC markDirty(BM_BufferPool *bm, BM_PageHandle *ph) {
     if (!bm || !bm->mgmtData) return RC_FILE_HANDLE_NOT_INIT;
     PoolMetadata *md = bm->mgmtData;
-    // search for frame
-    for (int i = 0; i < md->capacity; i++) {
-        if (md->frames[i].pageId == ph->pageNum) {
-            md->frames[i].isDirty = true;
-            return RC_OK;
-        }
-    }
+    TRACE(md, TRACE_DIRTY, ph->pageNum);
+    Frame *f = findFrame(md, ph->pageNum);
     // page not in buffer
-    return RC_READ_NON_EXISTING_PAGE;
+    if (!f) return RC_READ_NON_EXISTING_PAGE;
+    STORE_REL(&f->isDirty, true);
+    return RC_OK;
 }
 
 // Force a single page write
 RC forcePage(BM_BufferPool *bm, BM_PageHandle *ph) {
     if (!bm || !bm->mgmtData) return RC_FILE_HANDLE_NOT_INIT;
     PoolMetadata *md = bm->mgmtData;
-    for (int i = 0; i < md->capacity; i++) {
-        if (md->frames[i].pageId == ph->pageNum) {
-            writeBlock(ph->pageNum, &md->fh, md->frames[i].data);
-            md->writeIO++;
-            md->frames[i].isDirty = false;
-            return RC_OK;
-        }
+    TRACE(md, TRACE_FORCE, ph->pageNum);
+    pthread_mutex_lock(&md->latch);
+    Frame *f;
+    // let a write-back of the page that is already running finish first
+    while ((f = lookupFrame(md, ph->pageNum)) && f->ioState == IO_WRITING)
+        pthread_cond_wait(&md->ioCond, &md->latch);
+    // not loaded yet, or claimed by a replacement in progress
+    bool claimed = f && f->ioState == IO_NONE && claimFrame(f);
+    if (!f || f->ioState != IO_NONE || (!claimed && !tryPin(f, ph->pageNum))) {
+        pthread_mutex_unlock(&md->latch);
+        return RC_READ_NON_EXISTING_PAGE;
+    }
+    // the claim or our pin keeps the page in the frame during the write;
+    // a markDirty meanwhile sets the flag again, so it is cleared first
+    f->ioState = IO_WRITING;
+    STORE_RLX(&f->isDirty, false);
+    pthread_mutex_unlock(&md->latch);
+    RC rc = writeFramePage(md, ph->pageNum, f->data);
+    pthread_mutex_lock(&md->latch);
+    if (rc == RC_OK) {
+        md->writeIO++;
+    } else {
+        md->failedWrites++;
+        STORE_RLX(&f->isDirty, true);
     }
-    return RC_READ_NON_EXISTING_PAGE;
+    f->ioState = IO_NONE;
+    wakeIoWaiters(md);
+    if (claimed) STORE_REL(&f->pinCount, 0);
+    else __atomic_fetch_sub(&f->pinCount, 1, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&md->latch);
+    return rc;
+}
+
+// Commit the page writes so far; fileLock keeps write-backs out meanwhile
+RC commitPool(BM_BufferPool *bm) {
+    if (!bm || !bm->mgmtData) return RC_FILE_HANDLE_NOT_INIT;
+    PoolMetadata *md = bm->mgmtData;
+    pthread_mutex_lock(&md->fileLock);
+    RC rc = commitPageFile(&md->fh);
+    pthread_mutex_unlock(&md->fileLock);
+    return rc;
+}
+
+// Estimated hit ratios at half, the same, twice and four times the current
+// pool size, over every pin since the pool opened
+RC getHitRatioCurve(BM_BufferPool *bm, BM_HitRatioCurve *curve) {
+    if (!bm || !bm->mgmtData) return RC_FILE_HANDLE_NOT_INIT;
+    PoolMetadata *md = bm->mgmtData;
+    if (!md->curveOn) return RC_BM_NOT_ENABLED;
+    int size = LOAD_RLX(&md->poolSize);
+    unsigned long pins = totalPins(md);
+    for (int i = 0; i < BM_CURVE_POINTS; i++) {
+        curve->pages[i] = i == 0 ? (size + 1) / 2 : size << (i - 1);
+        curve->hitRatio[i] = mrcHitRatio(&md->curve, curve->pages[i], pins);
+    }
+    curve->sampleRate = md->curve.rate;
+    pthread_mutex_lock(&md->curve.lock);
+    curve->sampledPins = md->curve.refs;
+    pthread_mutex_unlock(&md->curve.lock);
+    return RC_OK;
 }
 
 // Statistics APIs
 PageNumber *getFrameContents(BM_BufferPool *bm) {
     PoolMetadata *md = bm->mgmtData;
     PageNumber *arr = malloc(sizeof(PageNumber) * md->capacity);
-    for (int i = 0; i < md->capacity; i++) arr[i] = md->frames[i].pageId;
+    for (int i = 0; i < md->capacity; i++) arr[i] = LOAD_ACQ(&md->frames[i].pageId);
     return arr;
 }
 bool *getDirtyFlags(BM_BufferPool *bm) {
     PoolMetadata *md = bm->mgmtData;
     bool *flags = malloc(sizeof(bool) * md->capacity);
-    for (int i = 0; i < md->capacity; i++) flags[i] = md->frames[i].isDirty;
+    for (int i = 0; i < md->capacity; i++) flags[i] = LOAD_ACQ(&md->frames[i].isDirty);
     return flags;
 }
 int *getFixCounts(BM_BufferPool *bm) {
     PoolMetadata *md = bm->mgmtData;
     int *cnt = malloc(sizeof(int) * md->capacity);
-    for (int i = 0; i < md->capacity; i++) cnt[i] = md->frames[i].pinCount;
+    for (int i = 0; i < md->capacity; i++) {
+        int pins = LOAD_ACQ(&md->frames[i].pinCount);
+        cnt[i] = pins < 0 ? 0 : pins;
+    }
     return cnt;
 }
+
+// Snapshot of frame i for inspectPool and summarizePool
+static void readFrameInfo(PoolMetadata *md, int i, BM_FrameInfo *info) {
+    Frame *f = &md->frames[i];
+    int pins = LOAD_ACQ(&f->pinCount);
+    info->frame = i;
+    info->pageNum = LOAD_ACQ(&f->pageId);
+    info->dirty = LOAD_ACQ(&f->isDirty);
+    info->fixCount = pins < 0 ? 0 : pins; // claimed frames count as unpinned
+}
+
+static bool frameMatches(const BM_InspectFilter *filter, const BM_FrameInfo *info) {
+    if (!filter) return true;
+    if (info->pageNum == NO_PAGE)
+        return !filter->flags && filter->firstPage == NO_PAGE && filter->lastPage == NO_PAGE;
+    if ((filter->flags & BM_INSPECT_DIRTY) && !info->dirty) return false;
+    if ((filter->flags & BM_INSPECT_PINNED) && info->fixCount == 0) return false;
+    if (filter->firstPage != NO_PAGE && info->pageNum < filter->firstPage) return false;
+    if (filter->lastPage != NO_PAGE && info->pageNum > filter->lastPage) return false;
+    return true;
+}
+
+// Stream the matching frames to visit, one at a time
+RC inspectPool(BM_BufferPool *bm, const BM_InspectFilter *filter,
+               BM_FrameVisitor visit, void *ctx) {
+    if (!bm || !bm->mgmtData) return RC_FILE_HANDLE_NOT_INIT;
+    PoolMetadata *md = bm->mgmtData;
+    BM_FrameInfo info;
+    for (int i = 0; i < md->capacity; i++) {
+        readFrameInfo(md, i, &info);
+        if (frameMatches(filter, &info) && visit(&info, ctx)) break;
+    }
+    return RC_OK;
+}
+
+// Counts and histograms over all frames, in constant space
+RC summarizePool(BM_BufferPool *bm, BM_PoolSummary *summary) {
+    if (!bm || !bm->mgmtData) return RC_FILE_HANDLE_NOT_INIT;
+    PoolMetadata *md = bm->mgmtData;
+    BM_FrameInfo info;
+    memset(summary, 0, sizeof(BM_PoolSummary));
+    summary->minPage = summary->maxPage = NO_PAGE;
+    pthread_mutex_lock(&md->fileLock);
+    int filePages = md->fh.totalNumPages;
+    pthread_mutex_unlock(&md->fileLock);
+    summary->bucketPages = (filePages + BM_SUMMARY_BUCKETS - 1) / BM_SUMMARY_BUCKETS;
+    if (summary->bucketPages < 1) summary->bucketPages = 1;
+    for (int i = 0; i < md->capacity; i++) {
+        readFrameInfo(md, i, &info);
+        summary->frames++;
+        if (info.pageNum == NO_PAGE) {
+            summary->emptyFrames++;
+            summary->fixCounts[0]++;
+            continue;
+        }
+        if (summary->minPage == NO_PAGE || info.pageNum < summary->minPage) summary->minPage = info.pageNum;
+        if (info.pageNum > summary->maxPage) summary->maxPage = info.pageNum;
+        // pages being appended past the file size land in the last bucket
+        int b = info.pageNum / summary->bucketPages;
+        if (b >= BM_SUMMARY_BUCKETS) b = BM_SUMMARY_BUCKETS - 1;
+        summary->resident[b]++;
+        if (info.dirty) {
+            summary->dirtyFrames++;
+            summary->dirty[b]++;
+        }
+        if (info.fixCount > 0) {
+            summary->pinnedFrames++;
+            summary->pinned[b]++;
+        }
+        int fb = 0;
+        while (fb < BM_FIX_BUCKETS - 1 && info.fixCount > (fb < 2 ? fb : 1 << (fb - 1))) fb++;
+        summary->fixCounts[fb]++;
+    }
+    return RC_OK;
+}
+
 int getNumReadIO(BM_BufferPool *bm) { return ((PoolMetadata *)bm->mgmtData)->readIO; }
 int getNumWriteIO(BM_BufferPool *bm) { return ((PoolMetadata *)bm->mgmtData)->writeIO; }
+
+// Counters not covered by getNumReadIO/getNumWriteIO
+RC getPoolStats(BM_BufferPool *bm, BM_PoolStats *stats) {
+    if (!bm || !bm->mgmtData) return RC_FILE_HANDLE_NOT_INIT;
+    PoolMetadata *md = bm->mgmtData;
+    pthread_mutex_lock(&md->latch);
+    stats->numReadIO = md->readIO;
+    stats->numWriteIO = md->writeIO;
+    stats->freeFrames = freeFrames(md);
+    stats->poolSize = md->poolSize;
+    stats->keepFrames = md->keepFrames;
+    stats->fgEvictions = md->fgEvictions;
+    stats->bgEvictions = md->bgEvictions;
+    stats->fgEvictNanos = md->fgEvictNanos;
+    stats->bgEvictNanos = md->bgEvictNanos;
+    stats->remoteAccesses = LOAD_RLX(&md->remoteAccesses);
+    stats->remoteAllocations = md->remoteAllocs;
+    stats->coalescedWrites = md->coalescedPages;
+    stats->failedWrites = md->failedWrites;
+    pthread_mutex_lock(&md->fileLock);
+    stats->filePages = md->fh.totalNumPages;
+    pthread_mutex_unlock(&md->fileLock);
+    pthread_mutex_unlock(&md->latch);
+    stats->pins = totalPins(md);
+    for (int b = 0; b < BM_LATENCY_BUCKETS; b++) {
+        stats->readLatency[b] = LOAD_RLX(&md->readLatency[b]);
+        stats->writeLatency[b] = LOAD_RLX(&md->writeLatency[b]);
+    }
+    stats->readNanos = LOAD_RLX(&md->readNanos);
+    stats->writeNanos = LOAD_RLX(&md->writeNanos);
+    // scanned without the latch so a large pool doesn't stall pins
+    stats->dirtyFrames = stats->pinnedFrames = 0;
+    for (int i = 0; i < md->capacity; i++) {
+        Frame *f = &md->frames[i];
+        if (LOAD_ACQ(&f->pageId) == NO_PAGE) continue;
+        if (LOAD_ACQ(&f->isDirty)) stats->dirtyFrames++;
+        if (LOAD_ACQ(&f->pinCount) > 0) stats->pinnedFrames++;
+    }
+    return RC_OK;
+}
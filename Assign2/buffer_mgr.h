@@ -7,6 +7,8 @@
 // Include bool DT
 #include "dt.h"
 
+#include <stdint.h>
+
 // Replacement Strategies
 typedef enum ReplacementStrategy {
 	RS_FIFO = 0,
@@ -33,6 +35,153 @@ typedef struct BM_PageHandle {
 	char *data;
 } BM_PageHandle;
 
+// Swizzled page reference for higher layers (e.g. index child pointers).
+// While the page is resident, word holds its frame directly and pinning
+// through the swip skips the page table; otherwise word holds
+// (pageNum << 1) | 1. Eviction unswizzles every swip pointing at a frame.
+typedef struct BM_Swip {
+	uintptr_t word;
+	struct BM_Swip *nextRef; // next swip swizzled to the same frame
+} BM_Swip;
+
+// Completion callback for pinPageAsync; rc is the result of the pin
+typedef void (*BM_PinCallback)(BM_BufferPool *bm, BM_PageHandle *page,
+		RC rc, void *ctx);
+
+// Consecutive pages pinned in adjacent frames, see pinExtent. data covers
+// count * PAGE_SIZE bytes; page firstPage + k starts at data + k * PAGE_SIZE.
+typedef struct BM_ExtentHandle {
+	PageNumber firstPage;
+	int count;
+	char *data;
+} BM_ExtentHandle;
+
+// Client (tenant or session) of a shared pool, see openClient
+typedef struct BM_Client {
+	BM_BufferPool *pool;
+	int id;
+} BM_Client;
+
+// Retention hints for setPagePriority. The replacement policies take
+// BM_PRIO_HIGH pages only when no normal page can go, and never evict the
+// keep-resident set (BM_PRIO_KEEP pages beyond its bound count as high).
+typedef enum BM_PagePriority {
+	BM_PRIO_NORMAL = 0,
+	BM_PRIO_HIGH = 1,
+	BM_PRIO_KEEP = 2
+} BM_PagePriority;
+
+// Pool options for initBufferPoolWithConfig; initPoolConfig fills defaults
+typedef struct BM_PoolConfig {
+	int ioWorkers; // threads serving misses; 0 = the pinning thread does its own I/O
+	// a background evictor refills the free list to the high watermark once
+	// it drops below the low one, so misses skip the replacement policy (0 = off)
+	int freeLowWatermark;
+	int freeHighWatermark;
+	// split the frames into per-node partitions with node-local memory;
+	// -1 = one per NUMA node of the host, 0 or 1 = a single partition
+	int numaNodes;
+	// adaptive sizing: with maxPages > 0 frames for up to maxPages are set up
+	// and a sizer thread moves the pool between minPages and maxPages
+	// following the cgroup's memory use and pressure
+	int minPages;
+	int maxPages;
+	const char *cgroupPath; // cgroup v2 directory; NULL = the process's own
+	int resizeIntervalMs;
+	int keepResidentMax; // size of the keep-resident set; 0 = a quarter of the current pool size
+	// when a miss writes back a dirty victim, also write up to this many
+	// adjacent dirty, unpinned pages on each side in the same write (0 = off)
+	int writeCoalesceWindow;
+	// record every API call to this file for bench_replay (see bm_trace.h);
+	// NULL = off. initPoolConfig sets it from the BM_TRACE environment variable.
+	const char *traceFile;
+	// estimate online what hit ratio other pool sizes would give (see
+	// getHitRatioCurve); sampled pins take a mutex (0 = off)
+	int hitRatioCurve;
+} BM_PoolConfig;
+
+// Storage-call latency histograms: bucket i counts calls that took under
+// 2^i microseconds, the last bucket everything slower
+#define BM_LATENCY_BUCKETS 20
+
+// Counters reported by getPoolStats. Foreground eviction is the inline
+// selectVictim + write-back of a miss; background is the evictor thread.
+typedef struct BM_PoolStats {
+	int numReadIO;
+	int numWriteIO;
+	int freeFrames;
+	int poolSize; // frames the pool may use now (see resizeBufferPool)
+	int keepFrames; // frames in the keep-resident set
+	unsigned long fgEvictions;
+	unsigned long bgEvictions;
+	long long fgEvictNanos;
+	long long bgEvictNanos;
+	unsigned long remoteAccesses;    // hits on a frame of another node's partition
+	unsigned long remoteAllocations; // misses that had to take a remote frame
+	unsigned long coalescedWrites;   // pages written along with a dirty victim
+	unsigned long failedWrites;      // write-backs that failed; the page stayed dirty
+	unsigned long pins;              // pin calls, hits and misses
+	int dirtyFrames;                 // dirty and pinned frames are counted
+	int pinnedFrames;                // without the latch, so only a snapshot
+	int filePages;                   // pages in the page file
+	// one count per readBlock(s)/writeBlock(s) call, with the total time
+	unsigned long readLatency[BM_LATENCY_BUCKETS];
+	unsigned long writeLatency[BM_LATENCY_BUCKETS];
+	long long readNanos;
+	long long writeNanos;
+} BM_PoolStats;
+
+// Filter for inspectPool; a frame has to match every condition given.
+// firstPage/lastPage bound the page numbers (NO_PAGE = unbounded); empty
+// frames only match a filter with no flags and no bounds.
+#define BM_INSPECT_DIRTY  1 // dirty frames only
+#define BM_INSPECT_PINNED 2 // frames with a fix count above zero only
+typedef struct BM_InspectFilter {
+	int flags;
+	PageNumber firstPage;
+	PageNumber lastPage;
+} BM_InspectFilter;
+
+// One frame as reported by inspectPool
+typedef struct BM_FrameInfo {
+	int frame;
+	PageNumber pageNum; // NO_PAGE for an empty frame
+	bool dirty;
+	int fixCount;
+} BM_FrameInfo;
+
+// Called for each matching frame, in frame order; nonzero stops the walk
+typedef int (*BM_FrameVisitor)(const BM_FrameInfo *info, void *ctx);
+
+// Fixed-size view of a pool of any size, filled by summarizePool
+#define BM_SUMMARY_BUCKETS 16
+#define BM_FIX_BUCKETS 8
+typedef struct BM_PoolSummary {
+	int frames;
+	int emptyFrames;
+	int dirtyFrames;
+	int pinnedFrames;
+	PageNumber minPage, maxPage; // resident page range, NO_PAGE if none
+	// resident, dirty and pinned pages by page number: bucket i covers
+	// pages [i * bucketPages, (i + 1) * bucketPages) of the file
+	int bucketPages;
+	int resident[BM_SUMMARY_BUCKETS];
+	int dirty[BM_SUMMARY_BUCKETS];
+	int pinned[BM_SUMMARY_BUCKETS];
+	// frames by fix count: 0, 1, 2, 3-4, 5-8, 9-16, 17-32, more
+	int fixCounts[BM_FIX_BUCKETS];
+} BM_PoolSummary;
+
+// Hit ratios the workload so far would get at other pool sizes, estimated
+// from sampled LRU reuse distances (SHARDS); filled by getHitRatioCurve
+#define BM_CURVE_POINTS 4
+typedef struct BM_HitRatioCurve {
+	int pages[BM_CURVE_POINTS];       // 0.5x, 1x, 2x and 4x the current pool size
+	double hitRatio[BM_CURVE_POINTS];
+	double sampleRate;                // share of the pages whose pins are sampled
+	unsigned long sampledPins;
+} BM_HitRatioCurve;
+
 // convenience macros
 #define MAKE_POOL()					\
 		((BM_BufferPool *) malloc (sizeof(BM_BufferPool)))
@@ -41,18 +190,63 @@ typedef struct BM_PageHandle {
 		((BM_PageHandle *) malloc (sizeof(BM_PageHandle)))
 
 // Buffer Manager Interface Pool Handling
+// For RS_CLOCK, stratData may point to an int > 1 to run GCLOCK with that
+// reference counter limit. CLOCK pins hit without taking the pool latch.
 RC initBufferPool(BM_BufferPool *const bm, const char *const pageFileName, 
 		const int numPages, ReplacementStrategy strategy,
 		void *stratData);
+void initPoolConfig (BM_PoolConfig *const cfg);
+RC initBufferPoolWithConfig(BM_BufferPool *const bm, const char *const pageFileName,
+		const int numPages, ReplacementStrategy strategy,
+		void *stratData, const BM_PoolConfig *const cfg);
 RC shutdownBufferPool(BM_BufferPool *const bm);
 RC forceFlushPool(BM_BufferPool *const bm);
+// Change how many frames the pool may use, up to the frames set up at init
+// (bm->numPages). Shrinking evicts through the replacement policy.
+RC resizeBufferPool(BM_BufferPool *const bm, const int numPages);
+// Clients: pages a client misses on count against its frame quota. At the
+// quota its own coldest page is replaced instead of anyone else's.
+RC openClient(BM_BufferPool *const bm, BM_Client *const client, const int quota);
+RC closeClient(BM_Client *const client);
+RC pinPageForClient(BM_Client *const client, BM_PageHandle *const page,
+		const PageNumber pageNum);
+int getClientFrames(BM_Client *const client);
+
+// Retention priority for the pages [first, last], e.g. index roots
+RC setPagePriority(BM_BufferPool *const bm, const PageNumber first,
+		const PageNumber last, BM_PagePriority prio);
 
 // Buffer Manager Interface Access Pages
 RC markDirty (BM_BufferPool *const bm, BM_PageHandle *const page);
 RC unpinPage (BM_BufferPool *const bm, BM_PageHandle *const page);
 RC forcePage (BM_BufferPool *const bm, BM_PageHandle *const page);
+// On a shadow-paged file, make what forcePage, forceFlushPool and write-backs
+// wrote since the last commit durable as one step: all of it or, after a
+// crash, none (commitPageFile); on other files only a flush
+RC commitPool (BM_BufferPool *const bm);
 RC pinPage (BM_BufferPool *const bm, BM_PageHandle *const page, 
 		const PageNumber pageNum);
+// Returns RC_OK on a hit. On a miss, or while the page is being read or
+// written back, returns RC_BM_PIN_PENDING without blocking and calls
+// callback from the pool's completion thread once the page is pinned. The
+// callback may pin and unpin pages itself, blocking calls included.
+RC pinPageAsync (BM_BufferPool *const bm, BM_PageHandle *const page,
+		const PageNumber pageNum, BM_PinCallback callback, void *ctx);
+
+// Extents: pin pages [startPage, startPage+count) as one contiguous buffer.
+// Fails with RC_BM_EXTENT_UNAVAILABLE if one of the pages is pinned or no
+// partition has count adjacent frames that can be replaced.
+RC pinExtent (BM_BufferPool *const bm, const PageNumber startPage, const int count,
+		BM_ExtentHandle *const extent);
+RC unpinExtent (BM_BufferPool *const bm, BM_ExtentHandle *const extent);
+RC markExtentDirty (BM_BufferPool *const bm, BM_ExtentHandle *const extent);
+
+// Swizzled references
+void initSwip (BM_Swip *const swip, const PageNumber pageNum);
+PageNumber getSwipPage (BM_BufferPool *const bm, BM_Swip *const swip);
+RC pinSwip (BM_BufferPool *const bm, BM_Swip *const swip, BM_PageHandle *const page);
+RC unpinSwip (BM_BufferPool *const bm, BM_Swip *const swip);
+RC releaseSwip (BM_BufferPool *const bm, BM_Swip *const swip);
 
 // Statistics Interface
 PageNumber *getFrameContents (BM_BufferPool *const bm);
@@ -60,5 +254,13 @@ bool *getDirtyFlags (BM_BufferPool *const bm);
 int *getFixCounts (BM_BufferPool *const bm);
 int getNumReadIO (BM_BufferPool *const bm);
 int getNumWriteIO (BM_BufferPool *const bm);
+RC getPoolStats (BM_BufferPool *const bm, BM_PoolStats *const stats);
+// Walk the frames without the latch or any allocation; what a frame holds
+// may change while it is reported. filter NULL visits every frame.
+RC inspectPool (BM_BufferPool *const bm, const BM_InspectFilter *filter,
+		BM_FrameVisitor visit, void *ctx);
+RC summarizePool (BM_BufferPool *const bm, BM_PoolSummary *const summary);
+// RC_BM_NOT_ENABLED unless the pool was opened with hitRatioCurve set
+RC getHitRatioCurve (BM_BufferPool *const bm, BM_HitRatioCurve *const curve);
 
 #endif
@@ -0,0 +1,72 @@
+#ifndef BUFFER_MGR_ASYNC_HPP
+#define BUFFER_MGR_ASYNC_HPP
+
+// Thin C++20 awaitable over pinPageAsync:
+//
+//   BM_PageHandle h;
+//   RC rc = co_await bm::pinAwait(pool, &h, pageNum);
+//
+// A hit resumes immediately; a miss resumes the coroutine on the pool's
+// completion thread.
+
+#include <coroutine>
+
+// dt.h typedefs bool unless it is a macro; C builds use -Dbool=_Bool,
+// which has the same layout as C++ bool
+#ifndef bool
+#define bool bool
+#define BUFFER_MGR_ASYNC_UNDEF_BOOL
+#endif
+
+extern "C" {
+#include "buffer_mgr.h"
+}
+
+#ifdef BUFFER_MGR_ASYNC_UNDEF_BOOL
+#undef bool
+#undef BUFFER_MGR_ASYNC_UNDEF_BOOL
+#endif
+
+namespace bm {
+
+class PinAwaitable {
+public:
+	PinAwaitable(BM_BufferPool *pool, BM_PageHandle *page, PageNumber pageNum)
+		: pool_(pool), page_(page), pageNum_(pageNum), rc_(RC_OK) {}
+
+	bool await_ready() const noexcept { return false; }
+
+	// The callback may resume the coroutine before this returns, so nothing
+	// here touches the awaitable after pinPageAsync has queued the miss.
+	bool await_suspend(std::coroutine_handle<> h) {
+		waiter_ = h;
+		RC rc = pinPageAsync(pool_, page_, pageNum_, &PinAwaitable::done, this);
+		if (rc == RC_BM_PIN_PENDING)
+			return true;
+		rc_ = rc;
+		return false;
+	}
+
+	RC await_resume() const noexcept { return rc_; }
+
+private:
+	static void done(BM_BufferPool *, BM_PageHandle *, RC rc, void *ctx) {
+		PinAwaitable *self = static_cast<PinAwaitable *>(ctx);
+		self->rc_ = rc;
+		self->waiter_.resume();
+	}
+
+	BM_BufferPool *pool_;
+	BM_PageHandle *page_;
+	PageNumber pageNum_;
+	RC rc_;
+	std::coroutine_handle<> waiter_;
+};
+
+inline PinAwaitable pinAwait(BM_BufferPool *pool, BM_PageHandle *page, PageNumber pageNum) {
+	return PinAwaitable(pool, page, pageNum);
+}
+
+} // namespace bm
+
+#endif // BUFFER_MGR_ASYNC_HPP
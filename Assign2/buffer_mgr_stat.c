@@ -7,47 +7,115 @@
 // local functions
 static void printStrat (BM_BufferPool *const bm);
 
+// state of a printPoolContent / sprintPoolContent walk
+typedef struct PoolPrinter {
+	int numPages;
+	int printed;
+	int withFrame;
+	char *message;
+	int pos;
+} PoolPrinter;
+
+// print one frame as [page dirty fix], optionally prefixed with its index
+static int
+printFrame (const BM_FrameInfo *info, void *ctx)
+{
+	PoolPrinter *p = (PoolPrinter *) ctx;
+
+	if (info->frame >= p->numPages)
+		return 1;
+	if (p->withFrame)
+		printf("%s%i:[%i%s%i]", ((p->printed == 0) ? "" : ","), info->frame, info->pageNum, (info->dirty ? "x": " "), info->fixCount);
+	else
+		printf("%s[%i%s%i]", ((p->printed == 0) ? "" : ","), info->pageNum, (info->dirty ? "x": " "), info->fixCount);
+	p->printed++;
+	return 0;
+}
+
+static int
+sprintFrame (const BM_FrameInfo *info, void *ctx)
+{
+	PoolPrinter *p = (PoolPrinter *) ctx;
+
+	if (info->frame >= p->numPages)
+		return 1;
+	p->pos += sprintf(p->message + p->pos, "%s[%i%s%i]", ((p->printed == 0) ? "" : ","), info->pageNum, (info->dirty ? "x": " "), info->fixCount);
+	p->printed++;
+	return 0;
+}
+
 // external functions
 void 
 printPoolContent (BM_BufferPool *const bm)
 {
-	PageNumber *frameContent;
-	bool *dirty;
-	int *fixCount;
-	int i;
+	PoolPrinter p = { bm->numPages, 0, 0, NULL, 0 };
+
+	printf("{");
+	printStrat(bm);
+	printf(" %i}: ", bm->numPages);
 
-	frameContent = getFrameContents(bm);
-	dirty = getDirtyFlags(bm);
-	fixCount = getFixCounts(bm);
+	// streamed frame by frame, no per-call arrays
+	inspectPool(bm, NULL, printFrame, &p);
+	printf("\n");
+}
+
+// print only the frames matching filter, each with its frame index
+void
+printPoolContentFiltered (BM_BufferPool *const bm, const BM_InspectFilter *filter)
+{
+	PoolPrinter p = { bm->numPages, 0, 1, NULL, 0 };
 
 	printf("{");
 	printStrat(bm);
 	printf(" %i}: ", bm->numPages);
 
-	for (i = 0; i < bm->numPages; i++)
-		printf("%s[%i%s%i]", ((i == 0) ? "" : ",") , frameContent[i], (dirty[i] ? "x": " "), fixCount[i]);
+	inspectPool(bm, filter, printFrame, &p);
 	printf("\n");
 }
 
-char *
-sprintPoolContent (BM_BufferPool *const bm)
+// print the summarizePool histograms; the output size does not grow with the pool
+void
+printPoolSummary (BM_BufferPool *const bm)
 {
-	PageNumber *frameContent;
-	bool *dirty;
-	int *fixCount;
+	BM_PoolSummary s;
+	BM_HitRatioCurve curve;
+	const char *fixLabels[BM_FIX_BUCKETS] = { "0", "1", "2", "3-4", "5-8", "9-16", "17-32", ">32" };
 	int i;
-	char *message;
-	int pos = 0;
 
-	message = (char *) malloc(256 + (22 * bm->numPages));
-	frameContent = getFrameContents(bm);
-	dirty = getDirtyFlags(bm);
-	fixCount = getFixCounts(bm);
+	if (summarizePool(bm, &s) != RC_OK)
+		return;
+
+	printf("{");
+	printStrat(bm);
+	printf(" %i}: %i frames, %i empty, %i dirty, %i pinned, pages %i..%i\n",
+			bm->numPages, s.frames, s.emptyFrames, s.dirtyFrames, s.pinnedFrames, s.minPage, s.maxPage);
+	for (i = 0; i < BM_SUMMARY_BUCKETS; i++)
+		if (s.resident[i] > 0)
+			printf("  pages %i-%i: %i resident, %i dirty, %i pinned\n", i * s.bucketPages,
+					(i + 1) * s.bucketPages - 1, s.resident[i], s.dirty[i], s.pinned[i]);
+	printf("  fix counts:");
+	for (i = 0; i < BM_FIX_BUCKETS; i++)
+		printf(" %s=%i", fixLabels[i], s.fixCounts[i]);
+	printf("\n");
+	if (getHitRatioCurve(bm, &curve) == RC_OK)
+	{
+		printf("  estimated hit ratio:");
+		for (i = 0; i < BM_CURVE_POINTS; i++)
+			printf(" %i pages=%.3f", curve.pages[i], curve.hitRatio[i]);
+		printf("\n");
+	}
+}
+
+char *
+sprintPoolContent (BM_BufferPool *const bm)
+{
+	PoolPrinter p = { bm->numPages, 0, 0, NULL, 0 };
 
-	for (i = 0; i < bm->numPages; i++)
-		pos += sprintf(message + pos, "%s[%i%s%i]", ((i == 0) ? "" : ",") , frameContent[i], (dirty[i] ? "x": " "), fixCount[i]);
+	p.message = (char *) malloc(256 + (22 * bm->numPages));
+	p.message[0] = '\0';
+	inspectPool(bm, NULL, sprintFrame, &p);
 
-	return message;
+	return p.message;
 }
 
 
@@ -7,6 +7,9 @@
 void printPoolContent (BM_BufferPool *const bm);
 void printPageContent (BM_PageHandle *const page);
 char *sprintPoolContent (BM_BufferPool *const bm);
+// bounded views for large pools
+void printPoolContentFiltered (BM_BufferPool *const bm, const BM_InspectFilter *filter);
+void printPoolSummary (BM_BufferPool *const bm);
 char *sprintPageContent (BM_PageHandle *const page);
 
 #endif
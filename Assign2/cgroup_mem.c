@@ -0,0 +1,59 @@
+// strdup is POSIX, not plain C99
+#define _POSIX_C_SOURCE 200809L
+
+#include "cgroup_mem.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CGROUP_ROOT "/sys/fs/cgroup"
+
+// Read the first line of dir/name into buf
+static int readLine(const char *dir, const char *name, char *buf, int len) {
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    FILE *fp = fopen(path, "r");
+    if (!fp) return 0;
+    int ok = fgets(buf, len, fp) != NULL;
+    fclose(fp);
+    return ok;
+}
+
+char *findCgroupDir(void) {
+    // cgroup v2 has a single "0::/path" entry
+    FILE *fp = fopen("/proc/self/cgroup", "r");
+    if (!fp) return NULL;
+    char line[4096];
+    char *dir = NULL;
+    while (fgets(line, sizeof(line), fp)) {
+        if (strncmp(line, "0::", 3) != 0) continue;
+        line[strcspn(line, "\n")] = '\0';
+        dir = malloc(strlen(CGROUP_ROOT) + strlen(line + 3) + 1);
+        strcpy(dir, CGROUP_ROOT);
+        if (strcmp(line + 3, "/") != 0) strcat(dir, line + 3);
+        break;
+    }
+    fclose(fp);
+    return dir;
+}
+
+RC readCgroupMemory(const char *dir, CgroupMemory *mem) {
+    char buf[256];
+    if (!readLine(dir, "memory.current", buf, sizeof(buf)))
+        THROW(RC_FILE_NOT_FOUND, "readCgroupMemory: no memory.current");
+    mem->current = atoll(buf);
+
+    // "max" when the cgroup has no limit
+    mem->max = -1;
+    if (readLine(dir, "memory.max", buf, sizeof(buf)) && strncmp(buf, "max", 3) != 0)
+        mem->max = atoll(buf);
+
+    // "some avg10=0.12 avg60=0.05 avg300=0.01 total=1234"
+    mem->someAvg10 = 0;
+    if (readLine(dir, "memory.pressure", buf, sizeof(buf))) {
+        char *avg = strstr(buf, "avg10=");
+        if (strncmp(buf, "some", 4) == 0 && avg) mem->someAvg10 = atof(avg + 6);
+    }
+    return RC_OK;
+}
@@ -0,0 +1,19 @@
+#ifndef CGROUP_MEM_H
+#define CGROUP_MEM_H
+
+#include "dberror.h"
+
+// Memory state of a cgroup v2 directory
+typedef struct CgroupMemory {
+	long long current; // memory.current in bytes
+	long long max;     // memory.max in bytes, -1 = no limit
+	double someAvg10;  // "some avg10" of memory.pressure in percent (0 without PSI)
+} CgroupMemory;
+
+// cgroup v2 directory of this process (malloc'ed), NULL outside cgroup v2
+char *findCgroupDir (void);
+
+// Read memory.current, memory.max and memory.pressure from dir
+RC readCgroupMemory (const char *dir, CgroupMemory *const mem);
+
+#endif
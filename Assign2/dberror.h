@@ -14,6 +14,12 @@ typedef int RC;
 #define RC_FILE_HANDLE_NOT_INIT 2
 #define RC_WRITE_FAILED 3
 #define RC_READ_NON_EXISTING_PAGE 4
+#define RC_COMMIT_CONFLICT 5
+
+#define RC_BM_PIN_PENDING 100
+#define RC_BM_OUT_OF_MEMORY 101
+#define RC_BM_EXTENT_UNAVAILABLE 102
+#define RC_BM_NOT_ENABLED 103
 
 #define RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE 200
 #define RC_RM_EXPR_RESULT_IS_NOT_BOOLEAN 201
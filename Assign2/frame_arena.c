@@ -0,0 +1,159 @@
+// sched_getcpu and thread affinity are GNU extensions
+#define _GNU_SOURCE
+
+#include "frame_arena.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#ifdef __linux__
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+#define MAX_NUMA_NODES 64
+#define MAX_CPUS 1024
+
+// mempolicy mode from <numaif.h>; we don't want a libnuma dependency
+#ifndef MPOL_BIND
+#define MPOL_BIND 2
+#endif
+
+// cpu -> node map read once from sysfs
+static short cpuNode[MAX_CPUS];
+static int numNodes = 1;
+static pthread_once_t topologyOnce = PTHREAD_ONCE_INIT;
+
+// Parse a sysfs cpu list such as "0-3,8-11" into cpuNode
+static void parseCpuList(const char *list, int node) {
+    const char *p = list;
+    while (*p) {
+        char *end;
+        long lo = strtol(p, &end, 10);
+        if (end == p) break;
+        long hi = lo;
+        if (*end == '-') {
+            p = end + 1;
+            hi = strtol(p, &end, 10);
+        }
+        for (long cpu = lo; cpu <= hi && cpu < MAX_CPUS; cpu++)
+            if (cpu >= 0) cpuNode[cpu] = (short) node;
+        p = (*end == ',') ? end + 1 : end;
+        if (*p == '\n') break;
+    }
+}
+
+// Read /sys/devices/system/node/node*/cpulist
+static void loadTopology(void) {
+    for (int cpu = 0; cpu < MAX_CPUS; cpu++) cpuNode[cpu] = 0;
+    for (int node = 0; node < MAX_NUMA_NODES; node++) {
+        char path[64];
+        char list[1024];
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+        FILE *fp = fopen(path, "r");
+        if (!fp) continue;
+        if (fgets(list, sizeof(list), fp)) parseCpuList(list, node);
+        fclose(fp);
+        numNodes = node + 1;
+    }
+}
+
+int numaNodeCount(void) {
+    pthread_once(&topologyOnce, loadTopology);
+    return numNodes;
+}
+
+int currentNumaNode(void) {
+#ifdef __linux__
+    pthread_once(&topologyOnce, loadTopology);
+    int cpu = sched_getcpu();
+    if (cpu >= 0 && cpu < MAX_CPUS) return cpuNode[cpu];
+#endif
+    return 0;
+}
+
+#ifdef __linux__
+// Thread body for first-touch placement
+static void *touchArena(void *arg) {
+    FrameArena *arena = arg;
+    memset(arena->base, 0, arena->bytes);
+    return NULL;
+}
+
+// Fault the arena in from a thread restricted to the node's cpus
+static void firstTouchOnNode(FrameArena *arena, int node) {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    int count = 0;
+    for (int cpu = 0; cpu < MAX_CPUS && cpu < CPU_SETSIZE; cpu++) {
+        if (cpuNode[cpu] == node) {
+            CPU_SET(cpu, &cpus);
+            count++;
+        }
+    }
+    if (count == 0) return; // memory-only node or unknown topology
+
+    pthread_attr_t attr;
+    pthread_t toucher;
+    pthread_attr_init(&attr);
+    pthread_attr_setaffinity_np(&attr, sizeof(cpus), &cpus);
+    if (pthread_create(&toucher, &attr, touchArena, arena) == 0)
+        pthread_join(toucher, NULL);
+    pthread_attr_destroy(&attr);
+}
+#endif
+
+RC allocFrameArena(FrameArena *arena, size_t bytes, int node) {
+    arena->bytes = bytes;
+    arena->node = node;
+#ifdef __linux__
+    void *base = mmap(NULL, bytes, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED)
+        THROW(RC_BM_OUT_OF_MEMORY, "allocFrameArena: mmap failed");
+    arena->base = base;
+    arena->mapped = 1;
+    if (node >= 0 && node < MAX_NUMA_NODES) {
+        pthread_once(&topologyOnce, loadTopology);
+        unsigned long mask[MAX_NUMA_NODES / (8 * sizeof(unsigned long)) + 1];
+        memset(mask, 0, sizeof(mask));
+        mask[node / (8 * sizeof(unsigned long))] |= 1UL << (node % (8 * sizeof(unsigned long)));
+        if (syscall(SYS_mbind, base, bytes, MPOL_BIND, mask, MAX_NUMA_NODES + 1, 0) != 0)
+            firstTouchOnNode(arena, node);
+    }
+#else
+    arena->base = calloc(1, bytes);
+    if (!arena->base)
+        THROW(RC_BM_OUT_OF_MEMORY, "allocFrameArena: allocation failed");
+    arena->mapped = 0;
+#endif
+    return RC_OK;
+}
+
+void freeFrameArena(FrameArena *arena) {
+    if (!arena->base) return;
+#ifdef __linux__
+    if (arena->mapped) munmap(arena->base, arena->bytes);
+    else free(arena->base);
+#else
+    free(arena->base);
+#endif
+    arena->base = NULL;
+}
+
+void releaseArenaRange(FrameArena *arena, char *p, size_t bytes) {
+#ifdef __linux__
+    size_t osPage = (size_t) sysconf(_SC_PAGESIZE);
+    if (!arena->mapped || (size_t) (p - arena->base) % osPage != 0 || bytes % osPage != 0)
+        return;
+    madvise(p, bytes, MADV_DONTNEED);
+#else
+    (void) arena;
+    (void) p;
+    (void) bytes;
+#endif
+}
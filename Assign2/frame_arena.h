@@ -0,0 +1,30 @@
+#ifndef FRAME_ARENA_H
+#define FRAME_ARENA_H
+
+#include <stddef.h>
+
+#include "dberror.h"
+
+// Page-aligned block of frame memory, optionally placed on one NUMA node
+typedef struct FrameArena {
+	char *base;
+	size_t bytes;
+	int node;   // node requested at allocation, -1 for no placement
+	int mapped; // memory came from mmap rather than malloc
+} FrameArena;
+
+// NUMA topology (1 node on non-Linux hosts or when sysfs is unavailable)
+int numaNodeCount (void);
+int currentNumaNode (void);
+
+// Allocate bytes of frame memory. With node >= 0 the pages are bound to
+// that node with mbind, or first-touched by a thread running on it when
+// mbind is not permitted.
+RC allocFrameArena (FrameArena *const arena, size_t bytes, int node);
+void freeFrameArena (FrameArena *const arena);
+
+// Give the memory of [p, p + bytes) back to the OS; it reads as zeros when
+// touched again. No-op unless the range covers whole OS pages.
+void releaseArenaRange (FrameArena *const arena, char *p, size_t bytes);
+
+#endif
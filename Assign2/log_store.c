@@ -0,0 +1,561 @@
+// pthreads and strdup are POSIX, not plain C99
+#define _POSIX_C_SOURCE 200809L
+
+#include "log_store.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LOG_MAGIC "LOGPAGES"
+#define RECORD_MAGIC 0x4C475052u
+// the table copy starts one page into the page file
+#define TABLE_OFFSET PAGE_SIZE
+
+// Start of the page file
+typedef struct LogHeader {
+    char magic[8];
+    int segmentPages;
+    int numPages;       // pages of the file, written or not
+    int nextSegment;    // segment numbers handed out so far
+    int clean;          // the table copy is current (closed cleanly)
+    long long nextSeq;
+} LogHeader;
+
+// Header of a record in a segment file; the page data follows
+typedef struct LogRecord {
+    unsigned magic;
+    int page;
+    long long seq;
+    unsigned long long check;
+} LogRecord;
+
+#define RECORD_SIZE ((long) (sizeof(LogRecord) + PAGE_SIZE))
+// stdio buffer of a segment stream: a record, or a run of them, goes out
+// in one write
+#define SEGMENT_BUFFER (16 * RECORD_SIZE)
+
+// Latest record of a page; segment -1 = never written (reads as zeros)
+typedef struct LogLocation {
+    int segment;
+    int slot;
+} LogLocation;
+
+typedef struct LogSegment {
+    FILE *fp;      // NULL once cleaned (or missing)
+    int used;      // records in the file
+    int live;      // records the table points to
+    int cleaning;
+} LogSegment;
+
+struct LogStore {
+    pthread_mutex_t lock;   // everything below, and the streams
+    pthread_cond_t wake;    // a segment to clean, or stop
+    pthread_cond_t cleaned; // a segment cleaning ended
+    pthread_t cleaner;
+    int stop;
+    int waiting;            // reads and writes blocked on the lock
+    FILE *fp;               // page file: header and table copy
+    char *name;
+    LogHeader hdr;
+    int flush;
+    LogLocation *map;
+    int mapCap;
+    LogSegment *segs;       // by segment number
+    int segCap;
+    int head;               // segment appended to, -1 before the first write
+    int headAtEnd;          // the head's stream is at its end (no seek needed)
+    SM_LogStats stats;
+};
+
+// Take the lock for a read or write; the cleaner lets these go first
+static void lockForeground(LogStore *s) {
+    __atomic_fetch_add(&s->waiting, 1, __ATOMIC_RELAXED);
+    pthread_mutex_lock(&s->lock);
+    __atomic_fetch_sub(&s->waiting, 1, __ATOMIC_RELAXED);
+}
+
+// <name>.logstore holds LOG_MAGIC; only logCreate makes it, so a plain page
+// file that happens to start with the magic is never taken for a log
+static void markerPath(const char *fileName, char *path, size_t size) {
+    snprintf(path, size, "%s.logstore", fileName);
+}
+
+static int hasMarker(const char *fileName) {
+    char path[4096], magic[8];
+    markerPath(fileName, path, sizeof(path));
+    FILE *fp = fopen(path, "rb");
+    if (!fp) return 0;
+    int is = fread(magic, sizeof(magic), 1, fp) == 1 && memcmp(magic, LOG_MAGIC, sizeof(magic)) == 0;
+    fclose(fp);
+    return is;
+}
+
+static void segmentPath(const char *fileName, int segment, char *path, size_t size) {
+    snprintf(path, size, "%s.seg%d", fileName, segment);
+}
+
+// Checksum of a record over its page number, sequence number and data, so
+// a torn or stale record is not taken for the latest copy after a crash
+// (four independent lanes, so the multiplies overlap)
+static unsigned long long recordCheck(const LogRecord *rec, const char *data) {
+    unsigned long long h[4] = { (unsigned long long) rec->seq, (unsigned) rec->page, 1, 2 };
+    unsigned long long w[4];
+    for (int i = 0; i < PAGE_SIZE; i += sizeof(w)) {
+        memcpy(w, data + i, sizeof(w));
+        for (int k = 0; k < 4; k++) h[k] = (h[k] ^ w[k]) * 0x9E3779B97F4A7C15ULL;
+    }
+    unsigned long long sum = h[0] ^ (h[1] >> 1) ^ (h[2] >> 2) ^ (h[3] >> 3);
+    return sum ^ (sum >> 29);
+}
+
+static RC writeHeader(LogStore *s) {
+    if (fseek(s->fp, 0L, SEEK_SET) != 0 || fwrite(&s->hdr, sizeof(LogHeader), 1, s->fp) != 1
+        || fflush(s->fp) != 0)
+        return RC_WRITE_FAILED;
+    return RC_OK;
+}
+
+// The table copy goes stale with the first change after open
+static RC markUnclean(LogStore *s) {
+    if (!s->hdr.clean) return RC_OK;
+    s->hdr.clean = 0;
+    return writeHeader(s);
+}
+
+static RC growMap(LogStore *s, int numPages) {
+    if (numPages <= s->mapCap) return RC_OK;
+    int cap = s->mapCap ? s->mapCap : 64;
+    while (cap < numPages) cap *= 2;
+    LogLocation *map = realloc(s->map, sizeof(LogLocation) * cap);
+    if (!map) return RC_WRITE_FAILED;
+    for (int p = s->mapCap; p < cap; p++) map[p].segment = -1;
+    s->map = map;
+    s->mapCap = cap;
+    return RC_OK;
+}
+
+static RC growSegments(LogStore *s, int count) {
+    if (count <= s->segCap) return RC_OK;
+    int cap = s->segCap ? s->segCap : 16;
+    while (cap < count) cap *= 2;
+    LogSegment *segs = realloc(s->segs, sizeof(LogSegment) * cap);
+    if (!segs) return RC_WRITE_FAILED;
+    memset(segs + s->segCap, 0, sizeof(LogSegment) * (cap - s->segCap));
+    s->segs = segs;
+    s->segCap = cap;
+    return RC_OK;
+}
+
+// A segment no longer appended to with at most LOG_CLEAN_LIVE_PERCENT live
+static int worthCleaning(const LogStore *s, int g) {
+    const LogSegment *seg = &s->segs[g];
+    return g != s->head && seg->fp && !seg->cleaning && seg->used > 0
+        && (long) seg->live * 100 <= (long) seg->used * LOG_CLEAN_LIVE_PERCENT;
+}
+
+// The qualifying segment with the fewest live records, -1 if none
+static int pickVictim(const LogStore *s) {
+    int best = -1;
+    for (int g = 0; g < s->hdr.nextSegment; g++)
+        if (worthCleaning(s, g) && (best < 0 || s->segs[g].live < s->segs[best].live)) best = g;
+    return best;
+}
+
+// Point the table at a new record of page and retire its previous one
+static void relocate(LogStore *s, int page, int segment, int slot) {
+    LogLocation *loc = &s->map[page];
+    if (loc->segment >= 0) {
+        s->segs[loc->segment].live--;
+        if (worthCleaning(s, loc->segment)) pthread_cond_signal(&s->wake);
+    }
+    loc->segment = segment;
+    loc->slot = slot;
+    s->segs[segment].live++;
+}
+
+// Start the next segment file. Its number is in the header before the file
+// exists, so recovery never misses a segment.
+static RC openHead(LogStore *s) {
+    int g = s->hdr.nextSegment;
+    char path[4096];
+    if (growSegments(s, g + 1) != RC_OK) return RC_WRITE_FAILED;
+    s->hdr.nextSegment = g + 1;
+    if (writeHeader(s) != RC_OK) return RC_WRITE_FAILED;
+    segmentPath(s->name, g, path, sizeof(path));
+    FILE *fp = fopen(path, "wb+");
+    if (!fp) return RC_WRITE_FAILED;
+    setvbuf(fp, NULL, _IOFBF, SEGMENT_BUFFER);
+    int sealed = s->head;
+    memset(&s->segs[g], 0, sizeof(LogSegment));
+    s->segs[g].fp = fp;
+    s->head = g;
+    s->headAtEnd = 1;
+    if (sealed >= 0 && worthCleaning(s, sealed)) pthread_cond_signal(&s->wake);
+    return RC_OK;
+}
+
+// Append records of pages firstPage .. firstPage+count-1 to the head; they
+// gather in the stream's buffer and go out with one flush
+static RC appendRecords(LogStore *s, int firstPage, int count, char **data) {
+    RC rc = markUnclean(s);
+    for (int i = 0; rc == RC_OK && i < count; i++) {
+        if (s->head < 0 || s->segs[s->head].used == s->hdr.segmentPages) {
+            if (s->head >= 0 && fflush(s->segs[s->head].fp) != 0) return RC_WRITE_FAILED;
+            rc = openHead(s);
+            if (rc != RC_OK) break;
+        }
+        LogSegment *seg = &s->segs[s->head];
+        LogRecord rec = { RECORD_MAGIC, firstPage + i, s->hdr.nextSeq++, 0 };
+        rec.check = recordCheck(&rec, data[i]);
+        if (!s->headAtEnd && fseek(seg->fp, seg->used * RECORD_SIZE, SEEK_SET) != 0)
+            return RC_WRITE_FAILED;
+        s->headAtEnd = 1;
+        if (fwrite(&rec, sizeof(LogRecord), 1, seg->fp) != 1 || fwrite(data[i], PAGE_SIZE, 1, seg->fp) != 1) {
+            // the next append overwrites whatever part made it
+            s->headAtEnd = 0;
+            return RC_WRITE_FAILED;
+        }
+        relocate(s, firstPage + i, s->head, seg->used++);
+    }
+    if (rc == RC_OK && s->flush && s->head >= 0 && fflush(s->segs[s->head].fp) != 0) rc = RC_WRITE_FAILED;
+    return rc;
+}
+
+// Read record slot of segment g: the header too when rec is given
+static RC readRecord(LogStore *s, int g, int slot, LogRecord *rec, char *data) {
+    FILE *fp = s->segs[g].fp;
+    long offset = slot * RECORD_SIZE + (rec ? 0 : (long) sizeof(LogRecord));
+    if (g == s->head) s->headAtEnd = 0;
+    if (fseek(fp, offset, SEEK_SET) != 0 || (rec && fread(rec, sizeof(LogRecord), 1, fp) != 1)
+        || fread(data, PAGE_SIZE, 1, fp) != 1)
+        return RC_READ_NON_EXISTING_PAGE;
+    return RC_OK;
+}
+
+// Move the live records of segment g to the head and delete its file. The
+// lock is dropped between records so reads and writes go on meanwhile; a
+// closing store stops it halfway, keeping the segment.
+static RC cleanSegment(LogStore *s, int g) {
+    LogRecord rec;
+    char *data = malloc(PAGE_SIZE);
+    RC rc = data ? RC_OK : RC_WRITE_FAILED;
+    s->segs[g].cleaning = 1;
+    for (int slot = 0; rc == RC_OK && slot < s->segs[g].used && s->segs[g].live > 0 && !s->stop; slot++) {
+        rc = readRecord(s, g, slot, &rec, data);
+        if (rc != RC_OK) break;
+        if (rec.magic == RECORD_MAGIC && rec.page >= 0 && rec.page < s->hdr.numPages
+            && s->map[rec.page].segment == g && s->map[rec.page].slot == slot) {
+            rc = appendRecords(s, rec.page, 1, &data);
+            if (rc == RC_OK) s->stats.copiedPages++;
+        }
+        pthread_mutex_unlock(&s->lock);
+        if (__atomic_load_n(&s->waiting, __ATOMIC_RELAXED) > 0) sched_yield();
+        pthread_mutex_lock(&s->lock);
+    }
+    if (rc == RC_OK && s->segs[g].live == 0) {
+        char path[4096];
+        // the copies reach the file before the originals go
+        if (s->head >= 0 && fflush(s->segs[s->head].fp) != 0) rc = RC_WRITE_FAILED;
+        if (rc == RC_OK) {
+            // nothing refers to the file any more: close and delete it unlocked
+            FILE *fp = s->segs[g].fp;
+            s->segs[g].fp = NULL;
+            s->stats.cleanedSegments++;
+            segmentPath(s->name, g, path, sizeof(path));
+            pthread_mutex_unlock(&s->lock);
+            fclose(fp);
+            remove(path);
+            pthread_mutex_lock(&s->lock);
+        }
+    }
+    s->segs[g].cleaning = 0;
+    pthread_cond_broadcast(&s->cleaned);
+    free(data);
+    return rc;
+}
+
+static void *cleanerMain(void *arg) {
+    LogStore *s = arg;
+    pthread_mutex_lock(&s->lock);
+    while (!s->stop) {
+        int g = pickVictim(s);
+        // after an I/O error wait for the next change rather than spin
+        if (g < 0 || cleanSegment(s, g) != RC_OK) pthread_cond_wait(&s->wake, &s->lock);
+    }
+    pthread_mutex_unlock(&s->lock);
+    return NULL;
+}
+
+// Live records per segment from the table; fails on a location that is not
+// a record of an existing segment
+static RC countLive(LogStore *s) {
+    for (int g = 0; g < s->hdr.nextSegment; g++) s->segs[g].live = 0;
+    for (int p = 0; p < s->hdr.numPages; p++) {
+        LogLocation *loc = &s->map[p];
+        if (loc->segment < 0) continue;
+        if (loc->segment >= s->hdr.nextSegment || !s->segs[loc->segment].fp
+            || loc->slot < 0 || loc->slot >= s->segs[loc->segment].used)
+            return RC_READ_NON_EXISTING_PAGE;
+        s->segs[loc->segment].live++;
+    }
+    return RC_OK;
+}
+
+static RC loadTable(LogStore *s) {
+    if (fseek(s->fp, TABLE_OFFSET, SEEK_SET) != 0
+        || fread(s->map, sizeof(LogLocation), s->hdr.numPages, s->fp) != (size_t) s->hdr.numPages)
+        return RC_READ_NON_EXISTING_PAGE;
+    return countLive(s);
+}
+
+// Rebuild the table from the records after an unclean close: the record
+// with the highest sequence number of each page wins, and torn records fail
+// their checksum
+static RC recoverTable(LogStore *s) {
+    LogRecord rec;
+    long long *seqs = NULL;
+    int seqCap = 0;
+    char *data = malloc(PAGE_SIZE);
+    if (!data) return RC_READ_NON_EXISTING_PAGE;
+    for (int p = 0; p < s->mapCap; p++) s->map[p].segment = -1;
+    for (int g = 0; g < s->hdr.nextSegment; g++) {
+        FILE *fp = s->segs[g].fp;
+        if (!fp || fseek(fp, 0L, SEEK_SET) != 0) continue;
+        for (int slot = 0; slot < s->segs[g].used; slot++) {
+            if (fread(&rec, sizeof(LogRecord), 1, fp) != 1 || fread(data, PAGE_SIZE, 1, fp) != 1) break;
+            if (rec.magic != RECORD_MAGIC || rec.page < 0 || rec.check != recordCheck(&rec, data))
+                continue;
+            if (growMap(s, rec.page + 1) != RC_OK) {
+                free(seqs);
+                free(data);
+                return RC_READ_NON_EXISTING_PAGE;
+            }
+            if (seqCap < s->mapCap) {
+                long long *grown = realloc(seqs, sizeof(long long) * s->mapCap);
+                if (!grown) {
+                    free(seqs);
+                    free(data);
+                    return RC_READ_NON_EXISTING_PAGE;
+                }
+                seqs = grown;
+                seqCap = s->mapCap;
+            }
+            LogLocation *loc = &s->map[rec.page];
+            if (loc->segment < 0 || rec.seq > seqs[rec.page]) {
+                loc->segment = g;
+                loc->slot = slot;
+                seqs[rec.page] = rec.seq;
+            }
+            if (rec.seq >= s->hdr.nextSeq) s->hdr.nextSeq = rec.seq + 1;
+            if (rec.page >= s->hdr.numPages) s->hdr.numPages = rec.page + 1;
+        }
+    }
+    free(seqs);
+    free(data);
+    return countLive(s);
+}
+
+static void freeStore(LogStore *s) {
+    for (int g = 0; g < s->segCap; g++)
+        if (s->segs[g].fp) fclose(s->segs[g].fp);
+    free(s->segs);
+    free(s->map);
+    free(s->name);
+    free(s);
+}
+
+RC logCreate(const char *fileName, int segmentPages) {
+    LogHeader hdr;
+    LogLocation none = { -1, -1 };
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, LOG_MAGIC, sizeof(hdr.magic));
+    hdr.segmentPages = segmentPages > 0 ? segmentPages : LOG_SEGMENT_PAGES;
+    hdr.numPages = 1;
+    hdr.clean = 1;
+    hdr.nextSeq = 1;
+    char path[4096];
+    logRemoveSegments(fileName);
+    FILE *fp = fopen(fileName, "wb");
+    if (!fp) return RC_WRITE_FAILED;
+    int ok = fwrite(&hdr, sizeof(hdr), 1, fp) == 1 && fseek(fp, TABLE_OFFSET, SEEK_SET) == 0
+        && fwrite(&none, sizeof(none), 1, fp) == 1;
+    ok = fclose(fp) == 0 && ok;
+    // the marker goes last, so a failed create leaves no log behind
+    markerPath(fileName, path, sizeof(path));
+    fp = ok ? fopen(path, "wb") : NULL;
+    ok = fp != NULL && fwrite(LOG_MAGIC, sizeof(hdr.magic), 1, fp) == 1;
+    if (fp) ok = fclose(fp) == 0 && ok;
+    return ok ? RC_OK : RC_WRITE_FAILED;
+}
+
+int logIsStore(const char *fileName, FILE *fp) {
+    LogHeader hdr;
+    if (!hasMarker(fileName)) return 0;
+    int is = fseek(fp, 0L, SEEK_SET) == 0 && fread(&hdr, sizeof(hdr), 1, fp) == 1
+        && memcmp(hdr.magic, LOG_MAGIC, sizeof(hdr.magic)) == 0;
+    fseek(fp, 0L, SEEK_SET);
+    return is;
+}
+
+void logRemoveSegments(const char *fileName) {
+    LogHeader hdr;
+    char path[4096];
+    if (!hasMarker(fileName)) return;
+    FILE *fp = fopen(fileName, "rb");
+    if (fp) {
+        if (logIsStore(fileName, fp) && fread(&hdr, sizeof(hdr), 1, fp) == 1) {
+            for (int g = 0; g < hdr.nextSegment; g++) {
+                segmentPath(fileName, g, path, sizeof(path));
+                remove(path);
+            }
+        }
+        fclose(fp);
+    }
+    markerPath(fileName, path, sizeof(path));
+    remove(path);
+}
+
+RC logOpen(FILE *fp, const char *fileName, LogStore **store, int *numPages) {
+    LogStore *s = calloc(1, sizeof(LogStore));
+    if (!s) return RC_FILE_HANDLE_NOT_INIT;
+    s->fp = fp;
+    s->name = strdup(fileName);
+    s->head = -1;
+    s->flush = 1;
+    RC rc = RC_OK;
+    if (!s->name || fseek(fp, 0L, SEEK_SET) != 0 || fread(&s->hdr, sizeof(LogHeader), 1, fp) != 1
+        || memcmp(s->hdr.magic, LOG_MAGIC, sizeof(s->hdr.magic)) != 0 || s->hdr.segmentPages < 1
+        || s->hdr.numPages < 0 || s->hdr.nextSegment < 0)
+        rc = RC_READ_NON_EXISTING_PAGE;
+    if (rc == RC_OK) rc = growMap(s, s->hdr.numPages > 0 ? s->hdr.numPages : 1);
+    if (rc == RC_OK) rc = growSegments(s, s->hdr.nextSegment);
+    for (int g = 0; rc == RC_OK && g < s->hdr.nextSegment; g++) {
+        char path[4096];
+        segmentPath(fileName, g, path, sizeof(path));
+        FILE *seg = fopen(path, "rb+");
+        if (!seg) continue;  // cleaned, or never written
+        s->segs[g].fp = seg;
+        if (fseek(seg, 0L, SEEK_END) == 0) s->segs[g].used = (int) (ftell(seg) / RECORD_SIZE);
+    }
+    // the table copy is only trusted if it matches the segments
+    if (rc == RC_OK && (!s->hdr.clean || loadTable(s) != RC_OK)) {
+        s->hdr.clean = 0;
+        rc = recoverTable(s);
+    }
+    if (rc != RC_OK) {
+        freeStore(s);
+        return rc;
+    }
+    pthread_mutex_init(&s->lock, NULL);
+    pthread_cond_init(&s->wake, NULL);
+    pthread_cond_init(&s->cleaned, NULL);
+    if (pthread_create(&s->cleaner, NULL, cleanerMain, s) != 0) {
+        pthread_mutex_destroy(&s->lock);
+        pthread_cond_destroy(&s->wake);
+        pthread_cond_destroy(&s->cleaned);
+        freeStore(s);
+        return RC_FILE_HANDLE_NOT_INIT;
+    }
+    *store = s;
+    *numPages = s->hdr.numPages;
+    return RC_OK;
+}
+
+RC logClose(LogStore *s) {
+    RC rc = RC_OK;
+    pthread_mutex_lock(&s->lock);
+    s->stop = 1;
+    pthread_cond_broadcast(&s->wake);
+    pthread_mutex_unlock(&s->lock);
+    pthread_join(s->cleaner, NULL);
+    if (s->head >= 0 && fflush(s->segs[s->head].fp) != 0) rc = RC_WRITE_FAILED;
+    // the table first: the header only claims it once it is complete
+    if (rc == RC_OK && !s->hdr.clean) {
+        if (fseek(s->fp, TABLE_OFFSET, SEEK_SET) != 0
+            || fwrite(s->map, sizeof(LogLocation), s->hdr.numPages, s->fp) != (size_t) s->hdr.numPages
+            || fflush(s->fp) != 0)
+            rc = RC_WRITE_FAILED;
+        s->hdr.clean = 1;
+        if (rc == RC_OK) rc = writeHeader(s);
+    }
+    pthread_mutex_destroy(&s->lock);
+    pthread_cond_destroy(&s->wake);
+    pthread_cond_destroy(&s->cleaned);
+    freeStore(s);
+    return rc;
+}
+
+RC logRead(LogStore *s, int pageNum, char *memPage) {
+    RC rc = RC_OK;
+    lockForeground(s);
+    if (pageNum < 0 || pageNum >= s->hdr.numPages) rc = RC_READ_NON_EXISTING_PAGE;
+    else if (s->map[pageNum].segment < 0) memset(memPage, 0, PAGE_SIZE);
+    else rc = readRecord(s, s->map[pageNum].segment, s->map[pageNum].slot, NULL, memPage);
+    pthread_mutex_unlock(&s->lock);
+    return rc;
+}
+
+RC logWrite(LogStore *s, int firstPage, int count, char **memPages) {
+    RC rc = RC_OK;
+    lockForeground(s);
+    if (firstPage < 0 || firstPage + count > s->hdr.numPages) rc = RC_WRITE_FAILED;
+    if (rc == RC_OK) rc = appendRecords(s, firstPage, count, memPages);
+    if (rc == RC_OK) s->stats.appendedPages += count;
+    pthread_mutex_unlock(&s->lock);
+    return rc;
+}
+
+RC logSetPages(LogStore *s, int numPages) {
+    RC rc = RC_OK;
+    lockForeground(s);
+    if (numPages > s->hdr.numPages) {
+        rc = growMap(s, numPages);
+        if (rc == RC_OK) {
+            s->hdr.numPages = numPages;
+            s->hdr.clean = 0;
+            rc = writeHeader(s);
+        }
+    }
+    pthread_mutex_unlock(&s->lock);
+    return rc;
+}
+
+void logSetFlush(LogStore *s, int flush) {
+    pthread_mutex_lock(&s->lock);
+    s->flush = flush;
+    pthread_mutex_unlock(&s->lock);
+}
+
+RC logClean(LogStore *s) {
+    RC rc = RC_OK;
+    pthread_mutex_lock(&s->lock);
+    for (;;) {
+        int g = pickVictim(s), busy = 0;
+        if (g >= 0) {
+            rc = cleanSegment(s, g);
+            if (rc != RC_OK) break;
+            continue;
+        }
+        // wait for the cleaner thread's segment too
+        for (g = 0; g < s->hdr.nextSegment; g++) busy |= s->segs[g].cleaning;
+        if (!busy) break;
+        pthread_cond_wait(&s->cleaned, &s->lock);
+    }
+    pthread_mutex_unlock(&s->lock);
+    return rc;
+}
+
+void logStats(LogStore *s, SM_LogStats *stats) {
+    pthread_mutex_lock(&s->lock);
+    *stats = s->stats;
+    stats->segments = stats->livePages = stats->deadPages = 0;
+    for (int g = 0; g < s->hdr.nextSegment; g++) {
+        if (!s->segs[g].fp) continue;
+        stats->segments++;
+        stats->livePages += s->segs[g].live;
+        stats->deadPages += s->segs[g].used - s->segs[g].live;
+    }
+    pthread_mutex_unlock(&s->lock);
+}
@@ -0,0 +1,53 @@
+#ifndef LOG_STORE_H
+#define LOG_STORE_H
+
+#include <stdio.h>
+
+#include "dberror.h"
+#include "storage_mgr.h"
+
+// Log-structured backend of storage_mgr.c for files made by
+// createLogPageFile. A write never overwrites a page in place: it appends a
+// record (page number, sequence number, checksum, data) to the current
+// segment file <name>.seg<N>, and an indirection table maps each page to
+// its latest record. The page file itself holds a header and, after a clean
+// close, a copy of the table; after a crash the table is rebuilt from the
+// segments (highest sequence number wins). A cleaner thread copies the live
+// records of segments that are mostly dead to the head of the log and
+// deletes them. The file is told apart from a plain page file by the
+// marker file <name>.logstore, which only logCreate writes.
+
+// Pages per segment file when createLogPageFile is given 0
+#define LOG_SEGMENT_PAGES 1024
+// A full segment is cleaned once at most this percentage of it is live
+#define LOG_CLEAN_LIVE_PERCENT 50
+
+typedef struct LogStore LogStore;
+
+// Create the page file with one (zero) page and no segments, and its
+// marker <name>.logstore
+RC logCreate (const char *fileName, int segmentPages);
+// Whether fileName, open as fp, is a log-structured page file: it has the
+// marker and starts with the log header; leaves fp at the start
+int logIsStore (const char *fileName, FILE *fp);
+// Delete the segments and the marker of fileName, if it is a log-structured
+// page file
+void logRemoveSegments (const char *fileName);
+
+// Open the store whose page file is fp (kept open by the caller) and start
+// its cleaner; *numPages gets the number of pages
+RC logOpen (FILE *fp, const char *fileName, LogStore **store, int *numPages);
+// Stop the cleaner and write the table back; does not close fp
+RC logClose (LogStore *store);
+
+RC logRead (LogStore *store, int pageNum, char *memPage);
+// Append count pages, firstPage .. firstPage+count-1, as adjacent records
+RC logWrite (LogStore *store, int firstPage, int count, char **memPages);
+// Grow the file to numPages pages; new pages read as zeros
+RC logSetPages (LogStore *store, int numPages);
+void logSetFlush (LogStore *store, int flush);
+// Clean every segment that qualifies now, in the calling thread
+RC logClean (LogStore *store);
+void logStats (LogStore *store, SM_LogStats *stats);
+
+#endif
@@ -0,0 +1,152 @@
+// pthreads are POSIX, not plain C99
+#define _POSIX_C_SOURCE 200809L
+
+#include "mrc.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define HASH_RANGE (1UL << 24)
+
+// Fenwick tree over times [0, 2 * depth): one mark per tracked page at the
+// time of its last reference
+static void treeAdd(MrcEstimator *e, int t, int delta) {
+    for (t++; t <= 2 * e->depth; t += t & -t) e->tree[t - 1] += delta;
+}
+
+// Marks at times [0, t]
+static int treePrefix(const MrcEstimator *e, int t) {
+    int sum = 0;
+    for (t++; t > 0; t -= t & -t) sum += e->tree[t - 1];
+    return sum;
+}
+
+static int *entryLink(MrcEstimator *e, int page) {
+    int *link = &e->buckets[(unsigned) page * 2654435761u & e->mask];
+    while (*link >= 0 && e->entryPage[*link] != page) link = &e->entryNext[*link];
+    return link;
+}
+
+RC initMrcEstimator(MrcEstimator *e, int maxPages) {
+    if (maxPages < 1) maxPages = 1;
+    pthread_mutex_init(&e->lock, NULL);
+    e->rate = maxPages > MRC_MAX_TRACKED ? (double) MRC_MAX_TRACKED / maxPages : 1.0;
+    e->threshold = (unsigned long) (e->rate * HASH_RANGE);
+    e->depth = (int) (maxPages * e->rate) + 1;
+    e->refs = 0;
+    int buckets = 1;
+    while (buckets < 2 * e->depth) buckets <<= 1;
+    e->mask = buckets - 1;
+    e->hist = calloc(e->depth + 1, sizeof(unsigned long));
+    e->buckets = malloc(sizeof(int) * buckets);
+    e->entryPage = malloc(sizeof(int) * e->depth);
+    e->entryTime = malloc(sizeof(int) * e->depth);
+    e->entryNext = malloc(sizeof(int) * e->depth);
+    e->tree = calloc(2 * e->depth, sizeof(int));
+    e->timeEntry = malloc(sizeof(int) * 2 * e->depth);
+    if (!e->hist || !e->buckets || !e->entryPage || !e->entryTime || !e->entryNext
+        || !e->tree || !e->timeEntry) {
+        freeMrcEstimator(e);
+        return RC_BM_OUT_OF_MEMORY;
+    }
+    for (int i = 0; i < buckets; i++) e->buckets[i] = -1;
+    for (int i = 0; i < e->depth; i++) e->entryNext[i] = i + 1 < e->depth ? i + 1 : -1;
+    for (int t = 0; t < 2 * e->depth; t++) e->timeEntry[t] = -1;
+    e->freeEntry = 0;
+    e->live = 0;
+    e->clock = e->oldest = 0;
+    return RC_OK;
+}
+
+void freeMrcEstimator(MrcEstimator *e) {
+    free(e->hist);
+    free(e->buckets);
+    free(e->entryPage);
+    free(e->entryTime);
+    free(e->entryNext);
+    free(e->tree);
+    free(e->timeEntry);
+    pthread_mutex_destroy(&e->lock);
+}
+
+// Times ran out: renumber the tracked pages 0 .. live-1 in the same order
+// and rebuild the tree (once every depth references)
+static void compactTimes(MrcEstimator *e) {
+    int next = 0;
+    for (int t = 0; t < 2 * e->depth; t++) {
+        int k = e->timeEntry[t];
+        if (k < 0) continue;
+        e->timeEntry[t] = -1;
+        e->timeEntry[next] = k;
+        e->entryTime[k] = next++;
+    }
+    memset(e->tree, 0, sizeof(int) * 2 * e->depth);
+    for (int t = 0; t < next; t++) treeAdd(e, t, 1);
+    e->clock = next;
+    e->oldest = 0;
+}
+
+// Forget the least recently used tracked page; its next reference counts as
+// farther than depth
+static void dropOldest(MrcEstimator *e) {
+    while (e->timeEntry[e->oldest] < 0) e->oldest++;
+    int k = e->timeEntry[e->oldest];
+    e->timeEntry[e->oldest] = -1;
+    treeAdd(e, e->oldest, -1);
+    *entryLink(e, e->entryPage[k]) = e->entryNext[k];
+    e->entryNext[k] = e->freeEntry;
+    e->freeEntry = k;
+    e->live--;
+}
+
+void mrcAccess(MrcEstimator *e, int page) {
+    pthread_mutex_lock(&e->lock);
+    e->refs++;
+    int *link = entryLink(e, page);
+    int k = *link;
+    if (k >= 0) {
+        // distinct pages referenced since: the marks after its own
+        int t = e->entryTime[k];
+        e->hist[e->live - treePrefix(e, t)]++;
+        treeAdd(e, t, -1);
+        e->timeEntry[t] = -1;
+    } else {
+        e->hist[e->depth]++;
+        if (e->live == e->depth) {
+            dropOldest(e);
+            link = entryLink(e, page);
+        }
+        k = e->freeEntry;
+        e->freeEntry = e->entryNext[k];
+        e->entryPage[k] = page;
+        e->entryNext[k] = -1;
+        *link = k;
+        e->live++;
+    }
+    if (e->clock == 2 * e->depth) compactTimes(e);
+    e->entryTime[k] = e->clock;
+    e->timeEntry[e->clock] = k;
+    treeAdd(e, e->clock, 1);
+    e->clock++;
+    pthread_mutex_unlock(&e->lock);
+}
+
+double mrcHitRatio(MrcEstimator *e, int cachePages, unsigned long totalRefs) {
+    pthread_mutex_lock(&e->lock);
+    // a sampled distance d stands for d / R pages: a hit when d < cachePages * R
+    double limit = cachePages * e->rate;
+    unsigned long hits = 0;
+    for (int d = 0; d < e->depth && d < limit; d++) hits += e->hist[d];
+    double sampled = (double) e->refs;
+    pthread_mutex_unlock(&e->lock);
+    if (sampled == 0) return 0;
+    // SHARDS_adj: the sample holds more or fewer references than R * total;
+    // the difference is mostly hot pages, so it goes to the shortest distances
+    double expected = e->rate * totalRefs;
+    if (e->rate < 1.0 && expected > 0) {
+        double adjusted = hits + (expected - sampled);
+        if (adjusted < 0) adjusted = 0;
+        return adjusted > expected ? 1.0 : adjusted / expected;
+    }
+    return hits / sampled;
+}
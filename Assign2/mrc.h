@@ -0,0 +1,51 @@
+#ifndef MRC_H
+#define MRC_H
+
+#include <pthread.h>
+
+#include "dberror.h"
+
+// Online LRU miss-ratio curve, SHARDS style (Waldspurger et al., FAST '15):
+// pages whose hash falls under a threshold are sampled at rate R, and the
+// reuse distance of every sampled reference is measured among the sampled
+// pages only and scaled by 1 / R. R is 1 (exact) up to MRC_MAX_TRACKED
+// pages of cache and shrinks beyond, so memory and time stay bounded.
+#define MRC_MAX_TRACKED 8192
+
+typedef struct MrcEstimator {
+	pthread_mutex_t lock;
+	double rate;             // sampling rate R
+	unsigned long threshold; // page sampled when its 24-bit hash is below this
+	int depth;               // sampled pages tracked, the largest distance measured
+	unsigned long refs;      // sampled references
+	unsigned long *hist;     // hist[d]: references at distance d; hist[depth] = cold or farther
+	// sampled pages in a hash table, chained by next
+	int *buckets;
+	int mask;
+	int *entryPage, *entryTime, *entryNext;
+	int freeEntry;           // free list through entryNext
+	int live;
+	// Fenwick tree over access times; timeEntry[t] is the entry last used at t
+	int *tree;
+	int *timeEntry;
+	int clock, oldest;
+} MrcEstimator;
+
+// Track reuse distances up to maxPages pages of cache
+RC initMrcEstimator (MrcEstimator *const e, int maxPages);
+void freeMrcEstimator (MrcEstimator *const e);
+
+// Whether references to page feed the estimate; cheap, no lock
+static inline int mrcSampled (const MrcEstimator *e, int page)
+{
+	return ((unsigned long) ((unsigned) page * 2654435761u) >> 8) < e->threshold;
+}
+
+// Record a reference to a sampled page
+void mrcAccess (MrcEstimator *const e, int page);
+
+// Estimated LRU hit ratio with cachePages pages. totalRefs is the number of
+// references of all pages, sampled or not, for the SHARDS_adj correction.
+double mrcHitRatio (MrcEstimator *const e, int cachePages, unsigned long totalRefs);
+
+#endif
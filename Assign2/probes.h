@@ -0,0 +1,38 @@
+#ifndef PROBES_H
+#define PROBES_H
+
+// Static tracepoints on the buffer and storage hot paths. Where <sys/sdt.h>
+// (systemtap-sdt-dev) is installed they are USDT probes: one nop in the
+// code plus an ELF note, so bpftrace, perf probe or stap can attach to a
+// running binary without a rebuild. Without the header, or when built with
+// -DBM_NO_PROBES, they compile to nothing and their arguments are never
+// evaluated at run time.
+//
+//   buffer:pin_hit(page)                buffer:pin_miss(page)
+//   buffer:load_done(page, rc)          buffer:evict(page, dirty, background)
+//   buffer:flush_start(frames)          buffer:flush_done(pagesWritten)
+//   storage:read_start(page, count)     storage:read_done(page, count, bytes)
+//   storage:write_start(page, count)    storage:write_done(page, count, bytes)
+//
+// pin_miss .. load_done spans a miss; write_done fires after the fflush.
+// List them with: bpftrace -l 'usdt:./test_assign2_1:*'
+
+#if !defined(BM_NO_PROBES) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define BM_PROBES_ENABLED 1
+#endif
+#endif
+
+#ifdef BM_PROBES_ENABLED
+#define PROBE1(provider, name, a)       DTRACE_PROBE1(provider, name, a)
+#define PROBE2(provider, name, a, b)    DTRACE_PROBE2(provider, name, a, b)
+#define PROBE3(provider, name, a, b, c) DTRACE_PROBE3(provider, name, a, b, c)
+#else
+// the arguments still count as used, so -Wall stays quiet about them
+#define PROBE1(provider, name, a)       do { if (0) { (void) (a); } } while (0)
+#define PROBE2(provider, name, a, b)    do { if (0) { (void) (a); (void) (b); } } while (0)
+#define PROBE3(provider, name, a, b, c) do { if (0) { (void) (a); (void) (b); (void) (c); } } while (0)
+#endif
+
+#endif
@@ -0,0 +1,541 @@
+// pthreads, strdup, pread/pwrite and fsync are POSIX, not plain C99
+#define _POSIX_C_SOURCE 200809L
+
+#include "shadow_store.h"
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define SHADOW_MAGIC "SHADOWPF"
+// page entries per map block, and map blocks per directory block
+#define ENTRIES (PAGE_SIZE / (int) sizeof(int))
+// block 0 holds two header slots a sector apart; a commit writes the one
+// the previous commit did not, so a torn header write leaves that one intact
+#define SLOT_SIZE 512
+
+// Root of a commit
+typedef struct ShadowHeader {
+    char magic[8];
+    long long version;  // commit number, kept in slot version % 2
+    int numPages;
+    int dirBlock;       // directory block, 0 before the first page is written
+    int fileBlocks;     // blocks in use or free, the header block included
+    int unused;
+    unsigned long long check;
+} ShadowHeader;
+
+// A committed state of the file, kept while a view reads it or it is the latest
+typedef struct Snapshot {
+    long long version;
+    int numPages;
+    int *map;                // block of each page, 0 = never written (reads as zeros)
+    int dirBlock;
+    int mapBlocks[ENTRIES];  // block of each map block, 0 = none yet
+    int refs;                // views reading it
+    struct Snapshot *next;   // next newer one
+} Snapshot;
+
+// Blocks a commit dropped; free once no view reads an older snapshot
+typedef struct Garbage {
+    long long version;
+    int *blocks;
+    int count;
+    struct Garbage *next;
+} Garbage;
+
+typedef struct ShadowFile {
+    pthread_mutex_t lock;    // everything below but name, fd and users
+    char *name;
+    int fd;
+    int users;               // views open, under registryLock
+    Snapshot *oldest, *latest;
+    Garbage *garbage, *garbageTail;
+    int *freeBlocks;         // stack of reusable blocks
+    int freeCount, freeCap;
+    int fileBlocks;          // blocks handed out so far, the end of the file
+    struct ShadowFile *next; // in the registry
+} ShadowFile;
+
+struct ShadowView {
+    ShadowFile *file;
+    Snapshot *base;          // the snapshot read, and written over
+    int numPages;
+    int *map;                // own copy of the page map once the view changes something
+    int mapCap;
+    unsigned char changed[ENTRIES]; // map blocks with entries the view wrote
+};
+
+// Shadow-paged files open in this process, by name
+static pthread_mutex_t registryLock = PTHREAD_MUTEX_INITIALIZER;
+static ShadowFile *registry = NULL;
+
+// FNV-1a over the header up to the checksum, so a torn slot is not taken
+// for a commit
+static unsigned long long headerCheck(const ShadowHeader *hdr) {
+    const unsigned char *b = (const unsigned char *) hdr;
+    unsigned long long sum = 14695981039346656037ULL;
+    for (size_t i = 0; i < offsetof(ShadowHeader, check); i++) sum = (sum ^ b[i]) * 1099511628211ULL;
+    return sum;
+}
+
+static RC readBlockAt(int fd, int block, void *buf) {
+    return pread(fd, buf, PAGE_SIZE, (off_t) block * PAGE_SIZE) == PAGE_SIZE
+        ? RC_OK : RC_READ_NON_EXISTING_PAGE;
+}
+
+static RC writeBlockAt(int fd, int block, const void *buf) {
+    return pwrite(fd, buf, PAGE_SIZE, (off_t) block * PAGE_SIZE) == PAGE_SIZE ? RC_OK : RC_WRITE_FAILED;
+}
+
+static RC writeHeader(int fd, long long version, int numPages, int dirBlock, int fileBlocks) {
+    ShadowHeader hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, SHADOW_MAGIC, sizeof(hdr.magic));
+    hdr.version = version;
+    hdr.numPages = numPages;
+    hdr.dirBlock = dirBlock;
+    hdr.fileBlocks = fileBlocks;
+    hdr.check = headerCheck(&hdr);
+    return pwrite(fd, &hdr, sizeof(hdr), (off_t) (version % 2) * SLOT_SIZE) == (ssize_t) sizeof(hdr)
+        ? RC_OK : RC_WRITE_FAILED;
+}
+
+// The newer of the two slots that hold a whole header
+static RC readHeader(int fd, ShadowHeader *hdr) {
+    int found = 0;
+    for (int i = 0; i < 2; i++) {
+        ShadowHeader slot;
+        if (pread(fd, &slot, sizeof(slot), (off_t) i * SLOT_SIZE) != (ssize_t) sizeof(slot)
+            || memcmp(slot.magic, SHADOW_MAGIC, sizeof(slot.magic)) != 0 || slot.check != headerCheck(&slot))
+            continue;
+        if (!found || slot.version > hdr->version) *hdr = slot;
+        found = 1;
+    }
+    return found ? RC_OK : RC_READ_NON_EXISTING_PAGE;
+}
+
+static int allocBlock(ShadowFile *f) {
+    return f->freeCount > 0 ? f->freeBlocks[--f->freeCount] : f->fileBlocks++;
+}
+
+// A block that cannot be queued is only lost until the file is opened again
+static void freeBlock(ShadowFile *f, int block) {
+    if (f->freeCount == f->freeCap) {
+        int cap = f->freeCap ? f->freeCap * 2 : 256;
+        int *blocks = realloc(f->freeBlocks, sizeof(int) * cap);
+        if (!blocks) return;
+        f->freeBlocks = blocks;
+        f->freeCap = cap;
+    }
+    f->freeBlocks[f->freeCount++] = block;
+}
+
+// Drop the view's hold on s, then every snapshot nobody reads but the
+// latest, and free the blocks of commits no remaining snapshot predates
+static void releaseSnapshot(ShadowFile *f, Snapshot *s) {
+    s->refs--;
+    Snapshot **link = &f->oldest;
+    while (*link != f->latest) {
+        Snapshot *cur = *link;
+        if (cur->refs > 0) {
+            link = &cur->next;
+            continue;
+        }
+        *link = cur->next;
+        free(cur->map);
+        free(cur);
+    }
+    while (f->garbage && f->garbage->version <= f->oldest->version) {
+        Garbage *g = f->garbage;
+        for (int i = 0; i < g->count; i++) freeBlock(f, g->blocks[i]);
+        f->garbage = g->next;
+        if (!f->garbage) f->garbageTail = NULL;
+        free(g->blocks);
+        free(g);
+    }
+}
+
+// Block of page p in the view's snapshot
+static int baseBlock(const ShadowView *v, int p) {
+    return p < v->base->numPages ? v->base->map[p] : 0;
+}
+
+// Give the view its own copy of the page map, with room for numPages
+static RC growPrivateMap(ShadowView *v, int numPages) {
+    if (!v->map) {
+        int cap = v->numPages > 64 ? v->numPages : 64;
+        v->map = malloc(sizeof(int) * cap);
+        if (!v->map) return RC_WRITE_FAILED;
+        memcpy(v->map, v->base->map, sizeof(int) * v->base->numPages);
+        memset(v->map + v->base->numPages, 0, sizeof(int) * (cap - v->base->numPages));
+        v->mapCap = cap;
+    }
+    if (numPages <= v->mapCap) return RC_OK;
+    int cap = v->mapCap;
+    while (cap < numPages) cap *= 2;
+    int *map = realloc(v->map, sizeof(int) * cap);
+    if (!map) return RC_WRITE_FAILED;
+    memset(map + v->mapCap, 0, sizeof(int) * (cap - v->mapCap));
+    v->map = map;
+    v->mapCap = cap;
+    return RC_OK;
+}
+
+// Free the blocks the view wrote since its last commit, which nothing else
+// reads, and go back to its snapshot
+static void dropWrites(ShadowView *v) {
+    if (!v->map) return;
+    for (int i = 0; i < ENTRIES; i++) {
+        if (!v->changed[i]) continue;
+        for (int p = i * ENTRIES; p < (i + 1) * ENTRIES && p < v->numPages; p++)
+            if (v->map[p] && v->map[p] != baseBlock(v, p)) freeBlock(v->file, v->map[p]);
+    }
+    free(v->map);
+    v->map = NULL;
+    v->mapCap = 0;
+    memset(v->changed, 0, sizeof(v->changed));
+    v->numPages = v->base->numPages;
+}
+
+// Read the latest commit instead of an older one (no writes pending)
+static void moveToLatest(ShadowView *v) {
+    ShadowFile *f = v->file;
+    Snapshot *old = v->base;
+    if (old == f->latest) return;
+    v->base = f->latest;
+    v->base->refs++;
+    v->numPages = v->base->numPages;
+    releaseSnapshot(f, old);
+}
+
+// Write the changed map blocks and a new directory to free blocks, sync,
+// then switch the root with one synced header write
+static RC commitWrites(ShadowView *v) {
+    ShadowFile *f = v->file;
+    Snapshot *base = v->base;
+    if (base != f->latest) return RC_COMMIT_CONFLICT;
+    int mapCount = (v->numPages + ENTRIES - 1) / ENTRIES, changed = 0, nFresh = 0;
+    for (int i = 0; i < mapCount; i++) changed += v->changed[i];
+    Snapshot *s = calloc(1, sizeof(Snapshot));
+    Garbage *g = calloc(1, sizeof(Garbage));
+    int *entries = malloc(PAGE_SIZE);
+    int *fresh = malloc(sizeof(int) * (changed + 1));
+    if (g) g->blocks = malloc(sizeof(int) * ((size_t) changed * (ENTRIES + 1) + 1));
+    RC rc = s && g && g->blocks && entries && fresh ? RC_OK : RC_WRITE_FAILED;
+    if (rc == RC_OK) memcpy(s->mapBlocks, base->mapBlocks, sizeof(s->mapBlocks));
+    for (int i = 0; rc == RC_OK && i < mapCount; i++) {
+        if (!v->changed[i]) continue;
+        for (int k = 0; k < ENTRIES; k++) {
+            int p = i * ENTRIES + k, old = baseBlock(v, p);
+            entries[k] = p < v->numPages ? v->map[p] : 0;
+            if (old && old != entries[k]) g->blocks[g->count++] = old;
+        }
+        int b = fresh[nFresh++] = allocBlock(f);
+        rc = writeBlockAt(f->fd, b, entries);
+        if (base->mapBlocks[i]) g->blocks[g->count++] = base->mapBlocks[i];
+        s->mapBlocks[i] = b;
+    }
+    if (rc == RC_OK) {
+        s->dirBlock = fresh[nFresh++] = allocBlock(f);
+        rc = writeBlockAt(f->fd, s->dirBlock, s->mapBlocks);
+        if (base->dirBlock) g->blocks[g->count++] = base->dirBlock;
+    }
+    // everything the header points to is on disk before the header
+    if (rc == RC_OK && fsync(f->fd) != 0) rc = RC_WRITE_FAILED;
+    int headerWritten = 0;
+    if (rc == RC_OK) {
+        headerWritten = 1;
+        rc = writeHeader(f->fd, base->version + 1, v->numPages, s->dirBlock, f->fileBlocks);
+        if (rc == RC_OK && fsync(f->fd) != 0) rc = RC_WRITE_FAILED;
+    }
+    free(entries);
+    if (rc != RC_OK) {
+        // once the header may have reached the disk its blocks stay unused
+        // until the next open, which decides whether the commit happened
+        for (int i = 0; !headerWritten && i < nFresh; i++) freeBlock(f, fresh[i]);
+        free(fresh);
+        if (g) free(g->blocks);
+        free(g);
+        free(s);
+        return rc;
+    }
+    free(fresh);
+    s->version = base->version + 1;
+    s->numPages = v->numPages;
+    s->map = v->map;
+    s->refs = 1;
+    base->next = s;
+    f->latest = s;
+    g->version = s->version;
+    if (f->garbageTail) f->garbageTail->next = g;
+    else f->garbage = g;
+    f->garbageTail = g;
+    v->map = NULL;
+    v->mapCap = 0;
+    memset(v->changed, 0, sizeof(v->changed));
+    v->base = s;
+    releaseSnapshot(f, base);
+    return RC_OK;
+}
+
+// Mark a block of the commit being loaded as used; one outside the file or
+// used twice means a damaged map
+static RC claimBlock(const ShadowFile *f, unsigned char *used, int block) {
+    if (block < 1 || block >= f->fileBlocks || used[block]) return RC_READ_NON_EXISTING_PAGE;
+    used[block] = 1;
+    return RC_OK;
+}
+
+// Read the page map of the commit hdr points to
+static RC loadSnapshot(ShadowFile *f, const ShadowHeader *hdr, unsigned char *used) {
+    Snapshot *s = calloc(1, sizeof(Snapshot));
+    int *entries = malloc(PAGE_SIZE);
+    if (s) s->map = calloc(hdr->numPages > 0 ? hdr->numPages : 1, sizeof(int));
+    RC rc = s && s->map && entries ? RC_OK : RC_FILE_HANDLE_NOT_INIT;
+    if (rc == RC_OK) {
+        s->version = hdr->version;
+        s->numPages = hdr->numPages;
+        s->dirBlock = hdr->dirBlock;
+    }
+    if (rc == RC_OK && s->dirBlock) {
+        rc = claimBlock(f, used, s->dirBlock);
+        if (rc == RC_OK) rc = readBlockAt(f->fd, s->dirBlock, s->mapBlocks);
+    }
+    for (int i = 0; rc == RC_OK && s->dirBlock && i * ENTRIES < s->numPages; i++) {
+        if (!s->mapBlocks[i]) continue;
+        rc = claimBlock(f, used, s->mapBlocks[i]);
+        if (rc == RC_OK) rc = readBlockAt(f->fd, s->mapBlocks[i], entries);
+        for (int k = 0, p = i * ENTRIES; rc == RC_OK && k < ENTRIES && p < s->numPages; k++, p++) {
+            if (entries[k]) rc = claimBlock(f, used, entries[k]);
+            s->map[p] = entries[k];
+        }
+    }
+    free(entries);
+    if (rc != RC_OK) {
+        if (s) free(s->map);
+        free(s);
+        return rc;
+    }
+    f->oldest = f->latest = s;
+    return RC_OK;
+}
+
+static void freeFile(ShadowFile *f) {
+    while (f->oldest) {
+        Snapshot *s = f->oldest;
+        f->oldest = s->next;
+        free(s->map);
+        free(s);
+    }
+    while (f->garbage) {
+        Garbage *g = f->garbage;
+        f->garbage = g->next;
+        free(g->blocks);
+        free(g);
+    }
+    if (f->fd >= 0) close(f->fd);
+    free(f->freeBlocks);
+    free(f->name);
+    free(f);
+}
+
+static RC openFile(const char *fileName, ShadowFile **file) {
+    ShadowFile *f = calloc(1, sizeof(ShadowFile));
+    if (!f) return RC_FILE_HANDLE_NOT_INIT;
+    ShadowHeader hdr;
+    unsigned char *used = NULL;
+    f->name = strdup(fileName);
+    f->fd = open(fileName, O_RDWR);
+    RC rc = f->name && f->fd >= 0 ? readHeader(f->fd, &hdr) : RC_FILE_NOT_FOUND;
+    if (rc == RC_OK && (hdr.numPages < 0 || hdr.numPages > SHADOW_MAX_PAGES || hdr.fileBlocks < 1))
+        rc = RC_READ_NON_EXISTING_PAGE;
+    if (rc == RC_OK) {
+        f->fileBlocks = hdr.fileBlocks;
+        used = calloc(f->fileBlocks, 1);
+        rc = used ? loadSnapshot(f, &hdr, used) : RC_FILE_HANDLE_NOT_INIT;
+    }
+    // every block the commit does not use is free, those of writes that
+    // never committed included; the lowest are handed out first
+    for (int b = f->fileBlocks - 1; rc == RC_OK && b >= 1; b--)
+        if (!used[b]) freeBlock(f, b);
+    free(used);
+    if (rc != RC_OK) {
+        freeFile(f);
+        return rc;
+    }
+    pthread_mutex_init(&f->lock, NULL);
+    *file = f;
+    return RC_OK;
+}
+
+// <name>.shadowstore holds SHADOW_MAGIC; only shadowCreate makes it, so a
+// plain page file that happens to hold the magic is never taken for one
+static void markerPath(const char *fileName, char *path, size_t size) {
+    snprintf(path, size, "%s.shadowstore", fileName);
+}
+
+static int hasMarker(const char *fileName) {
+    char path[4096], magic[8];
+    markerPath(fileName, path, sizeof(path));
+    FILE *fp = fopen(path, "rb");
+    if (!fp) return 0;
+    int is = fread(magic, sizeof(magic), 1, fp) == 1 && memcmp(magic, SHADOW_MAGIC, sizeof(magic)) == 0;
+    fclose(fp);
+    return is;
+}
+
+RC shadowCreate(const char *fileName) {
+    char path[4096];
+    char *zero = calloc(1, PAGE_SIZE);
+    int fd = open(fileName, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    RC rc = zero && fd >= 0 ? writeBlockAt(fd, 0, zero) : RC_WRITE_FAILED;
+    if (rc == RC_OK) rc = writeHeader(fd, 1, 1, 0, 1);
+    if (fd >= 0 && close(fd) != 0) rc = RC_WRITE_FAILED;
+    free(zero);
+    // the marker goes last, so a failed create leaves a plain file
+    markerPath(fileName, path, sizeof(path));
+    FILE *fp = rc == RC_OK ? fopen(path, "wb") : NULL;
+    if (rc == RC_OK && (!fp || fwrite(SHADOW_MAGIC, 8, 1, fp) != 1)) rc = RC_WRITE_FAILED;
+    if (fp && fclose(fp) != 0) rc = RC_WRITE_FAILED;
+    return rc;
+}
+
+void shadowRemoveMarker(const char *fileName) {
+    char path[4096];
+    if (!hasMarker(fileName)) return;
+    markerPath(fileName, path, sizeof(path));
+    remove(path);
+}
+
+int shadowIsStore(const char *fileName, FILE *fp) {
+    char magic[8];
+    int is = 0;
+    if (!hasMarker(fileName)) return 0;
+    for (int i = 0; i < 2 && !is; i++)
+        is = fseek(fp, (long) i * SLOT_SIZE, SEEK_SET) == 0 && fread(magic, sizeof(magic), 1, fp) == 1
+            && memcmp(magic, SHADOW_MAGIC, sizeof(magic)) == 0;
+    fseek(fp, 0L, SEEK_SET);
+    return is;
+}
+
+RC shadowOpen(const char *fileName, ShadowView **view, int *numPages) {
+    ShadowView *v = calloc(1, sizeof(ShadowView));
+    if (!v) return RC_FILE_HANDLE_NOT_INIT;
+    RC rc = RC_OK;
+    pthread_mutex_lock(&registryLock);
+    ShadowFile *f = registry;
+    while (f && strcmp(f->name, fileName) != 0) f = f->next;
+    if (!f && (rc = openFile(fileName, &f)) == RC_OK) {
+        f->next = registry;
+        registry = f;
+    }
+    if (rc == RC_OK) f->users++;
+    pthread_mutex_unlock(&registryLock);
+    if (rc != RC_OK) {
+        free(v);
+        return rc;
+    }
+    pthread_mutex_lock(&f->lock);
+    v->file = f;
+    v->base = f->latest;
+    v->base->refs++;
+    v->numPages = v->base->numPages;
+    pthread_mutex_unlock(&f->lock);
+    *view = v;
+    *numPages = v->numPages;
+    return RC_OK;
+}
+
+void shadowClose(ShadowView *v) {
+    ShadowFile *f = v->file;
+    pthread_mutex_lock(&f->lock);
+    dropWrites(v);
+    releaseSnapshot(f, v->base);
+    pthread_mutex_unlock(&f->lock);
+    free(v);
+    pthread_mutex_lock(&registryLock);
+    if (--f->users == 0) {
+        ShadowFile **link = &registry;
+        while (*link != f) link = &(*link)->next;
+        *link = f->next;
+        pthread_mutex_destroy(&f->lock);
+        freeFile(f);
+    }
+    pthread_mutex_unlock(&registryLock);
+}
+
+RC shadowRead(ShadowView *v, int pageNum, char *memPage) {
+    if (pageNum < 0 || pageNum >= v->numPages) return RC_READ_NON_EXISTING_PAGE;
+    // the view's own map, or its snapshot's, which never changes: no lock
+    int block = v->map ? v->map[pageNum] : v->base->map[pageNum];
+    if (block == 0) {
+        memset(memPage, 0, PAGE_SIZE);
+        return RC_OK;
+    }
+    return readBlockAt(v->file->fd, block, memPage);
+}
+
+RC shadowWrite(ShadowView *v, int firstPage, int count, char **memPages) {
+    ShadowFile *f = v->file;
+    if (firstPage < 0 || count < 1 || firstPage + count > v->numPages) return RC_WRITE_FAILED;
+    int *blocks = malloc(sizeof(int) * count);
+    if (!blocks || growPrivateMap(v, v->numPages) != RC_OK) {
+        free(blocks);
+        return RC_WRITE_FAILED;
+    }
+    pthread_mutex_lock(&f->lock);
+    for (int i = 0; i < count; i++) blocks[i] = allocBlock(f);
+    pthread_mutex_unlock(&f->lock);
+    // the blocks are this view's alone until it commits: written unlocked
+    RC rc = RC_OK;
+    for (int i = 0; rc == RC_OK && i < count; i++) rc = writeBlockAt(f->fd, blocks[i], memPages[i]);
+    pthread_mutex_lock(&f->lock);
+    for (int i = 0; i < count; i++) {
+        int p = firstPage + i;
+        if (rc != RC_OK) {
+            freeBlock(f, blocks[i]);
+            continue;
+        }
+        // a block this view wrote since its last commit is nobody else's
+        if (v->map[p] && v->map[p] != baseBlock(v, p)) freeBlock(f, v->map[p]);
+        v->map[p] = blocks[i];
+        v->changed[p / ENTRIES] = 1;
+    }
+    pthread_mutex_unlock(&f->lock);
+    free(blocks);
+    return rc;
+}
+
+RC shadowSetPages(ShadowView *v, int numPages) {
+    if (numPages <= v->numPages) return RC_OK;
+    if (numPages > SHADOW_MAX_PAGES || growPrivateMap(v, numPages) != RC_OK) return RC_WRITE_FAILED;
+    v->numPages = numPages;
+    return RC_OK;
+}
+
+RC shadowCommit(ShadowView *v, int *numPages) {
+    ShadowFile *f = v->file;
+    RC rc = RC_OK;
+    pthread_mutex_lock(&f->lock);
+    if (v->map) rc = commitWrites(v);
+    // a transaction that lost the race is gone; a failed write can be retried
+    if (rc == RC_COMMIT_CONFLICT) dropWrites(v);
+    if (!v->map) moveToLatest(v);
+    *numPages = v->numPages;
+    pthread_mutex_unlock(&f->lock);
+    return rc;
+}
+
+RC shadowAbort(ShadowView *v, int *numPages) {
+    ShadowFile *f = v->file;
+    pthread_mutex_lock(&f->lock);
+    dropWrites(v);
+    moveToLatest(v);
+    *numPages = v->numPages;
+    pthread_mutex_unlock(&f->lock);
+    return RC_OK;
+}
@@ -0,0 +1,54 @@
+#ifndef SHADOW_STORE_H
+#define SHADOW_STORE_H
+
+#include <stdio.h>
+
+#include "dberror.h"
+
+// Shadow-paged backend of storage_mgr.c for files made by
+// createShadowPageFile. A write never overwrites a block that a commit or
+// another handle can still read: the page goes to a free block of the same
+// file and only the writing handle's private page map changes. A commit
+// writes the changed blocks of the page map to free blocks too, syncs, and
+// then switches the root with one synced header write, so after a crash
+// the file holds exactly the pages of the last commit. Each handle reads
+// the snapshot it last committed (or refreshed) to, so it never sees half
+// of another handle's commit. A block dropped by a commit is reused once no
+// handle reads a snapshot older than that commit. The handles of one
+// process share the file by name; other processes must not open it while
+// it is written. The file is told apart from a plain page file by the
+// marker file <name>.shadowstore, which only shadowCreate writes.
+
+// Largest file: one directory block of map blocks of page entries
+#define SHADOW_MAX_PAGES ((PAGE_SIZE / 4) * (PAGE_SIZE / 4))
+
+typedef struct ShadowView ShadowView;
+
+// Create the file with one (zero) page, committed, and its marker
+// <name>.shadowstore
+RC shadowCreate (const char *fileName);
+// Whether fileName, open as fp, is a shadow-paged page file: it has the
+// marker and a shadow header; leaves fp at the start
+int shadowIsStore (const char *fileName, FILE *fp);
+// Delete the marker of fileName, if it is a shadow-paged page file
+void shadowRemoveMarker (const char *fileName);
+
+// Open a view of the last commit of fileName; *numPages gets its page count
+RC shadowOpen (const char *fileName, ShadowView **view, int *numPages);
+// Drop the view's uncommitted writes and its snapshot
+void shadowClose (ShadowView *view);
+
+RC shadowRead (ShadowView *view, int pageNum, char *memPage);
+// Write count pages, firstPage .. firstPage+count-1, visible to this view only
+RC shadowWrite (ShadowView *view, int firstPage, int count, char **memPages);
+// Grow the view to numPages pages; new pages read as zeros
+RC shadowSetPages (ShadowView *view, int numPages);
+// Make the view's writes since its last commit durable and visible as one
+// step, then move it to the newest commit; *numPages gets its page count.
+// RC_COMMIT_CONFLICT, with the writes dropped, if another view committed
+// since this one's snapshot was taken.
+RC shadowCommit (ShadowView *view, int *numPages);
+// Drop the view's writes since its last commit and move it to the newest
+RC shadowAbort (ShadowView *view, int *numPages);
+
+#endif
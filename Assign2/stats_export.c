@@ -0,0 +1,268 @@
+// sockets, poll, pipe and open_memstream are POSIX, not plain C99
+#define _POSIX_C_SOURCE 200809L
+
+#include "stats_export.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#define SOCKET_PREFIX "unix:"
+
+// Exporter thread state
+typedef struct ExporterInfo {
+    pthread_t thread;
+    int wakeFd[2];   // written by stopStatsExporter to end the thread
+    int listenFd;    // Unix socket, -1 for a file target
+    char *path;      // socket or file path
+} ExporterInfo;
+
+// Write str as the inside of a double-quoted string: quotes, backslashes
+// and newlines escaped, which is what both JSON and Prometheus label values
+// need; JSON also gets the other control characters as \u escapes
+static void writeQuoted(FILE *out, const char *str, int json) {
+    for (const unsigned char *c = (const unsigned char *) str; *c; c++) {
+        if (*c == '"' || *c == '\\') fprintf(out, "\\%c", *c);
+        else if (*c == '\n') fputs("\\n", out);
+        else if (json && *c < 0x20) fprintf(out, "\\u%04x", *c);
+        else fputc(*c, out);
+    }
+}
+
+// One Prometheus sample with its HELP and TYPE lines
+static void promMetric(FILE *out, const char *name, const char *type,
+                       const char *help, double value) {
+    fprintf(out, "# HELP %s %s\n# TYPE %s %s\n%s %.10g\n", name, help, name, type, name, value);
+}
+
+// A latency histogram; Prometheus buckets are cumulative and in seconds
+static void promHistogram(FILE *out, const char *name, const char *help,
+                          const unsigned long *hist, long long nanos) {
+    unsigned long total = 0;
+    fprintf(out, "# HELP %s %s\n# TYPE %s histogram\n", name, help, name);
+    for (int b = 0; b < BM_LATENCY_BUCKETS - 1; b++) {
+        total += hist[b];
+        fprintf(out, "%s_bucket{le=\"%g\"} %lu\n", name, (double) (1L << b) / 1e6, total);
+    }
+    total += hist[BM_LATENCY_BUCKETS - 1];
+    fprintf(out, "%s_bucket{le=\"+Inf\"} %lu\n%s_sum %.9f\n%s_count %lu\n",
+            name, total, name, nanos / 1e9, name, total);
+}
+
+// A latency histogram as JSON: bucket bounds in microseconds, the last
+// bucket unbounded, and per-bucket (not cumulative) counts
+static void jsonHistogram(FILE *out, const char *name, const unsigned long *hist, long long nanos) {
+    fprintf(out, "  \"%s\": {\"boundsUs\": [", name);
+    for (int b = 0; b < BM_LATENCY_BUCKETS - 1; b++)
+        fprintf(out, "%s%ld", b ? ", " : "", 1L << b);
+    fprintf(out, "], \"counts\": [");
+    for (int b = 0; b < BM_LATENCY_BUCKETS; b++)
+        fprintf(out, "%s%lu", b ? ", " : "", hist[b]);
+    fprintf(out, "], \"sumSeconds\": %.9f}", nanos / 1e9);
+}
+
+RC writePoolStats(BM_BufferPool *bm, BM_ExportFormat format, FILE *out) {
+    BM_PoolStats s;
+    RC rc = getPoolStats(bm, &s);
+    if (rc != RC_OK) return rc;
+    double hitRatio = s.pins > (unsigned long) s.numReadIO
+        ? 1.0 - (double) s.numReadIO / s.pins : 0;
+    BM_HitRatioCurve curve;
+    bool haveCurve = getHitRatioCurve(bm, &curve) == RC_OK;
+
+    if (format == BM_EXPORT_JSON) {
+        fprintf(out, "{\n  \"pageFile\": \"");
+        writeQuoted(out, bm->pageFile, 1);
+        fprintf(out, "\",\n");
+        fprintf(out, "  \"readIO\": %d,\n  \"writeIO\": %d,\n  \"pins\": %lu,\n"
+                "  \"hitRatio\": %.6f,\n", s.numReadIO, s.numWriteIO, s.pins, hitRatio);
+        fprintf(out, "  \"poolSize\": %d,\n  \"freeFrames\": %d,\n  \"dirtyFrames\": %d,\n"
+                "  \"pinnedFrames\": %d,\n  \"keepFrames\": %d,\n  \"filePages\": %d,\n",
+                s.poolSize, s.freeFrames, s.dirtyFrames, s.pinnedFrames, s.keepFrames, s.filePages);
+        fprintf(out, "  \"fgEvictions\": %lu,\n  \"bgEvictions\": %lu,\n"
+                "  \"fgEvictSeconds\": %.9f,\n  \"bgEvictSeconds\": %.9f,\n",
+                s.fgEvictions, s.bgEvictions, s.fgEvictNanos / 1e9, s.bgEvictNanos / 1e9);
+        fprintf(out, "  \"coalescedWrites\": %lu,\n  \"failedWrites\": %lu,\n"
+                "  \"remoteAccesses\": %lu,\n  \"remoteAllocations\": %lu,\n",
+                s.coalescedWrites, s.failedWrites, s.remoteAccesses, s.remoteAllocations);
+        jsonHistogram(out, "readLatency", s.readLatency, s.readNanos);
+        fprintf(out, ",\n");
+        jsonHistogram(out, "writeLatency", s.writeLatency, s.writeNanos);
+        if (haveCurve) {
+            fprintf(out, ",\n  \"hitRatioCurve\": [");
+            for (int i = 0; i < BM_CURVE_POINTS; i++)
+                fprintf(out, "%s{\"pages\": %d, \"hitRatio\": %.6f}", i ? ", " : "",
+                        curve.pages[i], curve.hitRatio[i]);
+            fprintf(out, "]");
+        }
+        fprintf(out, "\n}\n");
+    } else {
+        fprintf(out, "# HELP bm_pool_info The page file the pool caches.\n"
+                "# TYPE bm_pool_info gauge\nbm_pool_info{page_file=\"");
+        writeQuoted(out, bm->pageFile, 0);
+        fprintf(out, "\"} 1\n");
+        promMetric(out, "bm_read_io_total", "counter", "Pages read from the page file.", s.numReadIO);
+        promMetric(out, "bm_write_io_total", "counter", "Pages written to the page file.", s.numWriteIO);
+        promMetric(out, "bm_pins_total", "counter", "Pin calls, hits and misses.", s.pins);
+        promMetric(out, "bm_hit_ratio", "gauge", "1 - read I/O per pin since the pool opened.", hitRatio);
+        promMetric(out, "bm_pool_frames", "gauge", "Frames the pool may use.", s.poolSize);
+        promMetric(out, "bm_free_frames", "gauge", "Frames not holding a page.", s.freeFrames);
+        promMetric(out, "bm_dirty_frames", "gauge", "Frames holding a modified page.", s.dirtyFrames);
+        promMetric(out, "bm_pinned_frames", "gauge", "Frames with a fix count above zero.", s.pinnedFrames);
+        promMetric(out, "bm_keep_frames", "gauge", "Frames in the keep-resident set.", s.keepFrames);
+        promMetric(out, "bm_file_pages", "gauge", "Pages in the page file.", s.filePages);
+        fprintf(out, "# HELP bm_evictions_total Victims replaced, by the missing thread or the evictor.\n"
+                "# TYPE bm_evictions_total counter\n"
+                "bm_evictions_total{kind=\"foreground\"} %lu\n"
+                "bm_evictions_total{kind=\"background\"} %lu\n", s.fgEvictions, s.bgEvictions);
+        fprintf(out, "# HELP bm_evict_seconds_total Time spent evicting.\n"
+                "# TYPE bm_evict_seconds_total counter\n"
+                "bm_evict_seconds_total{kind=\"foreground\"} %.9f\n"
+                "bm_evict_seconds_total{kind=\"background\"} %.9f\n",
+                s.fgEvictNanos / 1e9, s.bgEvictNanos / 1e9);
+        promMetric(out, "bm_coalesced_writes_total", "counter",
+                   "Pages written along with a dirty victim.", s.coalescedWrites);
+        promMetric(out, "bm_failed_writes_total", "counter",
+                   "Write-backs that failed; the page stayed dirty.", s.failedWrites);
+        promMetric(out, "bm_remote_accesses_total", "counter",
+                   "Hits on a frame of another NUMA partition.", s.remoteAccesses);
+        promMetric(out, "bm_remote_allocations_total", "counter",
+                   "Misses that took a frame of another NUMA partition.", s.remoteAllocations);
+        promHistogram(out, "bm_read_latency_seconds", "Latency of page file read calls.",
+                      s.readLatency, s.readNanos);
+        promHistogram(out, "bm_write_latency_seconds", "Latency of page file write calls.",
+                      s.writeLatency, s.writeNanos);
+        if (haveCurve) {
+            fprintf(out, "# HELP bm_estimated_hit_ratio Hit ratio the pins so far would get with this many frames (LRU).\n"
+                    "# TYPE bm_estimated_hit_ratio gauge\n");
+            for (int i = 0; i < BM_CURVE_POINTS; i++)
+                fprintf(out, "bm_estimated_hit_ratio{pages=\"%d\"} %.10g\n",
+                        curve.pages[i], curve.hitRatio[i]);
+        }
+    }
+    return ferror(out) ? RC_WRITE_FAILED : RC_OK;
+}
+
+// Replace the target file with a new snapshot; readers never see half of one
+static void writeSnapshotFile(BM_StatsExporter *exp, ExporterInfo *info) {
+    size_t len = strlen(info->path);
+    char *tmp = malloc(len + 5);
+    memcpy(tmp, info->path, len);
+    memcpy(tmp + len, ".tmp", 5);
+    FILE *out = fopen(tmp, "w");
+    if (out) {
+        RC rc = writePoolStats(exp->pool, exp->format, out);
+        if (fclose(out) == 0 && rc == RC_OK) rename(tmp, info->path);
+        else remove(tmp);
+    }
+    free(tmp);
+}
+
+// Send a fresh snapshot to one socket client and hang up
+static void serveClient(BM_StatsExporter *exp, ExporterInfo *info) {
+    int fd = accept(info->listenFd, NULL, NULL);
+    if (fd < 0) return;
+    char *buf = NULL;
+    size_t len = 0;
+    FILE *out = open_memstream(&buf, &len);
+    if (out) {
+        writePoolStats(exp->pool, exp->format, out);
+        fclose(out);
+        for (size_t sent = 0; sent < len; ) {
+            ssize_t n = send(fd, buf + sent, len - sent, MSG_NOSIGNAL);
+            if (n <= 0) break;
+            sent += (size_t) n;
+        }
+        free(buf);
+    }
+    close(fd);
+}
+
+static void *exporterMain(void *arg) {
+    BM_StatsExporter *exp = arg;
+    ExporterInfo *info = exp->mgmtInfo;
+    struct pollfd fds[2];
+    fds[0].fd = info->wakeFd[0];
+    fds[0].events = POLLIN;
+    fds[1].fd = info->listenFd;
+    fds[1].events = POLLIN;
+    if (info->listenFd < 0) writeSnapshotFile(exp, info);
+    for (;;) {
+        fds[0].revents = fds[1].revents = 0;
+        int n = info->listenFd >= 0 ? poll(fds, 2, -1) : poll(fds, 1, exp->intervalMs);
+        if (n < 0) continue; // interrupted
+        if (fds[0].revents) break;
+        if (info->listenFd >= 0) {
+            if (fds[1].revents & POLLIN) serveClient(exp, info);
+        } else {
+            writeSnapshotFile(exp, info);
+        }
+    }
+    return NULL;
+}
+
+// Bind and listen on a Unix socket at path, replacing a stale one
+static int openListenSocket(const char *path) {
+    struct sockaddr_un addr;
+    if (strlen(path) >= sizeof(addr.sun_path)) return -1;
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+    unlink(path);
+    if (bind(fd, (struct sockaddr *) &addr, sizeof(addr)) != 0 || listen(fd, 8) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+RC startStatsExporter(BM_StatsExporter *exp, BM_BufferPool *bm, const char *target,
+                      BM_ExportFormat format, int intervalMs) {
+    if (!bm || !bm->mgmtData) return RC_FILE_HANDLE_NOT_INIT;
+    if (!target || !*target) return RC_FILE_NOT_FOUND;
+    ExporterInfo *info = calloc(1, sizeof(ExporterInfo));
+    if (!info) THROW(RC_BM_OUT_OF_MEMORY, "startStatsExporter: allocation failed");
+    bool isSocket = strncmp(target, SOCKET_PREFIX, strlen(SOCKET_PREFIX)) == 0;
+    info->path = strdup(isSocket ? target + strlen(SOCKET_PREFIX) : target);
+    info->listenFd = isSocket ? openListenSocket(info->path) : -1;
+    if ((isSocket && info->listenFd < 0) || pipe(info->wakeFd) != 0) {
+        if (info->listenFd >= 0) close(info->listenFd);
+        free(info->path);
+        free(info);
+        THROW(RC_FILE_NOT_FOUND, "startStatsExporter: cannot open the target");
+    }
+    exp->pool = bm;
+    exp->target = strdup(target);
+    exp->format = format;
+    exp->intervalMs = intervalMs > 0 ? intervalMs : 1000;
+    exp->mgmtInfo = info;
+    pthread_create(&info->thread, NULL, exporterMain, exp);
+    return RC_OK;
+}
+
+RC stopStatsExporter(BM_StatsExporter *exp) {
+    ExporterInfo *info = exp->mgmtInfo;
+    if (!info) return RC_FILE_HANDLE_NOT_INIT;
+    char c = 0;
+    while (write(info->wakeFd[1], &c, 1) < 0) ;
+    pthread_join(info->thread, NULL);
+    if (info->listenFd >= 0) {
+        close(info->listenFd);
+        unlink(info->path);
+    } else {
+        writeSnapshotFile(exp, info);
+    }
+    close(info->wakeFd[0]);
+    close(info->wakeFd[1]);
+    free(info->path);
+    free(info);
+    free(exp->target);
+    exp->mgmtInfo = NULL;
+    return RC_OK;
+}
@@ -0,0 +1,36 @@
+#ifndef STATS_EXPORT_H
+#define STATS_EXPORT_H
+
+#include <stdio.h>
+
+#include "dberror.h"
+#include "buffer_mgr.h"
+
+// Output formats of writePoolStats and the exporter
+typedef enum BM_ExportFormat {
+	BM_EXPORT_PROMETHEUS = 0, // Prometheus text exposition format
+	BM_EXPORT_JSON = 1        // one JSON object
+} BM_ExportFormat;
+
+// Exporter thread publishing getPoolStats snapshots. target is a file
+// path, rewritten every intervalMs (atomically, through a rename), or
+// "unix:<path>" for a Unix socket that serves a fresh snapshot to every
+// client that connects, the way a Prometheus scrape expects.
+typedef struct BM_StatsExporter {
+	BM_BufferPool *pool;
+	char *target;
+	BM_ExportFormat format;
+	int intervalMs;
+	void *mgmtInfo;
+} BM_StatsExporter;
+
+// Format the current statistics of bm to out
+RC writePoolStats (BM_BufferPool *const bm, BM_ExportFormat format, FILE *out);
+
+// Start exporting bm's statistics to target; stop before shutting the pool down
+RC startStatsExporter (BM_StatsExporter *const exp, BM_BufferPool *const bm,
+		const char *target, BM_ExportFormat format, int intervalMs);
+// Stop the exporter; a file target gets one last snapshot first
+RC stopStatsExporter (BM_StatsExporter *const exp);
+
+#endif
@@ -4,6 +4,9 @@
 #include <string.h>
 #include "storage_mgr.h"
 #include "dberror.h"
+#include "probes.h"
+#include "log_store.h"
+#include "shadow_store.h"
 
 /* We hardcode the page size from dberror.h for convenience */
 #define PAGE_SIZE_BYTES PAGE_SIZE
@@ -20,6 +23,11 @@
  *   - fp: the actual FILE* pointer used for I/O.
  *   - fname: a dynamically allocated copy of the file name.
  *   - pages: total number of pages currently known for this file.
+ *   - flushWrites: whether each write is flushed right away (the default).
+ *   - log: the log-structured backend of a file made by createLogPageFile;
+ *     reads and writes go through it instead of fp.
+ *   - shadow: this handle's view of a file made by createShadowPageFile;
+ *     reads and writes go through it, and fp stays unused.
  *
  * This allows us to centralize all file-related bookkeeping in one place.
  */
@@ -27,6 +35,9 @@ typedef struct FileContext {
     FILE *fp;           /* Underlying file pointer for I/O */
     char *fname;        /* Dynamically allocated file name */
     int pages;          /* Number of pages currently in the file */
+    int flushWrites;    /* fflush after every write (0 for scratch files) */
+    LogStore *log;      /* Log-structured backend, NULL for a plain page file */
+    ShadowView *shadow; /* Shadow-paged backend, NULL for a plain page file */
 } FileContext;
 
 /* 
@@ -76,6 +87,11 @@ void initStorageManager(void) {
  *   - RC_WRITE_FAILED if any I/O or memory allocation fails.
  */
 RC createPageFile(char *fileName) {
+    /* A log-structured or shadow-paged file of the same name leaves no
+     * segments or marker behind */
+    logRemoveSegments(fileName);
+    shadowRemoveMarker(fileName);
+
     /* Attempt to open (or create) the file in binary write mode */
     FILE *fp = fopen(fileName, "wb");
     if (fp == NULL) {
@@ -114,6 +130,10 @@ RC createPageFile(char *fileName) {
  *   1. Try to open with mode “rb+” (read/update). If that fails, report RC_FILE_NOT_FOUND.
  *   2. fseek(fp, 0, SEEK_END) and ftell to determine total file size.
  *   3. Compute totalPages = fileSize / PAGE_SIZE_BYTES.
+ *      A log-structured file (createLogPageFile) is opened through
+ *      log_store.c instead, which reports the page count from its header,
+ *      and a shadow-paged file (createShadowPageFile) through shadow_store.c,
+ *      which reports the page count of its last commit.
  *   4. Allocate a FileContext that stores the FILE* and file name copy.
  *   5. Populate fHandle->fileName, totalNumPages, curPagePos=0, and mgmtInfo = context.
  *   6. Remember context in globalOpenCtx for later potential destroyPageFile handling.
@@ -150,9 +170,31 @@ RC openPageFile(char *fileName, SM_FileHandle *fHandle) {
     /* Compute number of whole pages in the file */
     int totalPages = (int)(fileSizeBytes / PAGE_SIZE_BYTES);
 
+    /* A log-structured file keeps its page count in its header */
+    LogStore *log = NULL;
+    if (logIsStore(fileName, fp)) {
+        RC rcLog = logOpen(fp, fileName, &log, &totalPages);
+        if (rcLog != RC_OK) {
+            fclose(fp);
+            THROW(rcLog, "openPageFile: cannot open log-structured page file");
+        }
+    }
+
+    /* A shadow-paged file is read through the map of its last commit */
+    ShadowView *shadow = NULL;
+    if (log == NULL && shadowIsStore(fileName, fp)) {
+        RC rcShadow = shadowOpen(fileName, &shadow, &totalPages);
+        if (rcShadow != RC_OK) {
+            fclose(fp);
+            THROW(rcShadow, "openPageFile: cannot open shadow-paged page file");
+        }
+    }
+
     /* Create a copy of the fileName inside the handle */
     char *nameCopy = (char *) malloc(strlen(fileName) + 1);
     if (nameCopy == NULL) {
+        if (log != NULL) logClose(log);
+        if (shadow != NULL) shadowClose(shadow);
         fclose(fp);
         THROW(RC_FILE_HANDLE_NOT_INIT, "openPageFile: memory allocation failed for fileName");
     }
@@ -162,9 +204,13 @@ RC openPageFile(char *fileName, SM_FileHandle *fHandle) {
     FileContext *ctx = allocateFileContext(nameCopy, fp, totalPages);
     if (ctx == NULL) {
         free(nameCopy);
+        if (log != NULL) logClose(log);
+        if (shadow != NULL) shadowClose(shadow);
         fclose(fp);
         THROW(RC_FILE_HANDLE_NOT_INIT, "openPageFile: failed to allocate FileContext");
     }
+    ctx->log = log;
+    ctx->shadow = shadow;
 
     /* Initialize the SM_FileHandle fields */
     fHandle->fileName     = nameCopy;
@@ -200,11 +246,9 @@ RC closePageFile(SM_FileHandle *fHandle) {
     }
 
     FileContext *ctx = (FileContext *) fHandle->mgmtInfo;
+    /* The context is gone even if closing failed, so the handle is reset
+     * either way; freeFileContext reports errors via THROW */
     RC rc = freeFileContext(ctx);
-    if (rc != RC_OK) {
-        /* freeFileContext will report errors via THROW if needed */
-        return rc;
-    }
 
     /* Free the fileName stored in fHandle and reset mgmtInfo */
     free(fHandle->fileName);
@@ -218,7 +262,7 @@ RC closePageFile(SM_FileHandle *fHandle) {
         globalOpenCtx = NULL;
     }
 
-    return RC_OK;
+    return rc;
 }
 
 /*
@@ -259,7 +303,10 @@ RC destroyPageFile(char *fileName) {
         /* globalOpenCtx cleared in closePageFile */
     }
 
-    /* Now attempt to delete the file from disk */
+    /* Delete the segments and markers of a log-structured or shadow-paged
+     * file, then the file itself */
+    logRemoveSegments(fileName);
+    shadowRemoveMarker(fileName);
     if (remove(fileName) != 0) {
         /* Could not delete (either non-existent or locked) */
         THROW(RC_FILE_NOT_FOUND, "destroyPageFile: failed to remove file");
@@ -293,14 +340,35 @@ RC readBlock(int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage) {
         THROW(RC_READ_NON_EXISTING_PAGE, "readBlock: pageNum out of bounds");
     }
 
+    FileContext *ctx = (FileContext *) fHandle->mgmtInfo;
+    PROBE2(storage, read_start, pageNum, 1);
+    if (ctx->log != NULL) {
+        RC rcLog = logRead(ctx->log, pageNum, memPage);
+        PROBE3(storage, read_done, pageNum, 1, rcLog == RC_OK ? PAGE_SIZE_BYTES : 0);
+        if (rcLog != RC_OK) {
+            THROW(RC_READ_NON_EXISTING_PAGE, "readBlock: could not read page from the log");
+        }
+        fHandle->curPagePos = pageNum;
+        return RC_OK;
+    }
+    if (ctx->shadow != NULL) {
+        RC rcShadow = shadowRead(ctx->shadow, pageNum, memPage);
+        PROBE3(storage, read_done, pageNum, 1, rcShadow == RC_OK ? PAGE_SIZE_BYTES : 0);
+        if (rcShadow != RC_OK) {
+            THROW(RC_READ_NON_EXISTING_PAGE, "readBlock: could not read page through the page map");
+        }
+        fHandle->curPagePos = pageNum;
+        return RC_OK;
+    }
+
     /* Seek to the correct page offset in bytes */
     RC rcSeek = seekToPageNum(pageNum, fHandle);
     if (rcSeek != RC_OK) {
         THROW(RC_READ_NON_EXISTING_PAGE, "readBlock: seek to page failed");
     }
 
-    FileContext *ctx = (FileContext *) fHandle->mgmtInfo;
     size_t actuallyRead = fread(memPage, sizeof(char), PAGE_SIZE_BYTES, ctx->fp);
+    PROBE3(storage, read_done, pageNum, 1, actuallyRead);
     if (actuallyRead < PAGE_SIZE_BYTES) {
         THROW(RC_READ_NON_EXISTING_PAGE, "readBlock: could not read full page");
     }
@@ -310,6 +378,60 @@ RC readBlock(int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage) {
     return RC_OK;
 }
 
+/*
+ * readBlocks
+ *
+ * Read count adjacent pages, firstPage .. firstPage+count-1, into the
+ * contiguous buffer memPages (count * PAGE_SIZE_BYTES) with a single fread.
+ *
+ * Returns:
+ *   - RC_OK on success.
+ *   - RC_FILE_HANDLE_NOT_INIT if handle is null or not opened.
+ *   - RC_READ_NON_EXISTING_PAGE if the range is invalid or I/O fails.
+ */
+RC readBlocks(int firstPage, int count, SM_FileHandle *fHandle, SM_PageHandle memPages) {
+    if (fHandle == NULL || fHandle->mgmtInfo == NULL) {
+        THROW(RC_FILE_HANDLE_NOT_INIT, "readBlocks: file handle not initialized");
+    }
+    if (firstPage < 0 || count < 1 || firstPage + count > fHandle->totalNumPages) {
+        THROW(RC_READ_NON_EXISTING_PAGE, "readBlocks: page range out of bounds");
+    }
+
+    FileContext *ctx = (FileContext *) fHandle->mgmtInfo;
+    PROBE2(storage, read_start, firstPage, count);
+    if (ctx->log != NULL || ctx->shadow != NULL) {
+        /* Adjacent pages need not be adjacent in the log or the shadow
+         * file: one read each */
+        for (int i = 0; i < count; i++) {
+            char *page = memPages + (size_t) i * PAGE_SIZE_BYTES;
+            RC rcRead = ctx->log != NULL ? logRead(ctx->log, firstPage + i, page)
+                                         : shadowRead(ctx->shadow, firstPage + i, page);
+            if (rcRead != RC_OK) {
+                PROBE3(storage, read_done, firstPage, count, (size_t) i * PAGE_SIZE_BYTES);
+                THROW(RC_READ_NON_EXISTING_PAGE, "readBlocks: could not read pages from the log or page map");
+            }
+        }
+        PROBE3(storage, read_done, firstPage, count, (size_t) count * PAGE_SIZE_BYTES);
+        fHandle->curPagePos = firstPage + count - 1;
+        return RC_OK;
+    }
+
+    RC rcSeek = seekToPageNum(firstPage, fHandle);
+    if (rcSeek != RC_OK) {
+        THROW(RC_READ_NON_EXISTING_PAGE, "readBlocks: seek to page failed");
+    }
+
+    size_t bytes = (size_t) count * PAGE_SIZE_BYTES;
+    size_t actuallyRead = fread(memPages, sizeof(char), bytes, ctx->fp);
+    PROBE3(storage, read_done, firstPage, count, actuallyRead);
+    if (actuallyRead < bytes) {
+        THROW(RC_READ_NON_EXISTING_PAGE, "readBlocks: could not read all pages");
+    }
+
+    fHandle->curPagePos = firstPage + count - 1;
+    return RC_OK;
+}
+
 /*
  * getBlockPos
  *
@@ -401,7 +523,7 @@ RC readLastBlock(SM_FileHandle *fHandle, SM_PageHandle memPage) {
  *   2. If pageNum >= totalNumPages, call ensureCapacity(pageNum+1).
  *   3. Seek to the page offset.
  *   4. fwrite exactly PAGE_SIZE_BYTES from memPage into file.
- *   5. fflush to ensure write goes to disk.
+ *   5. fflush to ensure write goes to disk (unless setPageFileFlush turned it off).
  *   6. Update curPagePos.
  *
  * Returns:
@@ -425,24 +547,130 @@ RC writeBlock(int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage) {
         }
     }
 
+    FileContext *ctx = (FileContext *) fHandle->mgmtInfo;
+    PROBE2(storage, write_start, pageNum, 1);
+    if (ctx->log != NULL) {
+        /* Appended to the log; the previous copy of the page becomes garbage */
+        RC rcLog = logWrite(ctx->log, pageNum, 1, &memPage);
+        PROBE3(storage, write_done, pageNum, 1, rcLog == RC_OK ? PAGE_SIZE_BYTES : 0);
+        if (rcLog != RC_OK) {
+            THROW(RC_WRITE_FAILED, "writeBlock: could not append page to the log");
+        }
+        fHandle->curPagePos = pageNum;
+        return RC_OK;
+    }
+    if (ctx->shadow != NULL) {
+        /* Written to a free block; other handles see it after commitPageFile */
+        RC rcShadow = shadowWrite(ctx->shadow, pageNum, 1, &memPage);
+        PROBE3(storage, write_done, pageNum, 1, rcShadow == RC_OK ? PAGE_SIZE_BYTES : 0);
+        if (rcShadow != RC_OK) {
+            THROW(RC_WRITE_FAILED, "writeBlock: could not write shadow page");
+        }
+        fHandle->curPagePos = pageNum;
+        return RC_OK;
+    }
+
     /* Seek to correct position in file */
     RC rcSeek = seekToPageNum(pageNum, fHandle);
     if (rcSeek != RC_OK) {
         THROW(RC_WRITE_FAILED, "writeBlock: seek to page failed");
     }
 
-    FileContext *ctx = (FileContext *) fHandle->mgmtInfo;
     size_t written = fwrite(memPage, sizeof(char), PAGE_SIZE_BYTES, ctx->fp);
     if (written < PAGE_SIZE_BYTES) {
         THROW(RC_WRITE_FAILED, "writeBlock: could not write full page");
     }
-    fflush(ctx->fp);
+    if (ctx->flushWrites) {
+        fflush(ctx->fp);
+    }
+    PROBE3(storage, write_done, pageNum, 1, written);
 
     /* Update the handle’s metadata */
     fHandle->curPagePos = pageNum;
     return RC_OK;
 }
 
+/*
+ * writeBlocks
+ *
+ * Write count pages, memPages[0..count-1], to the adjacent page numbers
+ * firstPage .. firstPage+count-1 as one write. Steps:
+ *   1. Validate handle and range; extend the file if the run ends past it.
+ *   2. Copy the pages into one contiguous buffer (they need not be adjacent
+ *      in memory).
+ *   3. Seek once and fwrite the whole buffer, then fflush once (if enabled).
+ *   4. Update curPagePos to the last page written.
+ *
+ * Returns:
+ *   - RC_OK on success.
+ *   - RC_FILE_HANDLE_NOT_INIT if uninitialized.
+ *   - RC_WRITE_FAILED on any I/O or allocation error.
+ */
+RC writeBlocks(int firstPage, int count, SM_FileHandle *fHandle, SM_PageHandle *memPages) {
+    if (fHandle == NULL || fHandle->mgmtInfo == NULL) {
+        THROW(RC_FILE_HANDLE_NOT_INIT, "writeBlocks: file handle not initialized");
+    }
+    if (firstPage < 0 || count < 1) {
+        THROW(RC_WRITE_FAILED, "writeBlocks: invalid page range");
+    }
+    if (count == 1) {
+        return writeBlock(firstPage, fHandle, memPages[0]);
+    }
+
+    /* If the run ends beyond the current end, extend capacity */
+    if (firstPage + count > fHandle->totalNumPages) {
+        RC rcExtend = ensureCapacity(firstPage + count, fHandle);
+        if (rcExtend != RC_OK) {
+            THROW(RC_WRITE_FAILED, "writeBlocks: ensureCapacity failed");
+        }
+    }
+
+    FileContext *ctx = (FileContext *) fHandle->mgmtInfo;
+    if (ctx->log != NULL || ctx->shadow != NULL) {
+        /* The log gathers the run into adjacent records itself; shadow
+         * pages go wherever free blocks are */
+        PROBE2(storage, write_start, firstPage, count);
+        RC rcLog = ctx->log != NULL ? logWrite(ctx->log, firstPage, count, memPages)
+                                    : shadowWrite(ctx->shadow, firstPage, count, memPages);
+        PROBE3(storage, write_done, firstPage, count,
+               rcLog == RC_OK ? (size_t) count * PAGE_SIZE_BYTES : 0);
+        if (rcLog != RC_OK) {
+            THROW(RC_WRITE_FAILED, "writeBlocks: could not write pages to the log or shadow file");
+        }
+        fHandle->curPagePos = firstPage + count - 1;
+        return RC_OK;
+    }
+
+    /* Gather the pages so stdio issues a single write */
+    char *run = (char *) malloc((size_t) count * PAGE_SIZE_BYTES);
+    if (run == NULL) {
+        THROW(RC_WRITE_FAILED, "writeBlocks: memory allocation failed");
+    }
+    for (int i = 0; i < count; i++) {
+        memcpy(run + (size_t) i * PAGE_SIZE_BYTES, memPages[i], PAGE_SIZE_BYTES);
+    }
+
+    PROBE2(storage, write_start, firstPage, count);
+    RC rcSeek = seekToPageNum(firstPage, fHandle);
+    if (rcSeek != RC_OK) {
+        free(run);
+        THROW(RC_WRITE_FAILED, "writeBlocks: seek to page failed");
+    }
+
+    size_t written = fwrite(run, sizeof(char), (size_t) count * PAGE_SIZE_BYTES, ctx->fp);
+    free(run);
+    if (written < (size_t) count * PAGE_SIZE_BYTES) {
+        THROW(RC_WRITE_FAILED, "writeBlocks: could not write all pages");
+    }
+    if (ctx->flushWrites) {
+        fflush(ctx->fp);
+    }
+    PROBE3(storage, write_done, firstPage, count, written);
+
+    fHandle->curPagePos = firstPage + count - 1;
+    return RC_OK;
+}
+
 /*
  * writeCurrentBlock
  *
@@ -476,6 +704,20 @@ RC appendEmptyBlock(SM_FileHandle *fHandle) {
 
     FileContext *ctx = (FileContext *) fHandle->mgmtInfo;
 
+    /* A log-structured or shadow-paged file only records the new size:
+     * unwritten pages read as zeros */
+    if (ctx->log != NULL || ctx->shadow != NULL) {
+        RC rcGrow = ctx->log != NULL ? logSetPages(ctx->log, ctx->pages + 1)
+                                     : shadowSetPages(ctx->shadow, ctx->pages + 1);
+        if (rcGrow != RC_OK) {
+            THROW(RC_WRITE_FAILED, "appendEmptyBlock: could not grow the log-structured or shadow-paged file");
+        }
+        ctx->pages += 1;
+        fHandle->totalNumPages = ctx->pages;
+        fHandle->curPagePos    = ctx->pages - 1;
+        return RC_OK;
+    }
+
     /* Move to end of file */
     if (fseek(ctx->fp, 0L, SEEK_END) != 0) {
         THROW(RC_WRITE_FAILED, "appendEmptyBlock: seek to end failed");
@@ -493,7 +735,9 @@ RC appendEmptyBlock(SM_FileHandle *fHandle) {
     if (written < PAGE_SIZE_BYTES) {
         THROW(RC_WRITE_FAILED, "appendEmptyBlock: failed to write full zero page");
     }
-    fflush(ctx->fp);
+    if (ctx->flushWrites) {
+        fflush(ctx->fp);
+    }
 
     /* Update context and handle metadata */
     ctx->pages += 1;
@@ -503,6 +747,31 @@ RC appendEmptyBlock(SM_FileHandle *fHandle) {
     return RC_OK;
 }
 
+/*
+ * setPageFileFlush
+ *
+ * Choose whether writes to this file are flushed one by one (flush != 0,
+ * the default) or left to stdio buffering until the next seek, read or
+ * close. Scratch files that need not survive a crash turn flushing off.
+ * A shadow-paged file ignores it: its writes bypass stdio and become
+ * durable at commitPageFile.
+ *
+ * Returns:
+ *   - RC_OK on success.
+ *   - RC_FILE_HANDLE_NOT_INIT if handle is null or not opened.
+ */
+RC setPageFileFlush(SM_FileHandle *fHandle, int flush) {
+    if (fHandle == NULL || fHandle->mgmtInfo == NULL) {
+        THROW(RC_FILE_HANDLE_NOT_INIT, "setPageFileFlush: file handle not initialized");
+    }
+    FileContext *ctx = (FileContext *) fHandle->mgmtInfo;
+    ctx->flushWrites = flush != 0;
+    if (ctx->log != NULL) {
+        logSetFlush(ctx->log, ctx->flushWrites);
+    }
+    return RC_OK;
+}
+
 /*
  * ensureCapacity
  *
@@ -522,6 +791,21 @@ RC ensureCapacity(int numberOfPages, SM_FileHandle *fHandle) {
         THROW(RC_WRITE_FAILED, "ensureCapacity: invalid numberOfPages");
     }
 
+    /* A log-structured file grows by one header update, a shadow-paged
+     * one by its next commit */
+    FileContext *ctx = (FileContext *) fHandle->mgmtInfo;
+    if ((ctx->log != NULL || ctx->shadow != NULL) && fHandle->totalNumPages < numberOfPages) {
+        RC rcGrow = ctx->log != NULL ? logSetPages(ctx->log, numberOfPages)
+                                     : shadowSetPages(ctx->shadow, numberOfPages);
+        if (rcGrow != RC_OK) {
+            THROW(RC_WRITE_FAILED, "ensureCapacity: could not grow the log-structured or shadow-paged file");
+        }
+        ctx->pages = numberOfPages;
+        fHandle->totalNumPages = numberOfPages;
+        fHandle->curPagePos    = numberOfPages - 1;
+        return RC_OK;
+    }
+
     /* Keep appending until we have at least numberOfPages pages */
     while (fHandle->totalNumPages < numberOfPages) {
         RC rc = appendEmptyBlock(fHandle);
@@ -532,6 +816,166 @@ RC ensureCapacity(int numberOfPages, SM_FileHandle *fHandle) {
     return RC_OK;
 }
 
+/*
+ * createLogPageFile
+ *
+ * Create a log-structured page file: like createPageFile it holds one zero
+ * page, but writes to it never overwrite a page in place. Each write
+ * appends the page to the current segment file (<fileName>.seg<N>,
+ * segmentPages pages each, 0 = LOG_SEGMENT_PAGES) and an indirection table
+ * maps page numbers to their latest copy. A cleaner thread reclaims
+ * segments that are mostly dead. The marker file <fileName>.logstore lets
+ * openPageFile recognize it; every other call works on it unchanged.
+ *
+ * Returns:
+ *   - RC_OK on success.
+ *   - RC_WRITE_FAILED if the file cannot be written.
+ */
+RC createLogPageFile(char *fileName, int segmentPages) {
+    if (fileName == NULL) {
+        THROW(RC_WRITE_FAILED, "createLogPageFile: null fileName");
+    }
+    shadowRemoveMarker(fileName);
+    if (logCreate(fileName, segmentPages) != RC_OK) {
+        THROW(RC_WRITE_FAILED, "createLogPageFile: failed to write the file");
+    }
+    return RC_OK;
+}
+
+/*
+ * cleanPageFile
+ *
+ * Reclaim every segment of a log-structured file that is mostly dead now,
+ * in the calling thread, instead of waiting for the cleaner. A no-op for
+ * a plain page file.
+ *
+ * Returns:
+ *   - RC_OK on success.
+ *   - RC_FILE_HANDLE_NOT_INIT if handle is null or not opened.
+ *   - RC_WRITE_FAILED or RC_READ_NON_EXISTING_PAGE on I/O errors.
+ */
+RC cleanPageFile(SM_FileHandle *fHandle) {
+    if (fHandle == NULL || fHandle->mgmtInfo == NULL) {
+        THROW(RC_FILE_HANDLE_NOT_INIT, "cleanPageFile: file handle not initialized");
+    }
+    FileContext *ctx = (FileContext *) fHandle->mgmtInfo;
+    return ctx->log != NULL ? logClean(ctx->log) : RC_OK;
+}
+
+/*
+ * getPageFileLogStats
+ *
+ * Fill stats with the segment and cleaner counters of a log-structured file.
+ *
+ * Returns:
+ *   - RC_OK on success.
+ *   - RC_FILE_HANDLE_NOT_INIT if handle is null, not opened or not log-structured.
+ */
+RC getPageFileLogStats(SM_FileHandle *fHandle, SM_LogStats *stats) {
+    if (fHandle == NULL || fHandle->mgmtInfo == NULL || stats == NULL
+        || ((FileContext *) fHandle->mgmtInfo)->log == NULL) {
+        THROW(RC_FILE_HANDLE_NOT_INIT, "getPageFileLogStats: not a log-structured page file");
+    }
+    logStats(((FileContext *) fHandle->mgmtInfo)->log, stats);
+    return RC_OK;
+}
+
+/*
+ * createShadowPageFile
+ *
+ * Create a shadow-paged page file: like createPageFile it holds one zero
+ * page, but a write never overwrites the block a page was committed in.
+ * The page goes to a free block of the file and only this handle's page
+ * map changes; commitPageFile makes all writes since the last commit
+ * durable and visible to other handles at once, by switching the root of
+ * the page map with one synced header write. A crash leaves the pages of
+ * the last commit, and closePageFile commits. The marker file
+ * <fileName>.shadowstore lets openPageFile recognize it; every other call
+ * works on it unchanged.
+ *
+ * Returns:
+ *   - RC_OK on success.
+ *   - RC_WRITE_FAILED if the file cannot be written.
+ */
+RC createShadowPageFile(char *fileName) {
+    if (fileName == NULL) {
+        THROW(RC_WRITE_FAILED, "createShadowPageFile: null fileName");
+    }
+    logRemoveSegments(fileName);
+    if (shadowCreate(fileName) != RC_OK) {
+        THROW(RC_WRITE_FAILED, "createShadowPageFile: failed to write the file");
+    }
+    return RC_OK;
+}
+
+/*
+ * commitPageFile
+ *
+ * Make every page this handle wrote to a shadow-paged file since its last
+ * commit durable and visible to other handles as one step. Other handles
+ * keep reading the commit they started from until they call commitPageFile
+ * or abortPageFile themselves (with nothing written, both only move the
+ * handle to the latest commit), so they never see half of a batch. The
+ * page count may change with the move. For a plain or log-structured file
+ * it only flushes stdio.
+ *
+ * Returns:
+ *   - RC_OK on success.
+ *   - RC_FILE_HANDLE_NOT_INIT if handle is null or not opened.
+ *   - RC_COMMIT_CONFLICT if another handle committed since this handle's
+ *     last commit; its writes are dropped and it reads the latest commit.
+ *   - RC_WRITE_FAILED on I/O errors; the writes stay pending.
+ */
+RC commitPageFile(SM_FileHandle *fHandle) {
+    if (fHandle == NULL || fHandle->mgmtInfo == NULL) {
+        THROW(RC_FILE_HANDLE_NOT_INIT, "commitPageFile: file handle not initialized");
+    }
+    FileContext *ctx = (FileContext *) fHandle->mgmtInfo;
+    if (ctx->shadow == NULL) {
+        if (fflush(ctx->fp) != 0) {
+            THROW(RC_WRITE_FAILED, "commitPageFile: fflush failed");
+        }
+        return RC_OK;
+    }
+
+    RC rc = shadowCommit(ctx->shadow, &ctx->pages);
+    fHandle->totalNumPages = ctx->pages;
+    if (fHandle->curPagePos >= ctx->pages) {
+        fHandle->curPagePos = ctx->pages - 1;
+    }
+    if (rc == RC_COMMIT_CONFLICT) {
+        THROW(rc, "commitPageFile: another handle committed first, writes dropped");
+    }
+    if (rc != RC_OK) {
+        THROW(RC_WRITE_FAILED, "commitPageFile: could not write the page map");
+    }
+    return RC_OK;
+}
+
+/*
+ * abortPageFile
+ *
+ * Drop every page this handle wrote to a shadow-paged file since its last
+ * commit (and any growth) and move it to the latest commit.
+ *
+ * Returns:
+ *   - RC_OK on success.
+ *   - RC_FILE_HANDLE_NOT_INIT if handle is null, not opened or not shadow-paged.
+ */
+RC abortPageFile(SM_FileHandle *fHandle) {
+    if (fHandle == NULL || fHandle->mgmtInfo == NULL
+        || ((FileContext *) fHandle->mgmtInfo)->shadow == NULL) {
+        THROW(RC_FILE_HANDLE_NOT_INIT, "abortPageFile: not a shadow-paged page file");
+    }
+    FileContext *ctx = (FileContext *) fHandle->mgmtInfo;
+    shadowAbort(ctx->shadow, &ctx->pages);
+    fHandle->totalNumPages = ctx->pages;
+    if (fHandle->curPagePos >= ctx->pages) {
+        fHandle->curPagePos = ctx->pages - 1;
+    }
+    return RC_OK;
+}
+
 /*
  * seekToPageNum (internal helper)
  *
@@ -578,6 +1022,9 @@ static FileContext* allocateFileContext(const char *fileName, FILE *fp, int tota
     ctx->fp    = fp;
     ctx->fname = (char *) fileName;  /* take ownership */
     ctx->pages = totalPages;
+    ctx->flushWrites = 1;
+    ctx->log = NULL;
+    ctx->shadow = NULL;
     return ctx;
 }
 
@@ -586,24 +1033,49 @@ static FileContext* allocateFileContext(const char *fileName, FILE *fp, int tota
  *
  * Close the FILE* in the context and free the memory. Steps:
  *   1. If ctx or ctx->fp is NULL, THROW RC_FILE_HANDLE_NOT_INIT.
- *   2. fclose(ctx->fp).
+ *   2. Close the log-structured backend, if any, or commit the writes of a
+ *      shadow-paged file and drop its view, then fclose(ctx->fp).
  *   3. free(ctx) (note: fileName is freed separately in closePageFile).
+ * The context is freed even when step 2 fails; the file is closed either way.
  *
  * Returns:
  *   - RC_OK on success.
  *   - RC_FILE_HANDLE_NOT_INIT if the context is invalid.
- *   - RC_WRITE_FAILED if fclose fails (rare).
+ *   - RC_COMMIT_CONFLICT if another handle committed first; the writes of
+ *     this one since its last commit are dropped.
+ *   - RC_WRITE_FAILED if the table write-back, the commit or fclose fails.
  */
 static RC freeFileContext(FileContext *ctx) {
     if (ctx == NULL || ctx->fp == NULL) {
         THROW(RC_FILE_HANDLE_NOT_INIT, "freeFileContext: invalid context or FILE*");
     }
-    if (fclose(ctx->fp) != 0) {
-        THROW(RC_WRITE_FAILED, "freeFileContext: fclose failed");
+    RC rc = RC_OK;
+    char *msg = NULL;
+    /* A log-structured file writes its table back before the close */
+    if (ctx->log != NULL && (rc = logClose(ctx->log)) != RC_OK) {
+        msg = "freeFileContext: writing back the page table failed";
+    }
+    /* ... and a shadow-paged one commits what it wrote since its last commit */
+    if (ctx->shadow != NULL) {
+        int pages;
+        rc = shadowCommit(ctx->shadow, &pages);
+        if (rc == RC_COMMIT_CONFLICT) {
+            msg = "freeFileContext: another handle committed first, writes dropped";
+        } else if (rc != RC_OK) {
+            msg = "freeFileContext: commit on close failed";
+        }
+        shadowClose(ctx->shadow);
+    }
+    if (fclose(ctx->fp) != 0 && rc == RC_OK) {
+        rc = RC_WRITE_FAILED;
+        msg = "freeFileContext: fclose failed";
     }
     /* We do NOT free ctx->fname here, because the SM_FileHandle is
      * responsible for that. We only free the context struct itself.
      */
     free(ctx);
+    if (rc != RC_OK) {
+        THROW(rc, msg);
+    }
     return RC_OK;
 }
@@ -15,6 +15,16 @@ typedef struct SM_FileHandle {
 
 typedef char* SM_PageHandle;
 
+/* counters of a log-structured page file (getPageFileLogStats) */
+typedef struct SM_LogStats {
+	int segments;          /* segment files on disk */
+	int livePages;         /* records that are the latest copy of their page */
+	int deadPages;         /* superseded records not reclaimed yet */
+	long appendedPages;    /* records appended by writes since open */
+	long cleanedSegments;  /* segments reclaimed by the cleaner since open */
+	long copiedPages;      /* live records the cleaner moved since open */
+} SM_LogStats;
+
 /************************************************************
  *                    interface                             *
  ************************************************************/
@@ -27,6 +37,7 @@ extern RC destroyPageFile (char *fileName);
 
 /* reading blocks from disc */
 extern RC readBlock (int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage);
+extern RC readBlocks (int firstPage, int count, SM_FileHandle *fHandle, SM_PageHandle memPages);
 extern int getBlockPos (SM_FileHandle *fHandle);
 extern RC readFirstBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
 extern RC readPreviousBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
@@ -36,8 +47,22 @@ extern RC readLastBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
 
 /* writing blocks to a page file */
 extern RC writeBlock (int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage);
+extern RC writeBlocks (int firstPage, int count, SM_FileHandle *fHandle, SM_PageHandle *memPages);
 extern RC writeCurrentBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
 extern RC appendEmptyBlock (SM_FileHandle *fHandle);
 extern RC ensureCapacity (int numberOfPages, SM_FileHandle *fHandle);
+extern RC setPageFileFlush (SM_FileHandle *fHandle, int flush);
+
+/* log-structured page files: writes append to segment files (log_store.h);
+ * openPageFile and the calls above work on them unchanged */
+extern RC createLogPageFile (char *fileName, int segmentPages);
+extern RC cleanPageFile (SM_FileHandle *fHandle);
+extern RC getPageFileLogStats (SM_FileHandle *fHandle, SM_LogStats *stats);
+
+/* shadow-paged page files: writes go to free blocks and become durable and
+ * visible to other handles together at commitPageFile (shadow_store.h) */
+extern RC createShadowPageFile (char *fileName);
+extern RC commitPageFile (SM_FileHandle *fHandle);
+extern RC abortPageFile (SM_FileHandle *fHandle);
 
 #endif
@@ -0,0 +1,582 @@
+// pthreads, rwlocks, barriers, pread and sched_yield are POSIX, not plain C99
+#define _POSIX_C_SOURCE 200809L
+
+// Concurrency checker for the buffer pool. Threads pin, unpin, read, write,
+// markDirty, forcePage and forceFlushPool random pages in random order
+// while a shadow model tracks what every page must contain and how often
+// the harness holds it pinned. Checked as the run goes:
+//   - a pinned page holds exactly the last version written to it
+//   - pins of the same page that overlap get the same frame memory
+//   - forcePage puts the current version in the page file
+// and at the end of each round, with every thread stopped at a barrier:
+//   - no page sits in two frames, every held page is resident and each
+//     frame's fix count equals the pins the harness holds on its page
+//   - after forceFlushPool every unpinned page is on disk at its last version
+// and after shutdownBufferPool every page is. Each call is also recorded as
+// an interval in a history, checked at the end (and with -c, offline, from
+// a file written with -o): per page, versions are written 1, 2, ... and
+// every read returns a version that was current at some instant between
+// its start and end, i.e. the pages behave as linearizable registers.
+//
+// The pool does not latch page contents; the harness does, with a
+// reader/writer latch per page, as a record manager on top of it would.
+
+#include "storage_mgr.h"
+#include "buffer_mgr.h"
+#include "dberror.h"
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_HELD 16
+#define MAX_REPORTS 20
+
+// Calls in a history
+#define OP_PIN 'P'
+#define OP_UNPIN 'U'
+#define OP_READ 'R'
+#define OP_WRITE 'W'
+#define OP_FORCE 'F'
+#define OP_FLUSH 'L'
+
+// Shadow state of one page
+typedef struct ShadowPage {
+    pthread_rwlock_t latch; // page contents: readers shared, writers exclusive
+    long long version;      // last version written (exclusive latch)
+    pthread_mutex_t lock;   // holders and frameData
+    int holders;            // pins the harness holds on the page
+    char *frameData;        // frame memory while held
+} ShadowPage;
+
+// One call: [start, end] in nanoseconds, the version read, written or
+// found on disk, and the result
+typedef struct HistoryEntry {
+    long long start, end;
+    int thread;
+    char op;
+    int page;
+    long long version;
+    RC rc;
+} HistoryEntry;
+
+typedef struct Worker {
+    pthread_t thread;
+    int id;
+    unsigned long long rng;
+    BM_PageHandle held[MAX_HELD];
+    int numHeld;
+    HistoryEntry *history;
+    long numHistory, maxHistory;
+    long ops;
+} Worker;
+
+typedef struct StressConfig {
+    int threads;
+    int poolPages;
+    int filePages;
+    long opsPerRound;
+    int rounds;
+    int maxHeld;
+    ReplacementStrategy strat;
+    int ioWorkers;
+    int freeLow;           // background evictor watermark, 0 = off
+    int coalesce;
+    int numaNodes;
+    int yieldPercent;
+    unsigned long long seed;
+    const char *fileName;
+} StressConfig;
+
+static StressConfig cfg;
+static BM_BufferPool pool;
+static ShadowPage *shadow;
+static int diskFd;
+static pthread_barrier_t roundStart, roundEnd;
+static long violations;
+static pthread_mutex_t reportLock = PTHREAD_MUTEX_INITIALIZER;
+
+static const char *strategyNames[] = { "fifo", "lru", "clock", "lfu", "lru_k" };
+
+static long long nowNanos(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long) ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// xorshift64*: the same choices for a seed on every platform
+static unsigned long long nextRandom(unsigned long long *state) {
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 2685821657736338717ULL;
+}
+
+// Count a violated invariant; the first few are printed
+static void violation(const char *fmt, ...) {
+    va_list args;
+    pthread_mutex_lock(&reportLock);
+    if (violations++ < MAX_REPORTS) {
+        va_start(args, fmt);
+        fprintf(stderr, "violation: ");
+        vfprintf(stderr, fmt, args);
+        fprintf(stderr, "\n");
+        va_end(args);
+    }
+    pthread_mutex_unlock(&reportLock);
+}
+
+// Page image of a version: page number, version, then bytes derived from both
+static void fillPage(char *data, int page, long long version) {
+    memcpy(data, &page, sizeof(int));
+    memcpy(data + sizeof(int), &version, sizeof(long long));
+    for (int i = sizeof(int) + sizeof(long long); i < PAGE_SIZE; i++)
+        data[i] = (char) (page * 31 + version * 17 + i);
+}
+
+// Version held by a page image, -1 when it is not an intact image of page
+static long long pageVersion(const char *data, int page) {
+    int stored;
+    long long version;
+    memcpy(&stored, data, sizeof(int));
+    memcpy(&version, data + sizeof(int), sizeof(long long));
+    if (stored != page) return -1;
+    for (int i = sizeof(int) + sizeof(long long); i < PAGE_SIZE; i++)
+        if (data[i] != (char) (page * 31 + version * 17 + i)) return -1;
+    return version;
+}
+
+// Version of page in the page file, read past the storage manager's stdio
+static long long diskVersion(int page) {
+    char buf[PAGE_SIZE];
+    if (pread(diskFd, buf, PAGE_SIZE, (off_t) page * PAGE_SIZE) != PAGE_SIZE) return -1;
+    return pageVersion(buf, page);
+}
+
+static void record(Worker *w, long long start, char op, int page, long long version, RC rc) {
+    if (w->numHistory == w->maxHistory) {
+        w->maxHistory = w->maxHistory ? 2 * w->maxHistory : 4096;
+        w->history = realloc(w->history, sizeof(HistoryEntry) * w->maxHistory);
+    }
+    HistoryEntry *e = &w->history[w->numHistory++];
+    e->start = start;
+    e->end = nowNanos();
+    e->thread = w->id;
+    e->op = op;
+    e->page = page;
+    e->version = version;
+    e->rc = rc;
+}
+
+// Half the accesses go to the first eighth of the file, so pages are shared
+static int choosePage(Worker *w) {
+    unsigned long long r = nextRandom(&w->rng);
+    int hot = cfg.filePages / 8 > 0 ? cfg.filePages / 8 : 1;
+    return (int) (r & 1 ? (r >> 1) % hot : (r >> 1) % cfg.filePages);
+}
+
+static void doPin(Worker *w) {
+    int page = choosePage(w);
+    BM_PageHandle *h = &w->held[w->numHeld];
+    long long start = nowNanos();
+    RC rc = pinPage(&pool, h, page);
+    record(w, start, OP_PIN, page, -1, rc);
+    if (rc != RC_OK) {
+        violation("pin of page %d failed with rc %d", page, rc);
+        return;
+    }
+    if (h->pageNum != page)
+        violation("pin of page %d returned page %d", page, h->pageNum);
+    ShadowPage *s = &shadow[page];
+    pthread_mutex_lock(&s->lock);
+    if (s->holders > 0 && s->frameData != h->data)
+        violation("page %d pinned in two frames at once", page);
+    s->frameData = h->data;
+    s->holders++;
+    pthread_mutex_unlock(&s->lock);
+    w->numHeld++;
+}
+
+static void doUnpin(Worker *w, int k) {
+    BM_PageHandle h = w->held[k];
+    w->held[k] = w->held[--w->numHeld];
+    ShadowPage *s = &shadow[h.pageNum];
+    pthread_mutex_lock(&s->lock);
+    s->holders--;
+    pthread_mutex_unlock(&s->lock);
+    long long start = nowNanos();
+    RC rc = unpinPage(&pool, &h);
+    record(w, start, OP_UNPIN, h.pageNum, -1, rc);
+    if (rc != RC_OK) violation("unpin of page %d failed with rc %d", h.pageNum, rc);
+}
+
+static void doRead(Worker *w, BM_PageHandle *h) {
+    ShadowPage *s = &shadow[h->pageNum];
+    long long start = nowNanos();
+    pthread_rwlock_rdlock(&s->latch);
+    long long v = pageVersion(h->data, h->pageNum);
+    if (v != s->version)
+        violation("page %d holds version %lld, expected %lld", h->pageNum, v, s->version);
+    pthread_rwlock_unlock(&s->latch);
+    record(w, start, OP_READ, h->pageNum, v, RC_OK);
+}
+
+static void doWrite(Worker *w, BM_PageHandle *h) {
+    ShadowPage *s = &shadow[h->pageNum];
+    long long start = nowNanos();
+    pthread_rwlock_wrlock(&s->latch);
+    long long v = ++s->version;
+    fillPage(h->data, h->pageNum, v);
+    RC rc = markDirty(&pool, h);
+    pthread_rwlock_unlock(&s->latch);
+    record(w, start, OP_WRITE, h->pageNum, v, rc);
+    if (rc != RC_OK) violation("markDirty of page %d failed with rc %d", h->pageNum, rc);
+}
+
+// Under the exclusive latch nobody else changes or writes the page, so the
+// file must hold exactly the shadow version once forcePage returns
+static void doForce(Worker *w, BM_PageHandle *h) {
+    ShadowPage *s = &shadow[h->pageNum];
+    long long start = nowNanos();
+    pthread_rwlock_wrlock(&s->latch);
+    RC rc = forcePage(&pool, h);
+    long long v = diskVersion(h->pageNum);
+    if (rc == RC_OK && v != s->version)
+        violation("page %d forced, file has version %lld, expected %lld", h->pageNum, v, s->version);
+    pthread_rwlock_unlock(&s->latch);
+    record(w, start, OP_FORCE, h->pageNum, v, rc);
+    if (rc != RC_OK) violation("forcePage of page %d failed with rc %d", h->pageNum, rc);
+}
+
+static void doFlush(Worker *w) {
+    long long start = nowNanos();
+    RC rc = forceFlushPool(&pool);
+    record(w, start, OP_FLUSH, NO_PAGE, -1, rc);
+    if (rc != RC_OK) violation("forceFlushPool failed with rc %d", rc);
+}
+
+static void *workerMain(void *arg) {
+    Worker *w = arg;
+    for (int round = 0; round < cfg.rounds; round++) {
+        pthread_barrier_wait(&roundStart);
+        for (long i = 0; i < cfg.opsPerRound; i++) {
+            unsigned long long r = nextRandom(&w->rng);
+            int pick = (int) (r % 100);
+            BM_PageHandle *h = w->numHeld ? &w->held[(r >> 8) % w->numHeld] : NULL;
+            if (cfg.yieldPercent > 0 && (int) ((r >> 32) % 100) < cfg.yieldPercent) sched_yield();
+            if (!h || (pick < 30 && w->numHeld < cfg.maxHeld)) doPin(w);
+            else if (pick < 60) doUnpin(w, (int) (h - w->held));
+            else if (pick < 80) doRead(w, h);
+            else if (pick < 95) doWrite(w, h);
+            else if (pick < 99) doForce(w, h);
+            else doFlush(w);
+            w->ops++;
+        }
+        // the held pins stay across the barrier and are checked there
+        pthread_barrier_wait(&roundEnd);
+    }
+    // released only once the last round has been checked
+    pthread_barrier_wait(&roundStart);
+    while (w->numHeld > 0) doUnpin(w, w->numHeld - 1);
+    return NULL;
+}
+
+// Frame contents and fix counts against the shadow, then flush and
+// check the file; runs while every worker waits at the barrier
+static void checkQuiescent(void) {
+    PageNumber *pages = getFrameContents(&pool);
+    int *fix = getFixCounts(&pool);
+    int *frameOf = malloc(sizeof(int) * cfg.filePages);
+    for (int p = 0; p < cfg.filePages; p++) frameOf[p] = -1;
+    for (int i = 0; i < pool.numPages; i++) {
+        int p = pages[i];
+        if (p == NO_PAGE) continue;
+        if (p < 0 || p >= cfg.filePages) {
+            violation("frame holds page %d outside the file", p);
+            continue;
+        }
+        if (frameOf[p] >= 0)
+            violation("page %d resident in frames %d and %d", p, frameOf[p], i);
+        frameOf[p] = i;
+        if (fix[i] != shadow[p].holders)
+            violation("page %d has fix count %d, harness holds %d pins", p, fix[i], shadow[p].holders);
+    }
+    for (int p = 0; p < cfg.filePages; p++)
+        if (shadow[p].holders > 0 && frameOf[p] < 0)
+            violation("page %d is pinned %d times but not resident", p, shadow[p].holders);
+    free(pages);
+    free(fix);
+    free(frameOf);
+
+    // pinned pages are skipped by the flush, so their file copy may be older
+    RC rc = forceFlushPool(&pool);
+    if (rc != RC_OK) violation("forceFlushPool failed with rc %d", rc);
+    for (int p = 0; p < cfg.filePages; p++) {
+        long long v = diskVersion(p);
+        if (shadow[p].holders == 0 ? v != shadow[p].version : v < 0 || v > shadow[p].version)
+            violation("page %d flushed, file has version %lld, expected %lld", p, v, shadow[p].version);
+    }
+}
+
+// By page; per page the writes first, by version, then the rest by start
+static int compareEntries(const void *a, const void *b) {
+    const HistoryEntry *x = a, *y = b;
+    int xw = x->op == OP_WRITE, yw = y->op == OP_WRITE;
+    if (x->page != y->page) return (x->page > y->page) - (x->page < y->page);
+    if (xw != yw) return yw - xw;
+    if (xw) return (x->version > y->version) - (x->version < y->version);
+    return (x->start > y->start) - (x->start < y->start);
+}
+
+// Check that each page behaves as a linearizable register. Version v is
+// current from the write of v until the write of v + 1; a read of v must
+// overlap that window: it cannot end before the write of v starts, nor
+// start after the write of v + 1 has ended. Returns the violations found.
+static long checkHistory(HistoryEntry *h, long n) {
+    long bad = 0;
+    qsort(h, n, sizeof(HistoryEntry), compareEntries);
+    for (long first = 0; first < n; ) {
+        int page = h[first].page;
+        long end = first;
+        while (end < n && h[end].page == page) end++;
+        if (page == NO_PAGE) {
+            first = end;
+            continue;
+        }
+        // the writes come first, and must have made versions 1, 2, ...
+        long writes = 0;
+        while (first + writes < end && h[first + writes].op == OP_WRITE) writes++;
+        long long *starts = calloc(writes + 2, sizeof(long long));
+        long long *ends = calloc(writes + 2, sizeof(long long));
+        for (long k = 1; k <= writes; k++) {
+            HistoryEntry *wr = &h[first + k - 1];
+            if (wr->version != k) {
+                violation("page %d: version %lld written where %ld was due", page, wr->version, k);
+                bad++;
+            }
+            starts[k] = wr->start;
+            ends[k] = wr->end;
+        }
+        for (long i = first; i < end; i++) {
+            if (h[i].op != OP_READ) continue;
+            long long rv = h[i].version;
+            if (rv < 0 || rv > writes) {
+                violation("page %d: read returned version %lld of %lld written", page, rv, writes);
+                bad++;
+            } else if (rv > 0 && h[i].end < starts[rv]) {
+                violation("page %d: read of version %lld ended before its write started", page, rv);
+                bad++;
+            } else if (rv < writes && h[i].start > ends[rv + 1]) {
+                violation("page %d: stale read of version %lld after version %lld was written", page, rv, rv + 1);
+                bad++;
+            }
+        }
+        free(starts);
+        free(ends);
+        first = end;
+    }
+    return bad;
+}
+
+static void writeHistory(const char *path, Worker *workers) {
+    FILE *out = fopen(path, "w");
+    if (!out) {
+        fprintf(stderr, "cannot write %s\n", path);
+        return;
+    }
+    fprintf(out, "# start end thread op page version rc\n");
+    for (int t = 0; t < cfg.threads; t++)
+        for (long i = 0; i < workers[t].numHistory; i++) {
+            HistoryEntry *e = &workers[t].history[i];
+            fprintf(out, "%lld %lld %d %c %d %lld %d\n", e->start, e->end, e->thread, e->op,
+                    e->page, e->version, e->rc);
+        }
+    fclose(out);
+}
+
+// -c: check a history written with -o
+static int checkHistoryFile(const char *path) {
+    FILE *in = fopen(path, "r");
+    if (!in) {
+        fprintf(stderr, "cannot open %s\n", path);
+        return 1;
+    }
+    HistoryEntry *h = NULL;
+    long n = 0, max = 0;
+    char line[256];
+    while (fgets(line, sizeof(line), in)) {
+        if (line[0] == '#') continue;
+        if (n == max) {
+            max = max ? 2 * max : 4096;
+            h = realloc(h, sizeof(HistoryEntry) * max);
+        }
+        HistoryEntry *e = &h[n];
+        if (sscanf(line, "%lld %lld %d %c %d %lld %d", &e->start, &e->end, &e->thread,
+                   &e->op, &e->page, &e->version, &e->rc) == 7) n++;
+    }
+    fclose(in);
+    long bad = checkHistory(h, n);
+    printf("entries=%ld violations=%ld\n", n, bad);
+    free(h);
+    return bad ? 1 : 0;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "usage: %s [-t threads] [-p poolPages] [-f filePages] [-n opsPerRound] [-R rounds]\n"
+            "          [-h maxHeldPins] [-s fifo|lru|clock|lfu|lru_k] [-i ioWorkers]\n"
+            "          [-w freeLowWatermark] [-C writeCoalesceWindow] [-N numaNodes]\n"
+            "          [-y yieldPercent] [-r seed] [-F pageFile] [-o history]\n"
+            "       %s -c history\n"
+            "  -o writes every call as an interval; -c checks such a file offline\n"
+            "  exits with 1 when an invariant was violated\n", prog, prog);
+}
+
+int main(int argc, char **argv) {
+    StressConfig defaults = { 4, 16, 64, 20000, 5, 2, RS_LRU, 0, 0, 0, 0, 1, 42, "stress.bin" };
+    const char *historyOut = NULL;
+    int opt;
+    cfg = defaults;
+    while ((opt = getopt(argc, argv, "t:p:f:n:R:h:s:i:w:C:N:y:r:F:o:c:")) != -1) {
+        switch (opt) {
+        case 't': cfg.threads = atoi(optarg); break;
+        case 'p': cfg.poolPages = atoi(optarg); break;
+        case 'f': cfg.filePages = atoi(optarg); break;
+        case 'n': cfg.opsPerRound = atol(optarg); break;
+        case 'R': cfg.rounds = atoi(optarg); break;
+        case 'h': cfg.maxHeld = atoi(optarg); break;
+        case 's': {
+            int s;
+            for (s = 0; s < 5 && strcmp(optarg, strategyNames[s]) != 0; s++) ;
+            if (s == 5) { usage(argv[0]); return 1; }
+            cfg.strat = (ReplacementStrategy) s;
+            break;
+        }
+        case 'i': cfg.ioWorkers = atoi(optarg); break;
+        case 'w': cfg.freeLow = atoi(optarg); break;
+        case 'C': cfg.coalesce = atoi(optarg); break;
+        case 'N': cfg.numaNodes = atoi(optarg); break;
+        case 'y': cfg.yieldPercent = atoi(optarg); break;
+        case 'r': cfg.seed = strtoull(optarg, NULL, 10); break;
+        case 'F': cfg.fileName = optarg; break;
+        case 'o': historyOut = optarg; break;
+        case 'c': return checkHistoryFile(optarg);
+        default: usage(argv[0]); return 1;
+        }
+    }
+    // a pin may only fail when every frame is pinned, which must not happen
+    if (cfg.threads < 1 || cfg.filePages < 1 || cfg.rounds < 1 || cfg.maxHeld < 1
+        || cfg.maxHeld > MAX_HELD || cfg.poolPages <= cfg.threads * cfg.maxHeld) {
+        usage(argv[0]);
+        fprintf(stderr, "poolPages must exceed threads * maxHeldPins\n");
+        return 1;
+    }
+
+    // every page starts at version 0
+    initStorageManager();
+    SM_FileHandle fh;
+    char *page = malloc(PAGE_SIZE);
+    RC rc = createPageFile((char *) cfg.fileName);
+    if (rc == RC_OK) rc = openPageFile((char *) cfg.fileName, &fh);
+    if (rc == RC_OK) {
+        rc = ensureCapacity(cfg.filePages, &fh);
+        for (int p = 0; p < cfg.filePages && rc == RC_OK; p++) {
+            fillPage(page, p, 0);
+            rc = writeBlock(p, &fh, page);
+        }
+        closePageFile(&fh);
+    }
+    free(page);
+    diskFd = open(cfg.fileName, O_RDONLY);
+    if (rc != RC_OK || diskFd < 0) {
+        fprintf(stderr, "cannot create %s\n", cfg.fileName);
+        return 1;
+    }
+    shadow = calloc(cfg.filePages, sizeof(ShadowPage));
+    for (int p = 0; p < cfg.filePages; p++) {
+        pthread_rwlock_init(&shadow[p].latch, NULL);
+        pthread_mutex_init(&shadow[p].lock, NULL);
+    }
+
+    BM_PoolConfig poolCfg;
+    initPoolConfig(&poolCfg);
+    poolCfg.ioWorkers = cfg.ioWorkers;
+    poolCfg.freeLowWatermark = cfg.freeLow;
+    poolCfg.freeHighWatermark = 2 * cfg.freeLow;
+    poolCfg.writeCoalesceWindow = cfg.coalesce;
+    poolCfg.numaNodes = cfg.numaNodes;
+    if (initBufferPoolWithConfig(&pool, cfg.fileName, cfg.poolPages, cfg.strat, NULL, &poolCfg) != RC_OK) {
+        fprintf(stderr, "cannot open the buffer pool\n");
+        return 1;
+    }
+
+    Worker *workers = calloc(cfg.threads, sizeof(Worker));
+    pthread_barrier_init(&roundStart, NULL, cfg.threads + 1);
+    pthread_barrier_init(&roundEnd, NULL, cfg.threads + 1);
+    for (int t = 0; t < cfg.threads; t++) {
+        workers[t].id = t;
+        workers[t].rng = (cfg.seed + 1) * 0x9E3779B97F4A7C15ULL + (unsigned long long) (t + 1) * 7919;
+        pthread_create(&workers[t].thread, NULL, workerMain, &workers[t]);
+    }
+    long long start = nowNanos();
+    for (int round = 0; round < cfg.rounds; round++) {
+        pthread_barrier_wait(&roundStart);
+        pthread_barrier_wait(&roundEnd);
+        checkQuiescent();
+    }
+    pthread_barrier_wait(&roundStart);
+    for (int t = 0; t < cfg.threads; t++) pthread_join(workers[t].thread, NULL);
+    double seconds = (nowNanos() - start) / 1e9;
+
+    // with every pin released nothing may be lost by the shutdown
+    int *fix = getFixCounts(&pool);
+    for (int i = 0; i < pool.numPages; i++)
+        if (fix[i] != 0) violation("frame %d has fix count %d after every unpin", i, fix[i]);
+    free(fix);
+    int readIO = getNumReadIO(&pool);
+    int writeIO = getNumWriteIO(&pool);
+    shutdownBufferPool(&pool);
+    for (int p = 0; p < cfg.filePages; p++) {
+        long long v = diskVersion(p);
+        if (v != shadow[p].version)
+            violation("page %d after shutdown has version %lld, expected %lld", p, v, shadow[p].version);
+    }
+    close(diskFd);
+
+    long ops = 0, n = 0;
+    for (int t = 0; t < cfg.threads; t++) {
+        ops += workers[t].ops;
+        n += workers[t].numHistory;
+    }
+    if (historyOut) writeHistory(historyOut, workers);
+    HistoryEntry *all = malloc(sizeof(HistoryEntry) * (n ? n : 1));
+    n = 0;
+    for (int t = 0; t < cfg.threads; t++) {
+        memcpy(all + n, workers[t].history, sizeof(HistoryEntry) * workers[t].numHistory);
+        n += workers[t].numHistory;
+        free(workers[t].history);
+    }
+    checkHistory(all, n);
+    free(all);
+
+    printf("strategy=%s threads=%d poolPages=%d filePages=%d rounds=%d ops=%ld seconds=%.3f "
+           "readIO=%d writeIO=%d violations=%ld\n",
+           strategyNames[cfg.strat], cfg.threads, cfg.poolPages, cfg.filePages, cfg.rounds, ops,
+           seconds, readIO, writeIO, violations);
+    for (int p = 0; p < cfg.filePages; p++) {
+        pthread_rwlock_destroy(&shadow[p].latch);
+        pthread_mutex_destroy(&shadow[p].lock);
+    }
+    free(shadow);
+    free(workers);
+    pthread_barrier_destroy(&roundStart);
+    pthread_barrier_destroy(&roundEnd);
+    destroyPageFile((char *) cfg.fileName);
+    return violations ? 1 : 0;
+}
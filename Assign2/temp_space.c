@@ -0,0 +1,231 @@
+// dirent, getpid and strdup are POSIX, not plain C99
+#define _POSIX_C_SOURCE 200809L
+
+#include "temp_space.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <dirent.h>
+#include <unistd.h>
+
+#define SPILL_PREFIX "bm_spill."
+
+// TEMP_EXTENT_PAGES pages either in memory or in the spill file
+typedef struct TempExtent {
+    char *mem;             // RAM-staged extent, NULL for a disk extent
+    int firstPage;         // first spill-file page of a disk extent
+    struct TempExtent *next; // free list link
+} TempExtent;
+
+// Bookkeeping of a temp space
+typedef struct TempSpaceInfo {
+    pthread_mutex_t lock;  // extents, free lists and the spill file
+    SM_FileHandle fh;
+    char *fileName;        // spill file, NULL until the first disk extent
+    int removed;           // the name is already gone (deleted while open)
+    int diskPages;         // spill-file pages given to extents so far
+    TempExtent *freeRam, *freeDisk;
+    TS_TempStats stats;
+} TempSpaceInfo;
+
+// Extent table of a temp file
+typedef struct TempFileInfo {
+    TempExtent **extents;
+    int numExtents, maxExtents;
+} TempFileInfo;
+
+// Remove spill files left behind by earlier runs. Files of live spaces are
+// either already unlinked or, where open files can't be deleted, refuse it.
+static void removeLeftovers(const char *dir) {
+    DIR *d = opendir(dir);
+    if (!d) return;
+    struct dirent *e;
+    char path[4096];
+    while ((e = readdir(d)) != NULL) {
+        if (strncmp(e->d_name, SPILL_PREFIX, strlen(SPILL_PREFIX)) != 0) continue;
+        snprintf(path, sizeof(path), "%s/%s", dir, e->d_name);
+        remove(path);
+    }
+    closedir(d);
+}
+
+// Create the spill file with flushing off and delete its name right away,
+// so it vanishes with the process even after a crash (lock held)
+static RC openSpillFile(TS_TempSpace *space, TempSpaceInfo *info) {
+    static int seq = 0;
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/%s%ld.%d", space->dir, SPILL_PREFIX,
+             (long) getpid(), __atomic_fetch_add(&seq, 1, __ATOMIC_RELAXED));
+    RC rc = createPageFile(path);
+    if (rc == RC_OK) rc = openPageFile(path, &info->fh);
+    if (rc != RC_OK) {
+        remove(path);
+        return rc;
+    }
+    setPageFileFlush(&info->fh, 0);
+    info->fileName = strdup(path);
+    info->removed = remove(path) == 0;
+    return RC_OK;
+}
+
+// Take an extent: a free one (RAM first), a new RAM one while the budget
+// lasts, else a new disk extent at the end of the spill file (lock held)
+static TempExtent *takeExtent(TS_TempSpace *space, TempSpaceInfo *info) {
+    TempExtent *e = info->freeRam ? info->freeRam : info->freeDisk;
+    if (e) {
+        if (e == info->freeRam) info->freeRam = e->next;
+        else info->freeDisk = e->next;
+        info->stats.extentsReused++;
+        return e;
+    }
+    e = malloc(sizeof(TempExtent));
+    if (!e) return NULL;
+    e->mem = NULL;
+    if (info->stats.ramPages + TEMP_EXTENT_PAGES <= space->ramPages)
+        e->mem = malloc((size_t) TEMP_EXTENT_PAGES * PAGE_SIZE);
+    if (e->mem) {
+        info->stats.ramPages += TEMP_EXTENT_PAGES;
+        return e;
+    }
+    if (!info->fileName && openSpillFile(space, info) != RC_OK) {
+        free(e);
+        return NULL;
+    }
+    e->firstPage = info->diskPages;
+    info->diskPages += TEMP_EXTENT_PAGES;
+    info->stats.diskPages = info->diskPages;
+    return e;
+}
+
+RC openTempSpace(TS_TempSpace *space, const char *dir, int ramPages) {
+    TempSpaceInfo *info = calloc(1, sizeof(TempSpaceInfo));
+    if (!info) THROW(RC_BM_OUT_OF_MEMORY, "openTempSpace: allocation failed");
+    space->dir = strdup(dir ? dir : ".");
+    space->ramPages = ramPages > 0 ? ramPages : 0;
+    pthread_mutex_init(&info->lock, NULL);
+    space->mgmtInfo = info;
+    removeLeftovers(space->dir);
+    return RC_OK;
+}
+
+RC closeTempSpace(TS_TempSpace *space) {
+    TempSpaceInfo *info = space->mgmtInfo;
+    if (!info) return RC_FILE_HANDLE_NOT_INIT;
+    TempExtent *lists[2] = { info->freeRam, info->freeDisk };
+    for (int l = 0; l < 2; l++) {
+        while (lists[l]) {
+            TempExtent *next = lists[l]->next;
+            free(lists[l]->mem);
+            free(lists[l]);
+            lists[l] = next;
+        }
+    }
+    if (info->fileName) {
+        closePageFile(&info->fh);
+        if (!info->removed) remove(info->fileName);
+        free(info->fileName);
+    }
+    pthread_mutex_destroy(&info->lock);
+    free(info);
+    free(space->dir);
+    space->mgmtInfo = NULL;
+    return RC_OK;
+}
+
+RC getTempSpaceStats(TS_TempSpace *space, TS_TempStats *stats) {
+    TempSpaceInfo *info = space->mgmtInfo;
+    if (!info) return RC_FILE_HANDLE_NOT_INIT;
+    pthread_mutex_lock(&info->lock);
+    *stats = info->stats;
+    pthread_mutex_unlock(&info->lock);
+    return RC_OK;
+}
+
+RC createTempFile(TS_TempSpace *space, TS_TempFile *file) {
+    if (!space->mgmtInfo) return RC_FILE_HANDLE_NOT_INIT;
+    TempFileInfo *tf = calloc(1, sizeof(TempFileInfo));
+    if (!tf) THROW(RC_BM_OUT_OF_MEMORY, "createTempFile: allocation failed");
+    file->space = space;
+    file->numPages = 0;
+    file->mgmtInfo = tf;
+    return RC_OK;
+}
+
+RC writeTempPage(TS_TempFile *file, int pageNum, SM_PageHandle memPage) {
+    TempFileInfo *tf = file->mgmtInfo;
+    if (!tf) return RC_FILE_HANDLE_NOT_INIT;
+    if (pageNum < 0) return RC_WRITE_FAILED;
+    TempSpaceInfo *info = file->space->mgmtInfo;
+    int ext = pageNum / TEMP_EXTENT_PAGES;
+    RC rc = RC_OK;
+    pthread_mutex_lock(&info->lock);
+    if (ext >= tf->maxExtents) {
+        int max = tf->maxExtents ? tf->maxExtents : 4;
+        while (max <= ext) max *= 2;
+        tf->extents = realloc(tf->extents, sizeof(TempExtent *) * max);
+        tf->maxExtents = max;
+    }
+    while (tf->numExtents <= ext) {
+        TempExtent *e = takeExtent(file->space, info);
+        if (!e) {
+            pthread_mutex_unlock(&info->lock);
+            THROW(RC_WRITE_FAILED, "writeTempPage: no extent");
+        }
+        tf->extents[tf->numExtents++] = e;
+    }
+    TempExtent *e = tf->extents[ext];
+    int off = pageNum % TEMP_EXTENT_PAGES;
+    if (e->mem) {
+        memcpy(e->mem + (size_t) off * PAGE_SIZE, memPage, PAGE_SIZE);
+    } else {
+        rc = writeBlock(e->firstPage + off, &info->fh, memPage);
+        info->stats.pageWrites++;
+    }
+    pthread_mutex_unlock(&info->lock);
+    if (rc == RC_OK && pageNum >= file->numPages) file->numPages = pageNum + 1;
+    return rc;
+}
+
+RC readTempPage(TS_TempFile *file, int pageNum, SM_PageHandle memPage) {
+    TempFileInfo *tf = file->mgmtInfo;
+    if (!tf) return RC_FILE_HANDLE_NOT_INIT;
+    if (pageNum < 0 || pageNum >= file->numPages) return RC_READ_NON_EXISTING_PAGE;
+    TempSpaceInfo *info = file->space->mgmtInfo;
+    TempExtent *e = tf->extents[pageNum / TEMP_EXTENT_PAGES];
+    int off = pageNum % TEMP_EXTENT_PAGES;
+    if (e->mem) {
+        memcpy(memPage, e->mem + (size_t) off * PAGE_SIZE, PAGE_SIZE);
+        return RC_OK;
+    }
+    RC rc = RC_OK;
+    pthread_mutex_lock(&info->lock);
+    // a gap past the end of the spill file was never written
+    if (e->firstPage + off >= info->fh.totalNumPages) {
+        memset(memPage, 0, PAGE_SIZE);
+    } else {
+        rc = readBlock(e->firstPage + off, &info->fh, memPage);
+        info->stats.pageReads++;
+    }
+    pthread_mutex_unlock(&info->lock);
+    return rc;
+}
+
+RC closeTempFile(TS_TempFile *file) {
+    TempFileInfo *tf = file->mgmtInfo;
+    if (!tf) return RC_FILE_HANDLE_NOT_INIT;
+    TempSpaceInfo *info = file->space->mgmtInfo;
+    pthread_mutex_lock(&info->lock);
+    for (int i = 0; i < tf->numExtents; i++) {
+        TempExtent *e = tf->extents[i];
+        TempExtent **list = e->mem ? &info->freeRam : &info->freeDisk;
+        e->next = *list;
+        *list = e;
+    }
+    pthread_mutex_unlock(&info->lock);
+    free(tf->extents);
+    free(tf);
+    file->mgmtInfo = NULL;
+    return RC_OK;
+}
@@ -0,0 +1,50 @@
+#ifndef TEMP_SPACE_H
+#define TEMP_SPACE_H
+
+#include "dberror.h"
+#include "storage_mgr.h"
+
+// Pages a temp file grows by; freed extents are reused by later temp files
+#define TEMP_EXTENT_PAGES 8
+
+// Scratch space for operator spills (sorts, hash joins). Nothing in it is
+// durable: writes are never flushed, the spill file is deleted while open
+// (or at close where the OS refuses that) and leftovers of earlier runs
+// are removed by openTempSpace.
+typedef struct TS_TempSpace {
+	char *dir;     // directory of the spill file
+	int ramPages;  // pages staged in memory before the spill file is used
+	void *mgmtInfo;
+} TS_TempSpace;
+
+// Anonymous page file inside a temp space
+typedef struct TS_TempFile {
+	TS_TempSpace *space;
+	int numPages;  // one past the highest page written
+	void *mgmtInfo;
+} TS_TempFile;
+
+// Counters reported by getTempSpaceStats
+typedef struct TS_TempStats {
+	int ramPages;        // pages of RAM extents handed out so far
+	int diskPages;       // pages of the spill file handed out so far
+	int extentsReused;   // extents taken from the free lists
+	int pageWrites;      // pages written to the spill file
+	int pageReads;       // pages read from the spill file
+} TS_TempStats;
+
+// Temp space in dir (NULL = the current directory) that keeps up to
+// ramPages pages in memory before spilling to disk
+RC openTempSpace (TS_TempSpace *const space, const char *dir, int ramPages);
+// Close a temp space; all its temp files must be closed first
+RC closeTempSpace (TS_TempSpace *const space);
+RC getTempSpaceStats (TS_TempSpace *const space, TS_TempStats *const stats);
+
+RC createTempFile (TS_TempSpace *const space, TS_TempFile *const file);
+RC writeTempPage (TS_TempFile *const file, int pageNum, SM_PageHandle memPage);
+// Pages below numPages that were never written read as garbage
+RC readTempPage (TS_TempFile *const file, int pageNum, SM_PageHandle memPage);
+// Close a temp file; its extents go back to the temp space for reuse
+RC closeTempFile (TS_TempFile *const file);
+
+#endif
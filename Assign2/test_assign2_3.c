@@ -0,0 +1,1681 @@
+// rand_r and pthreads are POSIX, not plain C99
+#define _POSIX_C_SOURCE 200809L
+
+#include "storage_mgr.h"
+#include "buffer_mgr_stat.h"
+#include "buffer_mgr.h"
+#include "dberror.h"
+#include "temp_space.h"
+#include "stats_export.h"
+#include "bm_trace.h"
+#include "test_helper.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// var to store the current test's name
+char *testName;
+
+// check whether two the content of a buffer pool is the same as an expected content
+// (given in the format produced by sprintPoolContent)
+#define ASSERT_EQUALS_POOL(expected,bm,message)                    \
+do {                                    \
+char *real;                                \
+char *_exp = (char *) (expected);                                   \
+real = sprintPoolContent(bm);                    \
+if (strcmp((_exp),real) != 0)                    \
+{                                    \
+printf("[%s-%s-L%i-%s] FAILED: expected <%s> but was <%s>: %s\n",TEST_INFO, _exp, real, message); \
+free(real);                            \
+exit(1);                            \
+}                                    \
+printf("[%s-%s-L%i-%s] OK: expected <%s> and was <%s>: %s\n",TEST_INFO, _exp, real, message); \
+free(real);                                \
+} while(0)
+
+#define NUM_THREADS 4
+#define NUM_THREAD_PINS 2000
+
+// test and helper methods
+static void createDummyPages(BM_BufferPool *bm, int num);
+
+static void testCLOCK (void);
+static void testConcurrentPins (void);
+static void testSwizzling (void);
+static void testAsyncPin (void);
+static void testIOWorkers (void);
+static void testBackgroundEvictor (void);
+static void testNumaPartitions (void);
+static void testResizePool (void);
+static void testCgroupSizing (void);
+static void testPagePriorities (void);
+static void testClientQuotas (void);
+static void testWriteCoalescing (void);
+static void testFailedWriteBack (void);
+static void testExtentPins (void);
+static void testTempSpace (void);
+static void testStatsExport (void);
+static void testPoolInspection (void);
+static void testApiTrace (void);
+static void testHitRatioCurve (void);
+static void testLogStructuredFile (void);
+static void testShadowPaging (void);
+
+// main method
+int
+main (void)
+{
+    initStorageManager();
+    testName = "";
+
+    testCLOCK();
+    testConcurrentPins();
+    testSwizzling();
+    testAsyncPin();
+    testIOWorkers();
+    testBackgroundEvictor();
+    testNumaPartitions();
+    testResizePool();
+    testCgroupSizing();
+    testPagePriorities();
+    testClientQuotas();
+    testWriteCoalescing();
+    testFailedWriteBack();
+    testExtentPins();
+    testTempSpace();
+    testStatsExport();
+    testPoolInspection();
+    testApiTrace();
+    testHitRatioCurve();
+    testLogStructuredFile();
+    testShadowPaging();
+    return 0;
+}
+
+
+void
+createDummyPages(BM_BufferPool *bm, int num)
+{
+    int i;
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+
+    CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_FIFO, NULL));
+
+    for (i = 0; i < num; i++)
+    {
+        CHECK(pinPage(bm, h, i));
+        sprintf(h->data, "%s-%i", "Page", h->pageNum);
+        CHECK(markDirty(bm, h));
+        CHECK(unpinPage(bm,h));
+    }
+
+    CHECK(shutdownBufferPool(bm));
+
+    free(h);
+}
+
+// test the CLOCK page replacement strategy
+void
+testCLOCK (void)
+{
+    // expected results
+    const char *poolContents[] = {
+        "[0 0],[-1 0],[-1 0]",
+        "[0 0],[1 0],[-1 0]",
+        "[0 0],[1 0],[2 0]",
+        // first sweep clears every reference bit and takes frame 0
+        "[3 0],[1 0],[2 0]",
+        // hit on page 1 sets its reference bit again
+        "[3 0],[1 0],[2 0]",
+        "[3 0],[1 0],[4 0]",
+        "[3 0],[5 0],[4 0]",
+        "[6 0],[5 0],[4 0]"
+    };
+    const int requests[] = {0,1,2,3,1,4,5,6};
+    const int numRequests = 8;
+
+    int i;
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    testName = "Testing CLOCK page replacement";
+
+    CHECK(createPageFile("testbuffer.bin"));
+    createDummyPages(bm, 100);
+    CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_CLOCK, NULL));
+
+    for (i = 0; i < numRequests; i++)
+    {
+        pinPage(bm, h, requests[i]);
+        unpinPage(bm, h);
+        ASSERT_EQUALS_POOL(poolContents[i], bm, "check pool content");
+    }
+
+    ASSERT_EQUALS_INT(0, getNumWriteIO(bm), "check number of write I/Os");
+    ASSERT_EQUALS_INT(7, getNumReadIO(bm), "check number of read I/Os");
+
+    CHECK(shutdownBufferPool(bm));
+    CHECK(destroyPageFile("testbuffer.bin"));
+
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
+
+// each thread pins pages from a small hot set and checks their content
+static void *
+pinWorker (void *arg)
+{
+    BM_BufferPool *bm = (BM_BufferPool *) arg;
+    BM_PageHandle h;
+    char expected[64];
+    unsigned seed = (unsigned) (size_t) &h;
+    long errors = 0;
+    int i;
+
+    for (i = 0; i < NUM_THREAD_PINS; i++)
+    {
+        int page = rand_r(&seed) % 8;
+        if (pinPage(bm, &h, page) != RC_OK)
+            continue;
+        sprintf(expected, "%s-%i", "Page", page);
+        if (h.pageNum != page || strcmp(expected, h.data) != 0)
+            errors++;
+        if (unpinPage(bm, &h) != RC_OK)
+            errors++;
+    }
+    return (void *) errors;
+}
+
+// concurrent CLOCK pins never see the wrong page and leave no pins behind
+void
+testConcurrentPins (void)
+{
+    pthread_t threads[NUM_THREADS];
+    BM_BufferPool *bm = MAKE_POOL();
+    long errors = 0;
+    int *fixCounts;
+    int i;
+    testName = "Concurrent CLOCK pins";
+
+    CHECK(createPageFile("testbuffer.bin"));
+    createDummyPages(bm, 8);
+    CHECK(initBufferPool(bm, "testbuffer.bin", 6, RS_CLOCK, NULL));
+
+    for (i = 0; i < NUM_THREADS; i++)
+        pthread_create(&threads[i], NULL, pinWorker, bm);
+    for (i = 0; i < NUM_THREADS; i++)
+    {
+        void *res;
+        pthread_join(threads[i], &res);
+        errors += (long) res;
+    }
+    ASSERT_EQUALS_INT(0, (int) errors, "no thread saw a wrong page");
+
+    fixCounts = getFixCounts(bm);
+    for (i = 0; i < 6; i++)
+        ASSERT_EQUALS_INT(0, fixCounts[i], "all pins released");
+    free(fixCounts);
+
+    CHECK(shutdownBufferPool(bm));
+    CHECK(destroyPageFile("testbuffer.bin"));
+
+    free(bm);
+    TEST_DONE();
+}
+
+// swizzled references pin without the page table and survive eviction
+void
+testSwizzling (void)
+{
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    BM_Swip swip;
+    int i;
+    testName = "Swizzled page references";
+
+    CHECK(createPageFile("testbuffer.bin"));
+    createDummyPages(bm, 10);
+    CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_FIFO, NULL));
+
+    initSwip(&swip, 7);
+    ASSERT_EQUALS_INT(7, getSwipPage(bm, &swip), "unswizzled swip holds the page number");
+
+    // first pin loads and swizzles, the second one is a direct hit
+    CHECK(pinSwip(bm, &swip, h));
+    ASSERT_EQUALS_STRING("Page-7", h->data, "pinned through an unswizzled swip");
+    CHECK(unpinSwip(bm, &swip));
+    CHECK(pinSwip(bm, &swip, h));
+    ASSERT_EQUALS_INT(7, h->pageNum, "pinned through a swizzled swip");
+    ASSERT_EQUALS_INT(7, getSwipPage(bm, &swip), "swizzled swip still knows its page");
+    CHECK(unpinSwip(bm, &swip));
+    ASSERT_EQUALS_INT(1, getNumReadIO(bm), "swizzled pin did not read");
+
+    // push page 7 out of the pool; the swip must fall back to its page number
+    for (i = 0; i < 3; i++)
+    {
+        CHECK(pinPage(bm, h, i));
+        CHECK(unpinPage(bm, h));
+    }
+    ASSERT_EQUALS_POOL("[2 0],[0 0],[1 0]", bm, "swizzled page was evicted");
+    ASSERT_EQUALS_INT(7, getSwipPage(bm, &swip), "eviction unswizzled the swip");
+
+    CHECK(pinSwip(bm, &swip, h));
+    ASSERT_EQUALS_STRING("Page-7", h->data, "swip reloads the page after eviction");
+    CHECK(unpinSwip(bm, &swip));
+    ASSERT_EQUALS_INT(5, getNumReadIO(bm), "check number of read I/Os");
+
+    CHECK(releaseSwip(bm, &swip));
+    CHECK(shutdownBufferPool(bm));
+    CHECK(destroyPageFile("testbuffer.bin"));
+
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
+
+// completion state shared with the async pin callback
+typedef struct AsyncResult {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int done;
+    RC rc;
+} AsyncResult;
+
+static void
+asyncDone (BM_BufferPool *bm, BM_PageHandle *page, RC rc, void *ctx)
+{
+    AsyncResult *res = (AsyncResult *) ctx;
+    pthread_mutex_lock(&res->lock);
+    res->rc = rc;
+    res->done = 1;
+    pthread_cond_signal(&res->cond);
+    pthread_mutex_unlock(&res->lock);
+}
+
+// a callback that pins another page itself, waiting for its miss
+static void
+asyncPinAgain (BM_BufferPool *bm, BM_PageHandle *page, RC rc, void *ctx)
+{
+    AsyncResult *res = (AsyncResult *) ctx;
+    BM_PageHandle other;
+    if (rc == RC_OK)
+    {
+        rc = pinPage(bm, &other, 7);
+        if (rc == RC_OK)
+            rc = unpinPage(bm, &other);
+    }
+    asyncDone(bm, page, rc, res);
+}
+
+// misses complete through the callback, hits return right away
+void
+testAsyncPin (void)
+{
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    AsyncResult res;
+    RC rc;
+    testName = "Asynchronous pins";
+
+    pthread_mutex_init(&res.lock, NULL);
+    pthread_cond_init(&res.cond, NULL);
+    res.done = 0;
+
+    CHECK(createPageFile("testbuffer.bin"));
+    createDummyPages(bm, 8);
+    CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_CLOCK, NULL));
+
+    rc = pinPageAsync(bm, h, 4, asyncDone, &res);
+    ASSERT_EQUALS_INT(RC_BM_PIN_PENDING, rc, "miss is queued");
+    pthread_mutex_lock(&res.lock);
+    while (!res.done)
+        pthread_cond_wait(&res.cond, &res.lock);
+    pthread_mutex_unlock(&res.lock);
+    ASSERT_EQUALS_INT(RC_OK, res.rc, "queued pin succeeded");
+    ASSERT_EQUALS_STRING("Page-4", h->data, "queued pin loaded the page");
+    CHECK(unpinPage(bm, h));
+
+    res.done = 0;
+    rc = pinPageAsync(bm, h, 4, asyncDone, &res);
+    ASSERT_EQUALS_INT(RC_OK, rc, "hit returns immediately");
+    ASSERT_EQUALS_INT(0, res.done, "hit does not call back");
+    CHECK(unpinPage(bm, h));
+    ASSERT_EQUALS_INT(1, getNumReadIO(bm), "check number of read I/Os");
+    CHECK(shutdownBufferPool(bm));
+
+    // a callback may wait for a miss of its own: it does not run on the
+    // worker that has to load the page
+    CHECK(initBufferPool(bm, "testbuffer.bin", 4, RS_CLOCK, NULL));
+    res.done = 0;
+    rc = pinPageAsync(bm, h, 3, asyncPinAgain, &res);
+    ASSERT_EQUALS_INT(RC_BM_PIN_PENDING, rc, "miss is queued");
+    pthread_mutex_lock(&res.lock);
+    while (!res.done)
+        pthread_cond_wait(&res.cond, &res.lock);
+    pthread_mutex_unlock(&res.lock);
+    ASSERT_EQUALS_INT(RC_OK, res.rc, "pin from the callback succeeded");
+    CHECK(unpinPage(bm, h));
+    ASSERT_EQUALS_INT(2, getNumReadIO(bm), "check number of read I/Os");
+
+    CHECK(shutdownBufferPool(bm));
+    CHECK(destroyPageFile("testbuffer.bin"));
+
+    pthread_mutex_destroy(&res.lock);
+    pthread_cond_destroy(&res.cond);
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
+
+// every thread pins the same four pages once and checks their content
+static void *
+samePagesWorker (void *arg)
+{
+    BM_BufferPool *bm = (BM_BufferPool *) arg;
+    BM_PageHandle h;
+    char expected[64];
+    long errors = 0;
+    int page;
+
+    for (page = 0; page < 4; page++)
+    {
+        if (pinPage(bm, &h, page) != RC_OK)
+        {
+            errors++;
+            continue;
+        }
+        sprintf(expected, "%s-%i", "Page", page);
+        if (strcmp(expected, h.data) != 0)
+            errors++;
+        if (unpinPage(bm, &h) != RC_OK)
+            errors++;
+    }
+    return (void *) errors;
+}
+
+// concurrent misses on one page are served by a single read
+void
+testIOWorkers (void)
+{
+    pthread_t threads[NUM_THREADS];
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PoolConfig cfg;
+    long errors = 0;
+    int i;
+    testName = "I/O workers combine misses";
+
+    CHECK(createPageFile("testbuffer.bin"));
+    createDummyPages(bm, 4);
+
+    initPoolConfig(&cfg);
+    cfg.ioWorkers = 2;
+    CHECK(initBufferPoolWithConfig(bm, "testbuffer.bin", 4, RS_CLOCK, NULL, &cfg));
+
+    for (i = 0; i < NUM_THREADS; i++)
+        pthread_create(&threads[i], NULL, samePagesWorker, bm);
+    for (i = 0; i < NUM_THREADS; i++)
+    {
+        void *res;
+        pthread_join(threads[i], &res);
+        errors += (long) res;
+    }
+    ASSERT_EQUALS_INT(0, (int) errors, "every pin saw its page");
+    ASSERT_EQUALS_INT(4, getNumReadIO(bm), "one read per page");
+
+    CHECK(shutdownBufferPool(bm));
+    CHECK(destroyPageFile("testbuffer.bin"));
+
+    free(bm);
+    TEST_DONE();
+}
+
+// wait up to a second for the evictor to bring the pool to freeFrames
+static int
+waitForFreeFrames (BM_BufferPool *bm, int freeFrames)
+{
+    struct timespec pause = {0, 1000000};
+    BM_PoolStats stats;
+    int i;
+
+    for (i = 0; i < 1000; i++)
+    {
+        CHECK(getPoolStats(bm, &stats));
+        if (stats.freeFrames >= freeFrames)
+            break;
+        nanosleep(&pause, NULL);
+    }
+    return stats.freeFrames;
+}
+
+// the evictor keeps free frames between the watermarks so misses skip selectVictim
+void
+testBackgroundEvictor (void)
+{
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    BM_PoolConfig cfg;
+    BM_PoolStats stats;
+    int i;
+    testName = "Background evictor";
+
+    CHECK(createPageFile("testbuffer.bin"));
+    createDummyPages(bm, 10);
+
+    initPoolConfig(&cfg);
+    cfg.freeLowWatermark = 1;
+    cfg.freeHighWatermark = 2;
+    CHECK(initBufferPoolWithConfig(bm, "testbuffer.bin", 4, RS_CLOCK, NULL, &cfg));
+
+    // filling the pool drops below the low watermark; dirty pages get written back
+    for (i = 0; i < 4; i++)
+    {
+        CHECK(pinPage(bm, h, i));
+        CHECK(markDirty(bm, h));
+        CHECK(unpinPage(bm, h));
+    }
+    ASSERT_EQUALS_INT(2, waitForFreeFrames(bm, 2), "evictor refilled to the high watermark");
+
+    CHECK(pinPage(bm, h, 8));
+    ASSERT_EQUALS_STRING("Page-8", h->data, "miss served from a free frame");
+    CHECK(unpinPage(bm, h));
+
+    CHECK(getPoolStats(bm, &stats));
+    ASSERT_EQUALS_INT(0, (int) stats.fgEvictions, "no inline eviction");
+    ASSERT_TRUE(stats.bgEvictions >= 2, "evictor did the evictions");
+    ASSERT_TRUE(stats.numWriteIO >= 2, "evicted dirty pages were written back");
+
+    CHECK(shutdownBufferPool(bm));
+
+    // evicted pages made it to disk
+    CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_FIFO, NULL));
+    for (i = 0; i < 4; i++)
+    {
+        char expected[64];
+        CHECK(pinPage(bm, h, i));
+        sprintf(expected, "%s-%i", "Page", i);
+        ASSERT_EQUALS_STRING(expected, h->data, "page survived background write-back");
+        CHECK(unpinPage(bm, h));
+    }
+    CHECK(shutdownBufferPool(bm));
+    CHECK(destroyPageFile("testbuffer.bin"));
+
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
+
+// frames are split into per-node partitions; misses fill the local one first
+void
+testNumaPartitions (void)
+{
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    BM_PoolConfig cfg;
+    BM_PoolStats stats;
+    char expected[64];
+    int i;
+    testName = "NUMA partitions";
+
+    CHECK(createPageFile("testbuffer.bin"));
+    createDummyPages(bm, 10);
+
+    // two logical partitions work on single-node hosts too
+    initPoolConfig(&cfg);
+    cfg.numaNodes = 2;
+    CHECK(initBufferPoolWithConfig(bm, "testbuffer.bin", 4, RS_CLOCK, NULL, &cfg));
+
+    for (i = 0; i < 4; i++)
+    {
+        CHECK(pinPage(bm, h, i));
+        sprintf(expected, "%s-%i", "Page", i);
+        ASSERT_EQUALS_STRING(expected, h->data, "page read into a partition");
+        CHECK(unpinPage(bm, h));
+    }
+    CHECK(getPoolStats(bm, &stats));
+    ASSERT_EQUALS_INT(2, (int) stats.remoteAllocations, "local partition filled first");
+
+    for (i = 0; i < 4; i++)
+    {
+        CHECK(pinPage(bm, h, i));
+        CHECK(unpinPage(bm, h));
+    }
+    CHECK(getPoolStats(bm, &stats));
+    ASSERT_EQUALS_INT(2, (int) stats.remoteAccesses, "hits on the other partition are remote");
+
+    // the victim comes from the local partition
+    CHECK(pinPage(bm, h, 8));
+    ASSERT_EQUALS_STRING("Page-8", h->data, "miss after the pool is full");
+    CHECK(unpinPage(bm, h));
+    CHECK(getPoolStats(bm, &stats));
+    ASSERT_EQUALS_INT(2, (int) stats.remoteAllocations, "victim taken locally");
+    ASSERT_EQUALS_INT(5, getNumReadIO(bm), "check number of read I/Os");
+
+    CHECK(shutdownBufferPool(bm));
+    CHECK(destroyPageFile("testbuffer.bin"));
+
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
+
+// shrinking evicts through the policy, growing hands out the spare frames
+void
+testResizePool (void)
+{
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    BM_PoolConfig cfg;
+    BM_PoolStats stats;
+    int i;
+    testName = "Resizing the pool";
+
+    CHECK(createPageFile("testbuffer.bin"));
+    createDummyPages(bm, 10);
+
+    // frames for up to 5 pages, 3 in use; no cgroup so nothing resizes by itself
+    initPoolConfig(&cfg);
+    cfg.maxPages = 5;
+    cfg.cgroupPath = "no-such-cgroup";
+    CHECK(initBufferPoolWithConfig(bm, "testbuffer.bin", 3, RS_FIFO, NULL, &cfg));
+    ASSERT_EQUALS_INT(5, bm->numPages, "frames set up for the maximum size");
+
+    for (i = 0; i < 4; i++)
+    {
+        CHECK(pinPage(bm, h, i));
+        CHECK(unpinPage(bm, h));
+    }
+    ASSERT_EQUALS_POOL("[3 0],[1 0],[2 0],[-1 0],[-1 0]", bm, "pool limited to 3 frames");
+
+    CHECK(resizeBufferPool(bm, 5));
+    CHECK(pinPage(bm, h, 4));
+    CHECK(unpinPage(bm, h));
+    ASSERT_EQUALS_POOL("[3 0],[1 0],[2 0],[4 0],[-1 0]", bm, "grown pool uses a spare frame");
+
+    CHECK(resizeBufferPool(bm, 2));
+    ASSERT_EQUALS_POOL("[3 0],[-1 0],[-1 0],[4 0],[-1 0]", bm, "shrinking evicted in FIFO order");
+    CHECK(getPoolStats(bm, &stats));
+    ASSERT_EQUALS_INT(2, stats.poolSize, "pool size after shrinking");
+
+    CHECK(pinPage(bm, h, 1));
+    ASSERT_EQUALS_STRING("Page-1", h->data, "miss in the shrunk pool");
+    CHECK(unpinPage(bm, h));
+    ASSERT_EQUALS_POOL("[1 0],[-1 0],[-1 0],[4 0],[-1 0]", bm, "miss replaced instead of growing");
+    ASSERT_EQUALS_INT(6, getNumReadIO(bm), "check number of read I/Os");
+
+    CHECK(shutdownBufferPool(bm));
+    CHECK(destroyPageFile("testbuffer.bin"));
+
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
+
+// replace one file of the fake cgroup directory
+static void
+writeCgroupFile (const char *name, const char *content)
+{
+    char path[64];
+    FILE *fp;
+
+    sprintf(path, "testcgroup/%s", name);
+    fp = fopen(path, "w");
+    fputs(content, fp);
+    fclose(fp);
+}
+
+// wait up to a second for the sizer to reach poolSize
+static int
+waitForPoolSize (BM_BufferPool *bm, int poolSize)
+{
+    struct timespec pause = {0, 1000000};
+    BM_PoolStats stats;
+    int i;
+
+    for (i = 0; i < 1000; i++)
+    {
+        CHECK(getPoolStats(bm, &stats));
+        if (stats.poolSize == poolSize)
+            break;
+        nanosleep(&pause, NULL);
+    }
+    return stats.poolSize;
+}
+
+// the sizer shrinks under memory pressure and grows when memory is free
+void
+testCgroupSizing (void)
+{
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    BM_PoolConfig cfg;
+    int i;
+    testName = "Sizing the pool from cgroup memory";
+
+    CHECK(createPageFile("testbuffer.bin"));
+    createDummyPages(bm, 10);
+
+    mkdir("testcgroup", 0755);
+    writeCgroupFile("memory.current", "950000\n");
+    writeCgroupFile("memory.max", "1000000\n");
+    writeCgroupFile("memory.pressure", "some avg10=50.00 avg60=20.00 avg300=5.00 total=1000\n");
+
+    initPoolConfig(&cfg);
+    cfg.minPages = 2;
+    cfg.maxPages = 6;
+    cfg.cgroupPath = "testcgroup";
+    cfg.resizeIntervalMs = 5;
+    CHECK(initBufferPoolWithConfig(bm, "testbuffer.bin", 4, RS_CLOCK, NULL, &cfg));
+    for (i = 0; i < 4; i++)
+    {
+        CHECK(pinPage(bm, h, i));
+        CHECK(unpinPage(bm, h));
+    }
+    ASSERT_EQUALS_INT(2, waitForPoolSize(bm, 2), "shrunk to minPages under pressure");
+
+    writeCgroupFile("memory.max", "max\n");
+    writeCgroupFile("memory.pressure", "some avg10=0.00 avg60=0.00 avg300=0.00 total=1000\n");
+    ASSERT_EQUALS_INT(6, waitForPoolSize(bm, 6), "grown to maxPages without a limit");
+
+    for (i = 0; i < 6; i++)
+    {
+        char expected[64];
+        CHECK(pinPage(bm, h, i));
+        sprintf(expected, "%s-%i", "Page", i);
+        ASSERT_EQUALS_STRING(expected, h->data, "pages read after resizing");
+        CHECK(unpinPage(bm, h));
+    }
+
+    CHECK(shutdownBufferPool(bm));
+    CHECK(destroyPageFile("testbuffer.bin"));
+    remove("testcgroup/memory.current");
+    remove("testcgroup/memory.max");
+    remove("testcgroup/memory.pressure");
+    rmdir("testcgroup");
+
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
+
+// kept pages survive a scan, high-priority pages go only when nothing else can
+void
+testPagePriorities (void)
+{
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    BM_PageHandle *scan = MAKE_PAGE_HANDLE();
+    BM_PoolConfig cfg;
+    BM_PoolStats stats;
+    int i;
+    testName = "Page priority hints";
+
+    CHECK(createPageFile("testbuffer.bin"));
+    createDummyPages(bm, 10);
+
+    // room for one kept page, so page 1 is only treated as high priority
+    initPoolConfig(&cfg);
+    cfg.keepResidentMax = 1;
+    CHECK(initBufferPoolWithConfig(bm, "testbuffer.bin", 3, RS_FIFO, NULL, &cfg));
+    CHECK(setPagePriority(bm, 0, 1, BM_PRIO_KEEP));
+
+    for (i = 0; i < 10; i++)
+    {
+        CHECK(pinPage(bm, h, i));
+        CHECK(unpinPage(bm, h));
+    }
+    ASSERT_EQUALS_POOL("[0 0],[1 0],[9 0]", bm, "scan only replaced the normal frame");
+    CHECK(getPoolStats(bm, &stats));
+    ASSERT_EQUALS_INT(1, stats.keepFrames, "keep-resident set is bounded");
+
+    CHECK(pinPage(bm, h, 0));
+    ASSERT_EQUALS_STRING("Page-0", h->data, "kept page is still resident");
+    CHECK(unpinPage(bm, h));
+    ASSERT_EQUALS_INT(10, getNumReadIO(bm), "kept page was not read again");
+
+    // with the normal frame pinned the high-priority page has to go
+    CHECK(pinPage(bm, scan, 2));
+    CHECK(pinPage(bm, h, 3));
+    CHECK(unpinPage(bm, h));
+    ASSERT_EQUALS_POOL("[0 0],[3 0],[2 1]", bm, "high-priority page evicted last");
+    CHECK(unpinPage(bm, scan));
+
+    // dropping the hint makes page 0 evictable again
+    CHECK(setPagePriority(bm, 0, 1, BM_PRIO_NORMAL));
+    for (i = 4; i < 7; i++)
+    {
+        CHECK(pinPage(bm, h, i));
+        CHECK(unpinPage(bm, h));
+    }
+    ASSERT_EQUALS_POOL("[5 0],[6 0],[4 0]", bm, "page without a hint is replaced");
+    CHECK(shutdownBufferPool(bm));
+
+    // the bound follows the pool size, so a shrink cannot leave every
+    // frame kept, and growing makes room for demoted keep requests again
+    initPoolConfig(&cfg);
+    cfg.keepResidentMax = 3;
+    cfg.maxPages = 6;
+    cfg.cgroupPath = "no-such-cgroup";
+    CHECK(initBufferPoolWithConfig(bm, "testbuffer.bin", 6, RS_FIFO, NULL, &cfg));
+    CHECK(setPagePriority(bm, 0, 3, BM_PRIO_KEEP));
+    for (i = 0; i < 4; i++)
+    {
+        CHECK(pinPage(bm, h, i));
+        CHECK(unpinPage(bm, h));
+    }
+    CHECK(getPoolStats(bm, &stats));
+    ASSERT_EQUALS_INT(3, stats.keepFrames, "keep-resident set at its bound");
+
+    CHECK(resizeBufferPool(bm, 3));
+    ASSERT_EQUALS_POOL("[0 0],[1 0],[-1 0],[3 0],[-1 0],[-1 0]", bm, "demoted page evicted by the shrink");
+    CHECK(getPoolStats(bm, &stats));
+    ASSERT_EQUALS_INT(2, stats.keepFrames, "keep-resident set bounded by the smaller pool");
+    CHECK(pinPage(bm, h, 4));
+    CHECK(unpinPage(bm, h));
+    CHECK(pinPage(bm, h, 2));
+    ASSERT_EQUALS_STRING("Page-2", h->data, "misses still find a frame");
+    CHECK(unpinPage(bm, h));
+    CHECK(getPoolStats(bm, &stats));
+    ASSERT_EQUALS_INT(2, stats.keepFrames, "keep request beyond the bound demoted");
+
+    CHECK(resizeBufferPool(bm, 6));
+    CHECK(getPoolStats(bm, &stats));
+    ASSERT_EQUALS_INT(3, stats.keepFrames, "demoted page promoted once there is room");
+
+    CHECK(shutdownBufferPool(bm));
+    CHECK(destroyPageFile("testbuffer.bin"));
+
+    free(bm);
+    free(h);
+    free(scan);
+    TEST_DONE();
+}
+
+// a client at its quota replaces its own pages, not everyone else's
+void
+testClientQuotas (void)
+{
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    BM_Client batch, tenant;
+    int i;
+    testName = "Client frame quotas";
+
+    CHECK(createPageFile("testbuffer.bin"));
+    createDummyPages(bm, 10);
+    CHECK(initBufferPool(bm, "testbuffer.bin", 4, RS_FIFO, NULL));
+    CHECK(openClient(bm, &batch, 2));
+    CHECK(openClient(bm, &tenant, 4));
+
+    // the batch job scans four pages but only ever holds two frames
+    for (i = 0; i < 4; i++)
+    {
+        CHECK(pinPageForClient(&batch, h, i));
+        CHECK(unpinPage(bm, h));
+    }
+    ASSERT_EQUALS_POOL("[2 0],[3 0],[-1 0],[-1 0]", bm, "batch scan stayed within its quota");
+    ASSERT_EQUALS_INT(2, getClientFrames(&batch), "batch frames");
+
+    // pages without a client still use the rest of the pool
+    for (i = 4; i < 6; i++)
+    {
+        CHECK(pinPage(bm, h, i));
+        CHECK(unpinPage(bm, h));
+    }
+
+    // at its quota the batch job evicts its own oldest page
+    CHECK(pinPageForClient(&batch, h, 6));
+    ASSERT_EQUALS_STRING("Page-6", h->data, "batch page read");
+    CHECK(unpinPage(bm, h));
+    ASSERT_EQUALS_POOL("[6 0],[3 0],[4 0],[5 0]", bm, "batch replaced its own page");
+
+    // below its quota the tenant takes the oldest page in the pool
+    CHECK(pinPageForClient(&tenant, h, 7));
+    CHECK(unpinPage(bm, h));
+    ASSERT_EQUALS_POOL("[6 0],[7 0],[4 0],[5 0]", bm, "tenant replaced the oldest page");
+    ASSERT_EQUALS_INT(1, getClientFrames(&batch), "batch lost a frame to the tenant");
+    ASSERT_EQUALS_INT(1, getClientFrames(&tenant), "tenant frames");
+
+    CHECK(closeClient(&batch));
+    CHECK(closeClient(&tenant));
+    CHECK(shutdownBufferPool(bm));
+    CHECK(destroyPageFile("testbuffer.bin"));
+
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
+
+// dirty neighbours of a dirty victim go out in the same write
+void
+testWriteCoalescing (void)
+{
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    BM_PageHandle *pinned = MAKE_PAGE_HANDLE();
+    BM_PoolConfig cfg;
+    BM_PoolStats stats;
+    SM_FileHandle fh;
+    char page[PAGE_SIZE];
+    char expected[64];
+    int i;
+    testName = "Coalescing victim write-backs";
+
+    CHECK(createPageFile("testbuffer.bin"));
+    createDummyPages(bm, 10);
+
+    initPoolConfig(&cfg);
+    cfg.writeCoalesceWindow = 2;
+    CHECK(initBufferPoolWithConfig(bm, "testbuffer.bin", 5, RS_FIFO, NULL, &cfg));
+
+    // dirty pages 0-4, page 3 stays pinned
+    for (i = 0; i < 5; i++)
+    {
+        BM_PageHandle *ph = (i == 3) ? pinned : h;
+        CHECK(pinPage(bm, ph, i));
+        sprintf(ph->data, "%s-%i", "Dirty", i);
+        CHECK(markDirty(bm, ph));
+        if (i != 3)
+            CHECK(unpinPage(bm, ph));
+    }
+
+    // evicting page 0 also writes 1 and 2; the pinned page 3 ends the run
+    CHECK(pinPage(bm, h, 5));
+    CHECK(unpinPage(bm, h));
+    ASSERT_EQUALS_POOL("[5 0],[1 0],[2 0],[3x1],[4x0]", bm, "neighbours written and cleaned");
+    ASSERT_EQUALS_INT(3, getNumWriteIO(bm), "check number of write I/Os");
+    CHECK(getPoolStats(bm, &stats));
+    ASSERT_EQUALS_INT(2, (int) stats.coalescedWrites, "pages written with the victim");
+
+    CHECK(openPageFile("testbuffer.bin", &fh));
+    for (i = 0; i < 3; i++)
+    {
+        CHECK(readBlock(i, &fh, page));
+        sprintf(expected, "%s-%i", "Dirty", i);
+        ASSERT_EQUALS_STRING(expected, page, "page on disk after the run");
+    }
+    CHECK(closePageFile(&fh));
+
+    // the neighbours stay cached
+    CHECK(pinPage(bm, h, 2));
+    ASSERT_EQUALS_STRING("Dirty-2", h->data, "neighbour still resident");
+    CHECK(unpinPage(bm, h));
+    ASSERT_EQUALS_INT(6, getNumReadIO(bm), "check number of read I/Os");
+
+    CHECK(unpinPage(bm, pinned));
+    CHECK(shutdownBufferPool(bm));
+    CHECK(destroyPageFile("testbuffer.bin"));
+
+    free(bm);
+    free(h);
+    free(pinned);
+    TEST_DONE();
+}
+
+// a victim whose write-back fails stays cached and dirty
+void
+testFailedWriteBack (void)
+{
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    BM_PoolConfig cfg;
+    BM_PoolStats stats;
+    SM_FileHandle fh;
+    struct rlimit oldLimit, limit;
+    char page[PAGE_SIZE];
+    char expected[64];
+    int i;
+    testName = "Failed victim write-backs";
+
+    CHECK(createPageFile("testbuffer.bin"));
+    createDummyPages(bm, 10);
+
+    initPoolConfig(&cfg);
+    cfg.writeCoalesceWindow = 1;
+    CHECK(initBufferPoolWithConfig(bm, "testbuffer.bin", 2, RS_FIFO, NULL, &cfg));
+    for (i = 6; i < 8; i++)
+    {
+        CHECK(pinPage(bm, h, i));
+        sprintf(h->data, "%s-%i", "Dirty", i);
+        CHECK(markDirty(bm, h));
+        CHECK(unpinPage(bm, h));
+    }
+
+    // writes past the first 4 pages of the file fail from here on
+    signal(SIGXFSZ, SIG_IGN);
+    getrlimit(RLIMIT_FSIZE, &oldLimit);
+    limit = oldLimit;
+    limit.rlim_cur = 4 * PAGE_SIZE;
+    setrlimit(RLIMIT_FSIZE, &limit);
+
+    // the miss writes back 6 and its neighbour 7; both writes fail
+    ASSERT_TRUE(pinPage(bm, h, 2) == RC_WRITE_FAILED, "pin that needed the write-back fails");
+    ASSERT_EQUALS_POOL("[6x0],[7x0]", bm, "victim and neighbour still cached and dirty");
+    CHECK(getPoolStats(bm, &stats));
+    ASSERT_EQUALS_INT(2, (int) stats.failedWrites, "failed write-backs counted");
+    ASSERT_EQUALS_INT(0, getNumWriteIO(bm), "check number of write I/Os");
+    ASSERT_EQUALS_INT(2, getNumReadIO(bm), "check number of read I/Os");
+
+    CHECK(pinPage(bm, h, 6));
+    ASSERT_EQUALS_STRING("Dirty-6", h->data, "victim pinned from the pool");
+    ASSERT_EQUALS_INT(2, getNumReadIO(bm), "victim pin is a hit");
+
+    // a forced write that fails leaves the page dirty too
+    ASSERT_TRUE(forcePage(bm, h) == RC_WRITE_FAILED, "forcePage reports the failed write");
+    ASSERT_EQUALS_POOL("[6x1],[7x0]", bm, "forced page still dirty");
+    CHECK(getPoolStats(bm, &stats));
+    ASSERT_EQUALS_INT(3, (int) stats.failedWrites, "failed forced write counted");
+    ASSERT_EQUALS_INT(0, getNumWriteIO(bm), "check number of write I/Os");
+    CHECK(unpinPage(bm, h));
+
+    // and so does a flush
+    ASSERT_TRUE(forceFlushPool(bm) == RC_WRITE_FAILED, "forceFlushPool reports the failed writes");
+    ASSERT_EQUALS_POOL("[6x0],[7x0]", bm, "flushed pages still dirty");
+    CHECK(getPoolStats(bm, &stats));
+    ASSERT_EQUALS_INT(5, (int) stats.failedWrites, "failed flush writes counted");
+
+    setrlimit(RLIMIT_FSIZE, &oldLimit);
+    signal(SIGXFSZ, SIG_DFL);
+
+    CHECK(pinPage(bm, h, 2));
+    ASSERT_EQUALS_STRING("Page-2", h->data, "pin works once writes do");
+    CHECK(unpinPage(bm, h));
+    CHECK(shutdownBufferPool(bm));
+
+    CHECK(openPageFile("testbuffer.bin", &fh));
+    for (i = 6; i < 8; i++)
+    {
+        CHECK(readBlock(i, &fh, page));
+        sprintf(expected, "%s-%i", "Dirty", i);
+        ASSERT_EQUALS_STRING(expected, page, "page on disk once written");
+    }
+    CHECK(closePageFile(&fh));
+    CHECK(destroyPageFile("testbuffer.bin"));
+
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
+
+// consecutive pages pinned as one contiguous buffer
+void
+testExtentPins (void)
+{
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    BM_ExtentHandle extent, other;
+    char expected[64];
+    int i;
+    testName = "Extent pins";
+
+    CHECK(createPageFile("testbuffer.bin"));
+    createDummyPages(bm, 10);
+    CHECK(initBufferPool(bm, "testbuffer.bin", 6, RS_FIFO, NULL));
+
+    // a cached dirty page of the extent stays dirty and is not read again
+    CHECK(pinPage(bm, h, 2));
+    sprintf(h->data, "%s-%i", "Dirty", 2);
+    CHECK(markDirty(bm, h));
+    CHECK(unpinPage(bm, h));
+
+    CHECK(pinExtent(bm, 2, 3, &extent));
+    ASSERT_EQUALS_INT(2, extent.firstPage, "first page of the extent");
+    ASSERT_EQUALS_STRING("Dirty-2", extent.data, "cached page kept its changes");
+    for (i = 3; i < 5; i++)
+    {
+        sprintf(expected, "%s-%i", "Page", i);
+        ASSERT_EQUALS_STRING(expected, extent.data + (i - 2) * PAGE_SIZE, "page inside the extent");
+    }
+    ASSERT_EQUALS_POOL("[2x1],[3 1],[4 1],[-1 0],[-1 0],[-1 0]", bm, "extent in adjacent frames");
+    ASSERT_EQUALS_INT(0, getNumWriteIO(bm), "check number of write I/Os");
+    ASSERT_EQUALS_INT(3, getNumReadIO(bm), "check number of read I/Os");
+
+    // single pages of the extent are ordinary hits
+    CHECK(pinPage(bm, h, 3));
+    ASSERT_TRUE(h->data == extent.data + PAGE_SIZE, "page pin shares the extent's frame");
+    CHECK(unpinPage(bm, h));
+
+    ASSERT_EQUALS_INT(RC_BM_EXTENT_UNAVAILABLE, pinExtent(bm, 4, 2, &other), "page of the extent is pinned");
+    ASSERT_EQUALS_INT(RC_BM_EXTENT_UNAVAILABLE, pinExtent(bm, 0, 7, &other), "extent larger than the pool");
+
+    CHECK(markExtentDirty(bm, &extent));
+    CHECK(unpinExtent(bm, &extent));
+    ASSERT_EQUALS_POOL("[2x0],[3x0],[4x0],[-1 0],[-1 0],[-1 0]", bm, "extent unpinned as a unit");
+
+    // an overlapping extent copies its cached pages to their new offsets and
+    // writes back only the dirty page it replaces
+    CHECK(pinExtent(bm, 3, 3, &other));
+    ASSERT_EQUALS_POOL("[3x1],[4x1],[5 1],[-1 0],[-1 0],[-1 0]", bm, "cached pages moved into the run");
+    ASSERT_EQUALS_STRING("Page-3", other.data, "moved page kept its data");
+    ASSERT_EQUALS_STRING("Page-5", other.data + 2 * PAGE_SIZE, "missing page read");
+    ASSERT_EQUALS_INT(1, getNumWriteIO(bm), "check number of write I/Os");
+    ASSERT_EQUALS_INT(4, getNumReadIO(bm), "check number of read I/Os");
+    CHECK(unpinExtent(bm, &other));
+
+    CHECK(shutdownBufferPool(bm));
+    CHECK(destroyPageFile("testbuffer.bin"));
+
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
+
+// spill pages staged in RAM, then on disk, with extents reused
+void
+testTempSpace (void)
+{
+    TS_TempSpace space;
+    TS_TempFile file;
+    TS_TempStats stats;
+    char page[PAGE_SIZE];
+    char expected[64];
+    int i, run;
+    testName = "Temp spill space";
+
+    CHECK(openTempSpace(&space, ".", TEMP_EXTENT_PAGES));
+    for (run = 0; run < 2; run++)
+    {
+        CHECK(createTempFile(&space, &file));
+        for (i = 0; i < 2 * TEMP_EXTENT_PAGES; i++)
+        {
+            memset(page, 0, PAGE_SIZE);
+            sprintf(page, "%s-%i-%i", "Temp", run, i);
+            CHECK(writeTempPage(&file, i, page));
+        }
+        ASSERT_EQUALS_INT(2 * TEMP_EXTENT_PAGES, file.numPages, "pages in the temp file");
+        for (i = 0; i < 2 * TEMP_EXTENT_PAGES; i++)
+        {
+            CHECK(readTempPage(&file, i, page));
+            sprintf(expected, "%s-%i-%i", "Temp", run, i);
+            ASSERT_EQUALS_STRING(expected, page, "spilled page read back");
+        }
+        ASSERT_EQUALS_INT(RC_READ_NON_EXISTING_PAGE, readTempPage(&file, 2 * TEMP_EXTENT_PAGES, page),
+                          "page past the end");
+        CHECK(closeTempFile(&file));
+    }
+
+    // the second run reused both extents instead of growing
+    CHECK(getTempSpaceStats(&space, &stats));
+    ASSERT_EQUALS_INT(TEMP_EXTENT_PAGES, stats.ramPages, "RAM staging budget used");
+    ASSERT_EQUALS_INT(TEMP_EXTENT_PAGES, stats.diskPages, "one disk extent");
+    ASSERT_EQUALS_INT(2, stats.extentsReused, "extents reused by the second file");
+    ASSERT_EQUALS_INT(2 * TEMP_EXTENT_PAGES, stats.pageWrites, "only disk pages are written");
+    CHECK(closeTempSpace(&space));
+
+    TEST_DONE();
+}
+
+// statistics exported to a file (Prometheus text) and a Unix socket (JSON)
+void
+testStatsExport (void)
+{
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    BM_StatsExporter exp;
+    struct sockaddr_un addr;
+    char text[16384];
+    size_t len;
+    ssize_t n;
+    FILE *in;
+    int fd;
+    testName = "Statistics exporter";
+
+    CHECK(createPageFile("testbuffer.bin"));
+    createDummyPages(bm, 10);
+    CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_FIFO, NULL));
+    CHECK(pinPage(bm, h, 0));
+    CHECK(markDirty(bm, h));
+    CHECK(unpinPage(bm, h));
+    CHECK(pinPage(bm, h, 0));
+    CHECK(unpinPage(bm, h));
+    CHECK(pinPage(bm, h, 1));
+
+    // stopping writes a final snapshot to a file target
+    CHECK(startStatsExporter(&exp, bm, "testbuffer.prom", BM_EXPORT_PROMETHEUS, 10000));
+    CHECK(stopStatsExporter(&exp));
+    in = fopen("testbuffer.prom", "r");
+    ASSERT_TRUE(in != NULL, "snapshot file written");
+    len = fread(text, 1, sizeof(text) - 1, in);
+    text[len] = '\0';
+    fclose(in);
+    ASSERT_TRUE(strstr(text, "bm_read_io_total 2\n") != NULL, "read I/O exported");
+    ASSERT_TRUE(strstr(text, "bm_pins_total 3\n") != NULL, "pins exported");
+    ASSERT_TRUE(strstr(text, "bm_dirty_frames 1\n") != NULL, "dirty frames exported");
+    ASSERT_TRUE(strstr(text, "bm_pinned_frames 1\n") != NULL, "pinned frames exported");
+    ASSERT_TRUE(strstr(text, "bm_free_frames 1\n") != NULL, "free frames exported");
+    ASSERT_TRUE(strstr(text, "bm_read_latency_seconds_count 2\n") != NULL, "read latency histogram");
+    ASSERT_TRUE(strstr(text, "bm_pool_info{page_file=\"testbuffer.bin\"} 1\n") != NULL, "page file label");
+    remove("testbuffer.prom");
+
+    // a socket client gets a fresh snapshot per connection
+    CHECK(startStatsExporter(&exp, bm, "unix:testbuffer.sock", BM_EXPORT_JSON, 0));
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, "testbuffer.sock");
+    n = connect(fd, (struct sockaddr *) &addr, sizeof(addr));
+    ASSERT_EQUALS_INT(0, (int) n, "connected to the exporter");
+    len = 0;
+    while ((n = read(fd, text + len, sizeof(text) - 1 - len)) > 0) len += (size_t) n;
+    text[len] = '\0';
+    close(fd);
+    CHECK(stopStatsExporter(&exp));
+    ASSERT_TRUE(strstr(text, "\"pageFile\": \"testbuffer.bin\",") != NULL, "page file in JSON");
+    ASSERT_TRUE(strstr(text, "\"readIO\": 2,") != NULL, "read I/O in JSON");
+    ASSERT_TRUE(strstr(text, "\"pinnedFrames\": 1,") != NULL, "pinned frames in JSON");
+    ASSERT_TRUE(strstr(text, "\"hitRatio\": 0.333333,") != NULL, "hit ratio in JSON");
+
+    CHECK(unpinPage(bm, h));
+    CHECK(shutdownBufferPool(bm));
+    CHECK(destroyPageFile("testbuffer.bin"));
+
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
+
+// inspectPool visitor: append the page numbers it sees, stop after max
+typedef struct PageCollector {
+    int pages[16];
+    int count;
+    int max;
+} PageCollector;
+
+static int
+collectPage (const BM_FrameInfo *info, void *ctx)
+{
+    PageCollector *c = (PageCollector *) ctx;
+    c->pages[c->count++] = info->pageNum;
+    return c->count >= c->max;
+}
+
+// filtered frame walks and the constant-size summary
+void
+testPoolInspection (void)
+{
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    BM_PageHandle pinned[2];
+    BM_InspectFilter filter;
+    BM_PoolSummary summary;
+    PageCollector c;
+    int i;
+    testName = "Pool inspection";
+
+    CHECK(createPageFile("testbuffer.bin"));
+    createDummyPages(bm, 10);
+    CHECK(initBufferPool(bm, "testbuffer.bin", 6, RS_FIFO, NULL));
+    // pages 0-4 resident, 1 and 3 dirty, 2 and 3 pinned
+    for (i = 0; i < 5; i++)
+    {
+        CHECK(pinPage(bm, h, i));
+        if (i == 1 || i == 3)
+            CHECK(markDirty(bm, h));
+        if (i == 2 || i == 3)
+            pinned[i - 2] = *h;
+        else
+            CHECK(unpinPage(bm, h));
+    }
+
+    filter.flags = BM_INSPECT_DIRTY;
+    filter.firstPage = filter.lastPage = NO_PAGE;
+    c.count = 0;
+    c.max = 16;
+    CHECK(inspectPool(bm, &filter, collectPage, &c));
+    ASSERT_EQUALS_INT(2, c.count, "dirty frames");
+    ASSERT_EQUALS_INT(3, c.pages[1], "second dirty page");
+
+    filter.flags = BM_INSPECT_DIRTY | BM_INSPECT_PINNED;
+    c.count = 0;
+    CHECK(inspectPool(bm, &filter, collectPage, &c));
+    ASSERT_EQUALS_INT(1, c.count, "dirty and pinned frames");
+    ASSERT_EQUALS_INT(3, c.pages[0], "dirty pinned page");
+
+    filter.flags = 0;
+    filter.firstPage = 1;
+    filter.lastPage = 2;
+    c.count = 0;
+    CHECK(inspectPool(bm, &filter, collectPage, &c));
+    ASSERT_EQUALS_INT(2, c.count, "frames in the page range");
+
+    // no filter visits empty frames too; the visitor can stop early
+    c.count = 0;
+    CHECK(inspectPool(bm, NULL, collectPage, &c));
+    ASSERT_EQUALS_INT(6, c.count, "every frame");
+    ASSERT_EQUALS_INT(NO_PAGE, c.pages[5], "empty frame");
+    c.count = 0;
+    c.max = 2;
+    CHECK(inspectPool(bm, NULL, collectPage, &c));
+    ASSERT_EQUALS_INT(2, c.count, "visitor stopped the walk");
+
+    CHECK(summarizePool(bm, &summary));
+    ASSERT_EQUALS_INT(6, summary.frames, "frames summarized");
+    ASSERT_EQUALS_INT(1, summary.emptyFrames, "empty frames");
+    ASSERT_EQUALS_INT(2, summary.dirtyFrames, "dirty frames");
+    ASSERT_EQUALS_INT(2, summary.pinnedFrames, "pinned frames");
+    ASSERT_EQUALS_INT(0, summary.minPage, "lowest resident page");
+    ASSERT_EQUALS_INT(4, summary.maxPage, "highest resident page");
+    ASSERT_EQUALS_INT(1, summary.bucketPages, "10 pages over 16 buckets");
+    ASSERT_EQUALS_INT(1, summary.dirty[3], "page 3 bucket is dirty");
+    ASSERT_EQUALS_INT(4, summary.fixCounts[0], "unpinned frames");
+    ASSERT_EQUALS_INT(2, summary.fixCounts[1], "frames pinned once");
+
+    for (i = 0; i < 2; i++)
+        CHECK(unpinPage(bm, &pinned[i]));
+    CHECK(shutdownBufferPool(bm));
+    CHECK(destroyPageFile("testbuffer.bin"));
+
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
+
+// a traced pool records each API call, in order, readable by readTraceRecord
+void
+testApiTrace (void)
+{
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    BM_PoolConfig cfg;
+    TraceRecord rec;
+    FILE *in;
+    char name[1000];
+    const char ops[] = { TRACE_INIT, TRACE_PIN, TRACE_DIRTY, TRACE_UNPIN, TRACE_FORCE,
+            TRACE_FLUSH, TRACE_SHUTDOWN };
+    const int pages[] = { NO_PAGE, 2, 2, 2, 2, NO_PAGE, NO_PAGE };
+    long long last = 0;
+    RC rc;
+    int i;
+    testName = "API trace";
+
+    CHECK(createPageFile("testbuffer.bin"));
+    createDummyPages(bm, 4);
+    initPoolConfig(&cfg);
+    cfg.traceFile = "testbuffer.trace";
+    CHECK(initBufferPoolWithConfig(bm, "testbuffer.bin", 3, RS_LRU, NULL, &cfg));
+    CHECK(pinPage(bm, h, 2));
+    CHECK(markDirty(bm, h));
+    CHECK(unpinPage(bm, h));
+    CHECK(forcePage(bm, h));
+    CHECK(forceFlushPool(bm));
+    CHECK(shutdownBufferPool(bm));
+
+    in = fopen("testbuffer.trace", "r");
+    ASSERT_TRUE(in != NULL, "trace file written");
+    for (i = 0; i < 7; i++)
+    {
+        CHECK(readTraceRecord(in, &rec));
+        ASSERT_EQUALS_INT(ops[i], rec.op, "call recorded in order");
+        ASSERT_EQUALS_INT(pages[i], rec.page, "page of the call");
+        ASSERT_EQUALS_INT(0, rec.thread, "single thread");
+        ASSERT_TRUE(rec.nanos >= last, "timestamps do not go back");
+        last = rec.nanos;
+        if (i == 0)
+        {
+            ASSERT_EQUALS_INT(3, rec.numPages, "pool size recorded");
+            ASSERT_EQUALS_INT(RS_LRU, rec.strategy, "strategy recorded");
+            ASSERT_EQUALS_STRING("testbuffer.bin", rec.pageFile, "page file recorded");
+        }
+    }
+    rc = readTraceRecord(in, &rec);
+    ASSERT_EQUALS_INT(RC_RM_NO_MORE_TUPLES, rc, "nothing after the shutdown");
+    fclose(in);
+
+    // the page file name is the rest of its line: spaces and long paths survive
+    memset(name, 'd', sizeof(name) - 1);
+    name[sizeof(name) - 1] = '\0';
+    memcpy(name, " a dir/", 7);
+    in = fopen("testbuffer.trace", "w");
+    fprintf(in, "# bm trace 1\n0 0 I 3 %d %s\n", RS_LRU, name);
+    fclose(in);
+    in = fopen("testbuffer.trace", "r");
+    CHECK(readTraceRecord(in, &rec));
+    ASSERT_EQUALS_STRING(name, rec.pageFile, "long name with spaces read back");
+    fclose(in);
+    remove("testbuffer.trace");
+    CHECK(destroyPageFile("testbuffer.bin"));
+
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
+
+// a loop over 6 pages misses every time with fewer than 6 LRU frames and
+// hits after the first pass with more; the estimate sees both sides
+void
+testHitRatioCurve (void)
+{
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    BM_PoolConfig cfg;
+    BM_HitRatioCurve curve;
+    const int pages[] = { 2, 4, 8, 16 };
+    RC rc;
+    int i;
+    testName = "hit ratio curve";
+
+    CHECK(createPageFile("testbuffer.bin"));
+    createDummyPages(bm, 6);
+    CHECK(initBufferPool(bm, "testbuffer.bin", 4, RS_LRU, NULL));
+    rc = getHitRatioCurve(bm, &curve);
+    ASSERT_EQUALS_INT(RC_BM_NOT_ENABLED, rc, "estimate off by default");
+    CHECK(shutdownBufferPool(bm));
+
+    initPoolConfig(&cfg);
+    cfg.hitRatioCurve = 1;
+    CHECK(initBufferPoolWithConfig(bm, "testbuffer.bin", 4, RS_LRU, NULL, &cfg));
+    for (i = 0; i < 60 * 6; i++)
+    {
+        CHECK(pinPage(bm, h, i % 6));
+        CHECK(unpinPage(bm, h));
+    }
+    CHECK(getHitRatioCurve(bm, &curve));
+    ASSERT_TRUE(curve.sampleRate == 1.0, "small pool sampled exactly");
+    ASSERT_EQUALS_INT(360, (int) curve.sampledPins, "every pin sampled");
+    for (i = 0; i < BM_CURVE_POINTS; i++)
+        ASSERT_EQUALS_INT(pages[i], curve.pages[i], "0.5x, 1x, 2x and 4x the pool");
+    ASSERT_TRUE(curve.hitRatio[0] == 0 && curve.hitRatio[1] == 0, "loop larger than the pool misses");
+    ASSERT_EQUALS_INT(360, getNumReadIO(bm), "estimate at 1x matches the pool");
+    ASSERT_TRUE(curve.hitRatio[2] > 0.98 && curve.hitRatio[3] > 0.98, "loop fits in 8 pages");
+    CHECK(shutdownBufferPool(bm));
+    CHECK(destroyPageFile("testbuffer.bin"));
+
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
+
+// a log-structured page file reads back the latest write of every page
+// after cleaning, a clean reopen, a crash and through a buffer pool
+void
+testLogStructuredFile (void)
+{
+    SM_FileHandle fh;
+    SM_LogStats stats;
+    SM_PageHandle pages[8];
+    char *buf = malloc(8 * PAGE_SIZE);
+    char expect[32];
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    FILE *fp;
+    pid_t child;
+    int status, i;
+    testName = "log-structured page file";
+
+    // 4-page segments: pages 0-3 in segment 0, 4-7 in segment 1
+    CHECK(createLogPageFile("testlog.bin", 4));
+    CHECK(openPageFile("testlog.bin", &fh));
+    ASSERT_EQUALS_INT(1, fh.totalNumPages, "new file has one page");
+    CHECK(ensureCapacity(8, &fh));
+    ASSERT_EQUALS_INT(8, fh.totalNumPages, "grown to 8 pages");
+    CHECK(readBlock(5, &fh, buf));
+    ASSERT_TRUE(buf[0] == 0 && buf[PAGE_SIZE - 1] == 0, "unwritten page reads as zeros");
+    for (i = 0; i < 8; i++)
+    {
+        pages[i] = buf + i * PAGE_SIZE;
+        memset(pages[i], 0, PAGE_SIZE);
+        sprintf(pages[i], "page-%i-v1", i);
+    }
+    CHECK(writeBlocks(0, 8, &fh, pages));
+    // rewriting 0-2 in one call leaves segment 0 with one live page of
+    // four before the cleaner can look at it
+    for (i = 0; i < 3; i++)
+        sprintf(pages[i], "page-%i-v2", i);
+    CHECK(writeBlocks(0, 3, &fh, pages));
+    CHECK(cleanPageFile(&fh));
+    CHECK(getPageFileLogStats(&fh, &stats));
+    ASSERT_EQUALS_INT(2, stats.segments, "mostly dead segment reclaimed");
+    ASSERT_EQUALS_INT(8, stats.livePages, "every page live once");
+    ASSERT_EQUALS_INT(0, stats.deadPages, "no garbage left");
+    ASSERT_EQUALS_INT(1, (int) stats.copiedPages, "live page of the segment moved");
+    ASSERT_EQUALS_INT(11, (int) stats.appendedPages, "one record per page written");
+    fp = fopen("testlog.bin.seg0", "rb");
+    ASSERT_TRUE(fp == NULL, "segment file deleted");
+    for (i = 0; i < 8; i++)
+    {
+        sprintf(expect, "page-%i-v%i", i, i < 3 ? 2 : 1);
+        CHECK(readBlock(i, &fh, buf));
+        ASSERT_EQUALS_STRING(expect, buf, "latest copy read after cleaning");
+    }
+    CHECK(closePageFile(&fh));
+
+    // a child dies without closing the file; the table is rebuilt from the
+    // segments, skipping a torn record at the end of the log
+    fflush(stdout);
+    child = fork();
+    if (child == 0)
+    {
+        openPageFile("testlog.bin", &fh);
+        memset(buf, 0, PAGE_SIZE);
+        sprintf(buf, "page-5-v3");
+        writeBlock(5, &fh, buf);
+        sprintf(buf, "page-9-v3");
+        writeBlock(9, &fh, buf);
+        _exit(0);
+    }
+    waitpid(child, &status, 0);
+    fp = fopen("testlog.bin.seg3", "ab");
+    ASSERT_TRUE(fp != NULL, "child appended to a new segment");
+    memset(buf, 'z', PAGE_SIZE + 64);
+    fwrite(buf, 1, PAGE_SIZE + 64, fp);
+    fclose(fp);
+    CHECK(openPageFile("testlog.bin", &fh));
+    ASSERT_EQUALS_INT(10, fh.totalNumPages, "pages written before the crash counted");
+    for (i = 0; i < 10; i++)
+    {
+        if (i == 8)
+            strcpy(expect, "");
+        else
+            sprintf(expect, "page-%i-v%i", i, i == 5 || i == 9 ? 3 : i < 3 ? 2 : 1);
+        CHECK(readBlock(i, &fh, buf));
+        ASSERT_EQUALS_STRING(expect, buf, "latest copy recovered");
+    }
+    CHECK(closePageFile(&fh));
+
+    // the buffer manager runs on it unchanged
+    CHECK(initBufferPool(bm, "testlog.bin", 3, RS_LRU, NULL));
+    for (i = 0; i < 20; i++)
+    {
+        CHECK(pinPage(bm, h, i % 10));
+        sprintf(h->data, "pool-%i", i);
+        CHECK(markDirty(bm, h));
+        CHECK(unpinPage(bm, h));
+    }
+    CHECK(shutdownBufferPool(bm));
+    CHECK(openPageFile("testlog.bin", &fh));
+    for (i = 0; i < 10; i++)
+    {
+        sprintf(expect, "pool-%i", i + 10);
+        CHECK(readBlock(i, &fh, buf));
+        ASSERT_EQUALS_STRING(expect, buf, "pool write-backs appended");
+    }
+    CHECK(closePageFile(&fh));
+    CHECK(destroyPageFile("testlog.bin"));
+    fp = fopen("testlog.bin.seg1", "rb");
+    ASSERT_TRUE(fp == NULL, "segments destroyed with the file");
+
+    // a plain page that happens to start like a log header (one segment)
+    // does not make its file a log, nor the file next to it its segment
+    CHECK(createPageFile("testlog.bin"));
+    CHECK(openPageFile("testlog.bin", &fh));
+    memset(buf, 0, PAGE_SIZE);
+    memcpy(buf, "LOGPAGES", 8);
+    buf[8] = buf[12] = buf[16] = 1;
+    CHECK(writeBlock(0, &fh, buf));
+    CHECK(closePageFile(&fh));
+    fp = fopen("testlog.bin.seg0", "wb");
+    fclose(fp);
+    CHECK(openPageFile("testlog.bin", &fh));
+    ASSERT_TRUE(getPageFileLogStats(&fh, &stats) != RC_OK, "plain file not taken for a log");
+    CHECK(readBlock(0, &fh, buf));
+    ASSERT_TRUE(memcmp(buf, "LOGPAGES", 8) == 0, "plain page read in place");
+    CHECK(closePageFile(&fh));
+    CHECK(createPageFile("testlog.bin"));
+    CHECK(destroyPageFile("testlog.bin"));
+    fp = fopen("testlog.bin.seg0", "rb");
+    ASSERT_TRUE(fp != NULL, "unrelated file left alone");
+    fclose(fp);
+    remove("testlog.bin.seg0");
+
+    free(buf);
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
+
+// a shadow-paged page file shows other handles whole commits only, keeps a
+// handle's snapshot until it moves on, reuses the blocks of old commits and
+// is left with exactly the last commit after a crash, also through a pool
+void
+testShadowPaging (void)
+{
+    SM_FileHandle writer, reader;
+    SM_PageHandle pages[4];
+    char *buf = malloc(4 * PAGE_SIZE);
+    char *page = malloc(PAGE_SIZE);
+    char expect[32];
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    struct stat st;
+    pid_t child;
+    int status, rc, i, round;
+    testName = "shadow-paged page file";
+
+    CHECK(createShadowPageFile("testshadow.bin"));
+    CHECK(openPageFile("testshadow.bin", &writer));
+    ASSERT_EQUALS_INT(1, writer.totalNumPages, "new file has one page");
+    CHECK(ensureCapacity(4, &writer));
+    for (i = 0; i < 4; i++)
+    {
+        pages[i] = buf + i * PAGE_SIZE;
+        memset(pages[i], 0, PAGE_SIZE);
+        sprintf(pages[i], "page-%i-v1", i);
+    }
+    CHECK(writeBlocks(0, 4, &writer, pages));
+    CHECK(openPageFile("testshadow.bin", &reader));
+    ASSERT_EQUALS_INT(1, reader.totalNumPages, "uncommitted growth not visible");
+    CHECK(commitPageFile(&writer));
+    CHECK(commitPageFile(&reader));
+    ASSERT_EQUALS_INT(4, reader.totalNumPages, "reader moved to the commit");
+
+    // a batch is invisible to the reader while it runs and after it
+    // commits, until the reader moves on; then all of it shows
+    for (i = 0; i < 2; i++)
+        sprintf(pages[i], "page-%i-v2", i);
+    CHECK(writeBlocks(0, 2, &writer, pages));
+    CHECK(readBlock(0, &writer, page));
+    ASSERT_EQUALS_STRING("page-0-v2", page, "writer reads its own writes");
+    CHECK(readBlock(0, &reader, page));
+    ASSERT_EQUALS_STRING("page-0-v1", page, "uncommitted write not visible");
+    CHECK(commitPageFile(&writer));
+    CHECK(readBlock(1, &reader, page));
+    ASSERT_EQUALS_STRING("page-1-v1", page, "reader keeps its snapshot");
+    CHECK(commitPageFile(&reader));
+    for (i = 0; i < 2; i++)
+    {
+        sprintf(expect, "page-%i-v2", i);
+        CHECK(readBlock(i, &reader, page));
+        ASSERT_EQUALS_STRING(expect, page, "whole batch visible after moving on");
+    }
+
+    // an aborted write is dropped; of two batches over the same snapshot
+    // the second to commit conflicts and is dropped
+    sprintf(pages[3], "page-3-v9");
+    CHECK(writeBlock(3, &writer, pages[3]));
+    CHECK(abortPageFile(&writer));
+    CHECK(readBlock(3, &writer, page));
+    ASSERT_EQUALS_STRING("page-3-v1", page, "aborted write dropped");
+    sprintf(pages[2], "page-2-reader");
+    CHECK(writeBlock(2, &reader, pages[2]));
+    sprintf(pages[2], "page-2-v3");
+    CHECK(writeBlock(2, &writer, pages[2]));
+    CHECK(commitPageFile(&writer));
+    rc = commitPageFile(&reader);
+    ASSERT_EQUALS_INT(RC_COMMIT_CONFLICT, rc, "second commit conflicts");
+    CHECK(readBlock(2, &reader, page));
+    ASSERT_EQUALS_STRING("page-2-v3", page, "conflicting write dropped");
+    // closing commits too, and reports the conflict but still releases the handle
+    CHECK(writeBlock(2, &reader, pages[2]));
+    CHECK(writeBlock(1, &writer, pages[1]));
+    CHECK(commitPageFile(&writer));
+    rc = closePageFile(&reader);
+    ASSERT_EQUALS_INT(RC_COMMIT_CONFLICT, rc, "close reports the conflict");
+    ASSERT_TRUE(reader.mgmtInfo == NULL, "handle released after a failed close");
+
+    // with no older snapshot read, a commit frees the blocks it replaces
+    for (round = 0; round < 50; round++)
+    {
+        for (i = 0; i < 4; i++)
+            sprintf(pages[i], "page-%i-r%i", i, round);
+        CHECK(writeBlocks(0, 4, &writer, pages));
+        CHECK(commitPageFile(&writer));
+    }
+    CHECK(closePageFile(&writer));
+    stat("testshadow.bin", &st);
+    ASSERT_TRUE(st.st_size <= 20 * PAGE_SIZE, "blocks of old commits reused");
+
+    // a child forces a batch through a pool and commits it, then forces a
+    // second batch and dies before committing: only the first survives
+    fflush(stdout);
+    child = fork();
+    if (child == 0)
+    {
+        initBufferPool(bm, "testshadow.bin", 4, RS_LRU, NULL);
+        for (round = 1; round <= 2; round++)
+        {
+            for (i = 0; i < 4; i++)
+            {
+                pinPage(bm, h, i);
+                sprintf(h->data, "batch-%i-%i", round, i);
+                markDirty(bm, h);
+                forcePage(bm, h);
+                unpinPage(bm, h);
+            }
+            if (round == 1)
+                commitPool(bm);
+        }
+        _exit(0);
+    }
+    waitpid(child, &status, 0);
+    CHECK(openPageFile("testshadow.bin", &reader));
+    ASSERT_EQUALS_INT(4, reader.totalNumPages, "page count of the last commit");
+    for (i = 0; i < 4; i++)
+    {
+        sprintf(expect, "batch-1-%i", i);
+        CHECK(readBlock(i, &reader, page));
+        ASSERT_EQUALS_STRING(expect, page, "crash leaves the last commit");
+    }
+    CHECK(closePageFile(&reader));
+    CHECK(destroyPageFile("testshadow.bin"));
+    ASSERT_TRUE(stat("testshadow.bin.shadowstore", &st) != 0, "marker destroyed with the file");
+
+    // a plain page holding the shadow magic where a header would be does
+    // not make its file shadow-paged
+    CHECK(createPageFile("testshadow.bin"));
+    CHECK(openPageFile("testshadow.bin", &writer));
+    memset(page, 0, PAGE_SIZE);
+    memcpy(page + 512, "SHADOWPF", 8);
+    CHECK(writeBlock(0, &writer, page));
+    CHECK(closePageFile(&writer));
+    CHECK(openPageFile("testshadow.bin", &reader));
+    ASSERT_EQUALS_INT(1, reader.totalNumPages, "plain file opened as one");
+    CHECK(readBlock(0, &reader, page));
+    ASSERT_TRUE(memcmp(page + 512, "SHADOWPF", 8) == 0, "plain page read in place");
+    CHECK(closePageFile(&reader));
+    CHECK(destroyPageFile("testshadow.bin"));
+
+    free(buf);
+    free(page);
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
@@ -0,0 +1,132 @@
+// Tests for buffer_mgr_async.hpp: pins awaited from a C++20 coroutine
+#include "buffer_mgr_async.hpp"
+
+extern "C" {
+#include "storage_mgr.h"
+#include "dberror.h"
+}
+#include "test_helper.h"
+
+#include <exception>
+#include <pthread.h>
+#include <string.h>
+
+// var to store the current test's name
+char *testName;
+
+// the storage manager takes a non-const file name
+static char fileName[] = "testbuffer.bin";
+
+// Fire-and-forget coroutine: starts right away and frees its frame when done
+struct Task {
+    struct promise_type {
+        Task get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+// what a coroutine saw, reported back to the test thread
+struct AwaitResult {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int done;
+    RC awaitRc;
+    RC pinRc;
+    char data[16];
+};
+
+// Await a pin, then pin another page the blocking way from wherever the
+// coroutine was resumed, and report both
+static Task
+pinThenPin (BM_BufferPool *pool, PageNumber first, PageNumber second, AwaitResult *res)
+{
+    BM_PageHandle h, other;
+    RC rc = co_await bm::pinAwait(pool, &h, first);
+    res->awaitRc = rc;
+    if (rc == RC_OK)
+    {
+        strncpy(res->data, h.data, sizeof(res->data) - 1);
+        res->pinRc = pinPage(pool, &other, second);
+        if (res->pinRc == RC_OK)
+            unpinPage(pool, &other);
+        unpinPage(pool, &h);
+    }
+    pthread_mutex_lock(&res->lock);
+    res->done = 1;
+    pthread_cond_signal(&res->cond);
+    pthread_mutex_unlock(&res->lock);
+}
+
+static void
+awaitDone (AwaitResult *res)
+{
+    pthread_mutex_lock(&res->lock);
+    while (!res->done)
+        pthread_cond_wait(&res->cond, &res->lock);
+    pthread_mutex_unlock(&res->lock);
+}
+
+// a page file of num pages holding "Page-<n>"
+static void
+createPages (int num)
+{
+    SM_FileHandle fh;
+    char page[PAGE_SIZE];
+    TEST_CHECK(createPageFile(fileName));
+    TEST_CHECK(openPageFile(fileName, &fh));
+    for (int i = 0; i < num; i++)
+    {
+        memset(page, 0, PAGE_SIZE);
+        sprintf(page, "Page-%i", i);
+        TEST_CHECK(writeBlock(i, &fh, page));
+    }
+    TEST_CHECK(closePageFile(&fh));
+}
+
+// a miss resumes the coroutine off the I/O worker, so it may wait for a
+// miss of its own; a hit resumes it right away
+static void
+testAwaitPin (void)
+{
+    BM_BufferPool pool;
+    AwaitResult res;
+    testName = (char *) "Awaited pins";
+
+    pthread_mutex_init(&res.lock, NULL);
+    pthread_cond_init(&res.cond, NULL);
+    createPages(8);
+    TEST_CHECK(initBufferPool(&pool, fileName, 4, RS_CLOCK, NULL));
+
+    res.done = 0;
+    res.pinRc = RC_OK;
+    memset(res.data, 0, sizeof(res.data));
+    pinThenPin(&pool, 3, 7, &res);
+    awaitDone(&res);
+    ASSERT_EQUALS_INT(RC_OK, res.awaitRc, "awaited miss");
+    ASSERT_EQUALS_STRING("Page-3", res.data, "awaited page loaded");
+    ASSERT_EQUALS_INT(RC_OK, res.pinRc, "blocking miss after the resume");
+
+    res.done = 0;
+    memset(res.data, 0, sizeof(res.data));
+    pinThenPin(&pool, 7, 3, &res);
+    ASSERT_EQUALS_INT(1, res.done, "hit resumes without suspending");
+    ASSERT_EQUALS_STRING("Page-7", res.data, "awaited hit");
+    ASSERT_EQUALS_INT(2, getNumReadIO(&pool), "check number of read I/Os");
+
+    TEST_CHECK(shutdownBufferPool(&pool));
+    TEST_CHECK(destroyPageFile(fileName));
+    pthread_mutex_destroy(&res.lock);
+    pthread_cond_destroy(&res.cond);
+    TEST_DONE();
+}
+
+int
+main (void)
+{
+    testName = (char *) "";
+    testAwaitPin();
+    return 0;
+}